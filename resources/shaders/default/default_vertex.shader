@@ -4,30 +4,33 @@ layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec3 a_normal;
 layout(location = 2) in vec2 a_tex_coord;
 
+#ifdef INSTANCED
+layout(location = 3) in mat4 instanceMatrix;
+#define MODEL instanceMatrix
+#else
+uniform mat4 u_model;
+#define MODEL u_model
+#endif
+
 out VS_OUT {
     vec3 normal;
 } vs_out;
 
-layout (std140, binding=0) uniform Transforms
-{
-    // alignment offset
-    mat4 u_view;		// 0
-    mat4 u_projection;	// 64
-};
-uniform mat4 u_model;
-uniform mat4 u_light_proj;
+#include "../include/frame.glsl"
 
 out vec3 v_position;
 out vec3 v_normal;
 out vec2 v_tex_coord;
 out vec4 v_light_space_pos;
+out mat3 v_model; // only read by the uber shader
 
 void main()
 {
-    v_position = vec3(u_model * vec4(a_position, 1));
-    v_normal = transpose(inverse(mat3(u_model))) * a_normal;
+    v_position = vec3(MODEL * vec4(a_position, 1));
+    v_normal = transpose(inverse(mat3(MODEL))) * a_normal;
     vs_out.normal = v_normal;
     v_tex_coord = a_tex_coord;
-    v_light_space_pos = u_light_proj * vec4(v_position, 1);
-    gl_Position = u_projection * u_view * u_model * vec4(a_position, 1);
-}
\ No newline at end of file
+    v_model = mat3(MODEL);
+    v_light_space_pos = u_light_space_projection * u_light_space_view * vec4(v_position, 1);
+    gl_Position = u_projection * u_view * MODEL * vec4(a_position, 1);
+}
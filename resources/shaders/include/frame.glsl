@@ -0,0 +1,12 @@
+// per frame data, laid out like FrameData in FrameUniforms.h
+layout (std140, binding=0) uniform Frame
+{
+    // alignment offset
+    mat4 u_view;                      // 0
+    mat4 u_projection;                // 64
+    mat4 u_light_space_view;          // 128
+    mat4 u_light_space_projection;    // 192
+    vec3 u_cam_pos;                   // 256
+    float u_time;                     // 268
+    float u_delta_time;               // 272
+};
@@ -0,0 +1,76 @@
+// blinn-phong with the specular strength taken from the surface's metallic
+// the including shader declares the textures, inputs, frame.glsl, lights.glsl and surface.glsl first
+
+uniform int u_shininess = 2;
+
+Surface blinn_phong_surface(bool using_textures, vec4 colour)
+{
+    Surface s;
+    s.roughness = 0.f;
+
+    if (!using_textures)
+    {
+        s.base_colour = colour;
+        s.normal = v_normal;
+        s.metallic = 1.0;
+        s.ao = 0.5f;
+    }
+    else
+    {
+        s.base_colour = texture(diffuse_t, v_tex_coord);
+        s.metallic = texture(specular_t, v_tex_coord).r;
+        s.normal = v_model * texture(normal_t, v_tex_coord).rgb;
+        s.ao = texture(occlusion_t, v_tex_coord).r;
+    }
+
+    return s;
+}
+
+float blinn_phong_specular_factor(Surface s, vec3 n, vec3 h)
+{
+    return s.metallic * pow(max(dot(n, h), 0.0), u_shininess) * 0.1f;
+}
+
+vec4 blinn_phong_point_light(Surface s, int i)
+{
+    vec3 light_vec = point_lights[i].position - v_position;
+    float distance = length(light_vec);
+    vec3 l = normalize(light_vec);
+    vec3 v = normalize(u_cam_pos - v_position);
+    vec3 n = normalize(s.normal);
+    vec3 h = normalize(l + v);
+
+    if (distance > point_lights[i].range)
+    {
+        return vec4(0.f);
+    }
+
+    float attenuation = 1 / distance;
+
+    return vec4(point_lights[i].colour.xyz * attenuation * dot(l, n) * (s.base_colour.xyz + blinn_phong_specular_factor(s, n, h)), 1.f);
+}
+
+vec4 blinn_phong_direct_light(Surface s)
+{
+    vec3 l = normalize(directional_light.direction);
+    vec3 v = normalize(u_cam_pos - v_position);
+    vec3 n = normalize(s.normal);
+    vec3 h = normalize(l + v);
+
+    return vec4(directional_light.colour.xyz * dot(l, n) * (s.base_colour.xyz + blinn_phong_specular_factor(s, n, h)), 1.f);
+}
+
+vec4 shade_blinn_phong(Surface s)
+{
+    vec4 colour = vec4(0.f);
+
+    if (directional_light._active)
+        colour += blinn_phong_direct_light(s);
+
+    for (int i = 0; i < point_lights.length(); ++i)
+        colour += blinn_phong_point_light(s, i);
+
+    vec4 ambient = vec4(0.2f, 0.2f, 0.2f, 1.f) * s.base_colour * s.ao;
+
+    return colour + ambient;
+}
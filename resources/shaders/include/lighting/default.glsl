@@ -0,0 +1,127 @@
+// diffuse plus a blinn-phong highlight, with filtered shadows from the directional light
+// the including shader declares the textures, inputs, frame.glsl, lights.glsl and surface.glsl first
+
+Surface default_surface(bool using_textures, vec4 colour, float metallic)
+{
+    Surface s;
+    s.roughness = 0.f;
+    s.ao = 1.f;
+
+    if(!using_textures)
+    {
+        s.base_colour = colour;
+        s.metallic = metallic;
+        s.normal = normalize(v_normal);
+    }
+    else
+    {
+        s.base_colour = texture(diffuse_t, v_tex_coord);
+
+        if(textureSize(specular_t, 0).x > 1)
+            s.metallic = texture(specular_t, v_tex_coord).r;
+        else
+            s.metallic = metallic;
+
+        if(textureSize(normal_t, 0).x > 1)
+            s.normal = normalize(vec3(texture(normal_t, v_tex_coord)));
+        else
+            s.normal = normalize(v_normal);
+    }
+
+    return s;
+}
+
+bool default_out_of_frustrum(vec3 pos)
+{
+    return (pos.x < -1.f || pos.x > 1.f) || (pos.y < -1.f || pos.y > 1.f) || (pos.z < -1.f || pos.z > 1.f);
+}
+
+vec4 default_direct_light(Surface s)
+{
+    vec3 light_dir = normalize(directional_light.direction);
+    vec3 view_dir = normalize(u_cam_pos - v_position);
+
+    float ambient = 0.2f;
+    float diffuse = max(dot(s.normal, light_dir), 0.0f);
+
+    vec3 h = normalize(view_dir + light_dir);
+    float spec_amount = pow(max(dot(s.normal, h), 0.0f), 16);
+
+    vec3 light_pos = v_light_space_pos.xyz / v_light_space_pos.w;
+    float shadow = 0.f;
+    if(!default_out_of_frustrum(light_pos))
+    {
+        light_pos = (light_pos + 1.f) / 2.f;
+        float shadow_bias = max(0.0002f * (1.f - dot(s.normal, light_dir)), 0.0005f);
+
+        vec2 texel_size = 1.0 / textureSize(shadow_map, 0);
+
+        // sample all surrounding shadow values and take the average
+        for(int x = -1; x <= 1; ++x)
+        {
+            for(int y = -1; y <= 1; ++y)
+            {
+                float depth = texture(shadow_map, light_pos.xy + vec2(x, y) * texel_size).r;
+
+                if(light_pos.z - shadow_bias > depth)
+                    shadow += 1.f;
+            }
+        }
+        shadow /= 9.0;
+    }
+
+    return vec4(((s.base_colour.xyz * (diffuse * (1.f - shadow) + ambient)) + s.metallic * spec_amount * (1.f - shadow)) * directional_light.colour.xyz, 1.f);
+}
+
+vec4 default_point_light(Surface s, int i)
+{
+    vec3 light_vec = point_lights[i].position - v_position;
+    float distance = length(light_vec);
+    vec3 light_dir = normalize(light_vec);
+    vec3 view_dir = normalize(u_cam_pos - v_position);
+    vec3 h = normalize(view_dir + light_dir);
+
+    float shadow = 0.f;
+    if(point_lights[i].shadow_casting)
+    {
+        vec3 fragToLight = v_position - point_lights[i].position;
+        float closest_depth = texture(shadow_cubemaps[i], fragToLight).r;
+        closest_depth *= point_lights[i].shadow_far_plane;
+
+        float current_depth = length(fragToLight);
+        shadow = current_depth - point_lights[i].shadow_bias > closest_depth ? 1.0 : 0.0;
+    }
+
+//    if (distance > point_lights[i].range)
+//    {
+//        return vec4(0.f);
+//    }
+
+    float attenuation = (1 / distance) * point_lights[i].range * 0.5f;
+    float ambient = 0.1f;
+    float diffuse = max(dot(s.normal, light_dir), 0.0f);
+
+    // specular lighting
+    float specular = 0.0f;
+    if (diffuse != 0.0f)
+    {
+        specular = pow(max(dot(s.normal, h), 0.0f), 16) * 0.3f;
+    };
+
+    return vec4((s.base_colour.xyz * (diffuse * attenuation * (1.f - shadow) + ambient) + s.metallic * specular * attenuation * (1.f - shadow)), 1.f) * point_lights[i].colour;
+}
+
+vec4 shade_default(Surface s)
+{
+    vec4 colour = vec4(s.base_colour.xyz * 0.05f, 1.f);
+
+    if(directional_light._active)
+        colour += default_direct_light(s);
+
+    for (int i = 0; i < u_num_point_lights; ++i)
+    {
+        colour += default_point_light(s, i);
+    }
+
+    return colour;
+}
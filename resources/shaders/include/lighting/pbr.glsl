@@ -0,0 +1,139 @@
+// metallic-roughness with a cook-torrance specular
+// the including shader declares the textures, inputs, frame.glsl, lights.glsl and surface.glsl first
+
+const float pi = 3.14159265358f;
+
+Surface pbr_surface(bool using_textures, vec4 colour, float metallic, float roughness)
+{
+	Surface s;
+
+	if (!using_textures)
+	{
+		s.base_colour = colour;
+		s.normal = v_normal;
+		s.metallic = metallic;
+		s.roughness = roughness;
+		s.ao = 0.5f;
+	}
+	else
+	{
+		s.base_colour = texture(diffuse_t, v_tex_coord);
+		s.normal = v_model * texture(normal_t, v_tex_coord).rgb;
+		s.metallic = texture(specular_t, v_tex_coord).r;
+		s.roughness = texture(specular_t, v_tex_coord).g;
+		s.ao = texture(occlusion_t, v_tex_coord).r;
+	}
+
+	return s;
+}
+
+vec4 pbr_lambertian(Surface s)
+{
+	return s.base_colour / pi;
+}
+
+// Schlick
+vec4 pbr_fresnel(vec4 F0, vec3 h, vec3 v)
+{
+	float h_dot_v = max(dot(h, v), 0.0f);
+
+	return F0 + (1 - F0) * pow((1 - h_dot_v), 5);
+}
+
+// Trowbridge-Reitz
+float pbr_normal_distribution(float roughness, vec3 h, vec3 n)
+{
+	float alpha = roughness * roughness;
+	float h_dot_n = max(dot(h, n), 0.0f);
+	float alpha_sq = alpha * alpha;
+	float denom = pi * pow((pow(h_dot_n, 2) * (alpha_sq - 1) + 1), 2);
+
+	return alpha_sq / denom;
+}
+
+float pbr_G_Schlick(float roughness, vec3 n, vec3 v)
+{
+	float r = (roughness + 1.f);
+	float k = (r * r) / 8.f;
+
+	float n_dot_v = max(dot(n, v), 0.0f);
+
+	return n_dot_v / (n_dot_v * (1 - k) + k);
+}
+
+float pbr_G_Smith(float roughness, vec3 n, vec3 v, vec3 l)
+{
+	return pbr_G_Schlick(roughness, n, v) * pbr_G_Schlick(roughness, n, l);
+}
+
+// Cook-Torrance
+vec4 pbr_brdf(Surface s, vec4 F0, vec3 l, vec3 v, vec3 n, vec3 h)
+{
+	vec4 ks = pbr_fresnel(F0, h, v);
+	vec4 kd = vec4(1 - vec3(ks), 1.f);
+	kd *= (1 - s.metallic);
+
+	float D = pbr_normal_distribution(s.roughness, h, n);
+	float G = pbr_G_Smith(s.roughness, n, v, l);
+
+	float v_dot_n = max(dot(v, n), 0.000001f);
+	float l_dot_n = max(dot(l, n), 0.000001f);
+
+	vec4 specular = (ks * D * G) / (4 * v_dot_n * l_dot_n);
+
+	return kd * pbr_lambertian(s) + specular;
+}
+
+vec4 pbr_point_light(Surface s, vec4 F0, int i)
+{
+	vec3 light_vec = point_lights[i].position - v_position;
+	float distance = length(light_vec);
+	vec3 l = normalize(light_vec);
+	vec3 v = normalize(u_cam_pos - v_position);
+	vec3 n = normalize(s.normal);
+	vec3 h = normalize(l + v);
+
+	if (distance > point_lights[i].range)
+	{
+		return vec4(0.f);
+	}
+
+	vec4 brdf = pbr_brdf(s, F0, l, v, n, h);
+
+	float h_dot_n = max(dot(h, n), 0.0f);
+
+	float attenuation = 1 / distance;
+
+	return  brdf * attenuation * point_lights[i].colour * h_dot_n * point_lights[i].brightness;
+}
+
+vec4 pbr_direct_light(Surface s, vec4 F0)
+{
+	vec3 l = normalize(-directional_light.direction);
+	vec3 v = normalize(u_cam_pos - v_position);
+	vec3 n = normalize(s.normal); // TODO: will need to change once non uniform scaling is implemented
+	vec3 h = normalize(l + v);
+
+	vec4 brdf = pbr_brdf(s, F0, l, v, n, h);
+
+	float h_dot_n = max(dot(h, n), 0.0f);
+
+	return  brdf * directional_light.colour * h_dot_n * directional_light.brightness;
+}
+
+vec4 shade_pbr(Surface s)
+{
+	vec4 F0 = mix(vec4(vec3(0.04f), 1.0f), s.base_colour, s.metallic);
+
+	vec4 colour = vec4(0.f);
+
+	if (directional_light._active)
+		colour += pbr_direct_light(s, F0);
+
+	for (int i = 0; i < point_lights.length(); ++i)
+		colour += pbr_point_light(s, F0, i);
+
+	vec4 ambient = vec4(0.2f, 0.2f, 0.2f, 1.f) * s.base_colour * s.ao;
+
+	return colour + ambient;
+}
@@ -0,0 +1,38 @@
+// laid out like PointLightData and DirectLightData in LightManager.cpp
+// needs GL_ARB_bindless_texture enabled by the including shader for the shadow map handles
+struct DirectionalLight
+{
+    bool _active;
+    vec4 colour;
+    vec3 direction;
+    float brightness;
+};
+
+struct PointLight
+{
+    vec4 colour;
+    vec3 position;
+    float range;
+    float brightness;
+    bool shadow_casting;
+    float shadow_far_plane;
+    float shadow_bias;
+};
+
+uniform int u_num_point_lights;
+
+layout (std430, binding=1) buffer PointLights
+{
+    PointLight point_lights[];
+};
+
+layout (std430, binding=2) buffer DirectLight
+{
+    DirectionalLight directional_light;
+    sampler2D shadow_map;
+};
+
+layout (std430, binding=3) buffer PointShadowMaps
+{
+    samplerCube shadow_cubemaps[];
+};
@@ -0,0 +1,20 @@
+// laid out like MaterialData in Material.h, filled by the renderer while the uber shader is on
+const uint LIGHTING_DEFAULT = 0u;
+const uint LIGHTING_PBR = 1u;
+const uint LIGHTING_BLINN_PHONG = 2u;
+
+struct MaterialData
+{
+    vec4 colour;
+    float metallic;
+    float roughness;
+    uint lighting_model;
+    bool using_textures;
+};
+
+layout (std430, binding=4) buffer Materials
+{
+    MaterialData materials[];
+};
+
+uniform int u_material_index;
@@ -0,0 +1,7 @@
+// one point light's shadow views, laid out like ShadowViewData in FrameUniforms.h
+layout (std140, binding=2) uniform ShadowView
+{
+    mat4 u_shadow_transforms[6];   // 0
+    vec3 u_light_pos;              // 384
+    float u_far_plane;             // 396
+};
@@ -0,0 +1,10 @@
+// what the lighting models need to know about the point being shaded
+// metallic is the specular strength for the models that don't have a metallic term
+struct Surface
+{
+    vec4 base_colour;
+    vec3 normal;
+    float metallic;
+    float roughness;
+    float ao;
+};
@@ -4,12 +4,7 @@ layout(location = 0) in vec3 a_position;
 layout(location = 1) in vec3 a_normal;
 layout(location = 2) in vec2 a_tex_coord;
 
-layout (std140, binding=0) uniform Transforms
-{
-						// alignment offset
-	mat4 u_view;		// 0
-	mat4 u_projection;	// 64
-};
+#include "../include/frame.glsl"
 uniform mat4 u_model;
 
 out vec3 v_position;
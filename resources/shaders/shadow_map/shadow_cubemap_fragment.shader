@@ -2,8 +2,7 @@
 
 in vec4 frag_pos;
 
-uniform vec3 u_light_pos;
-uniform float u_far_plane;
+#include "../include/shadow_view.glsl"
 
 void main()
 {
@@ -2,7 +2,7 @@
 layout (triangles) in;
 layout (triangle_strip, max_vertices=18) out;
 
-uniform mat4 u_shadow_transforms[6];
+#include "../include/shadow_view.glsl"
 
 out vec4 frag_pos;
 
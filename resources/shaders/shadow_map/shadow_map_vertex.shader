@@ -2,11 +2,17 @@
 
 layout(location = 0) in vec3 a_position;
 
+#ifdef INSTANCED
+layout(location = 3) in mat4 instanceMatrix;
+#define MODEL instanceMatrix
+#else
 uniform mat4 u_model;
-uniform mat4 u_light_space_view;
-uniform mat4 u_light_space_projection;
+#define MODEL u_model
+#endif
+
+#include "../include/frame.glsl"
 
 void main()
 {
-    gl_Position = u_light_space_projection * u_light_space_view * u_model * vec4(a_position, 1.0);
-}
\ No newline at end of file
+    gl_Position = u_light_space_projection * u_light_space_view * MODEL * vec4(a_position, 1.0);
+}
@@ -2,12 +2,7 @@
 
 layout(location = 0) in vec3 a_position;
 
-layout (std140, binding=0) uniform Transforms
-{
-	// alignment offset
-	mat4 u_view;		// 0
-	mat4 u_projection;	// 64
-};
+#include "../include/frame.glsl"
 
 out vec3 v_tex_coords;
 
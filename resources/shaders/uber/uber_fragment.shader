@@ -0,0 +1,63 @@
+#version 460
+
+#extension GL_ARB_bindless_texture : require
+
+// every lighting model in one program, the material picks which one runs so draws don't have to switch programs
+
+/*----------Textures----------*/
+layout (binding = 0) uniform sampler2D diffuse_t;
+layout (binding = 1) uniform sampler2D specular_t;
+layout (binding = 2) uniform sampler2D normal_t;
+layout (binding = 3) uniform sampler2D occlusion_t;
+
+in vec3 v_position;
+in vec3 v_normal;
+in vec2 v_tex_coord;
+in vec4 v_light_space_pos;
+in mat3 v_model;
+
+#include "../include/frame.glsl"
+#include "../include/materials.glsl"
+
+/*----------Lighting----------*/
+#include "../include/lights.glsl"
+#include "../include/surface.glsl"
+#include "../include/lighting/default.glsl"
+#include "../include/lighting/pbr.glsl"
+#include "../include/lighting/blinn_phong.glsl"
+
+out vec4 colour;
+
+void main()
+{
+    MaterialData material = materials[u_material_index];
+
+    switch (material.lighting_model)
+    {
+        case LIGHTING_PBR:
+        {
+            Surface s = pbr_surface(material.using_textures, material.colour, material.metallic, material.roughness);
+            if (s.base_colour.a < 0.01f)
+                discard;
+
+            colour = shade_pbr(s);
+            break;
+        }
+
+        case LIGHTING_BLINN_PHONG:
+        {
+            Surface s = blinn_phong_surface(material.using_textures, material.colour);
+            if (s.base_colour.a < 0.01f)
+                discard;
+
+            colour = shade_blinn_phong(s);
+            break;
+        }
+
+        default:
+        {
+            colour = shade_default(default_surface(material.using_textures, material.colour, material.metallic));
+            break;
+        }
+    }
+}
@@ -3,6 +3,17 @@
 #include "Input.h"
 #include "Timer.h"
 #include "Log.h"
+#include "AssetCache.h"
+#include "FileSystem.h"
+#include "ThreadPool.h"
+#include "Prefab.h"
+#include "renderer/AsyncLoader.h"
+#include "renderer/GLState.h"
+#include "renderer/ProgramCache.h"
+#include "renderer/Shader.h"
+#include "renderer/Texture.h"
+#include "renderer/ResidencyManager.h"
+#include "renderer/TextureStreamer.h"
 
 #include <imgui.h>
 
@@ -13,7 +24,18 @@ void Application::start()
     {
         info("Beginning startup process...\n");
         Timer t;
-        currentScene->load("../resources/scenes/test.scene");
+        // lets the relative resource paths work no matter where the editor is started from
+        FileSystem::add_search_path(FileSystem::get_executable_dir());
+        // packed copies take the place of the loose files when they are there
+        FileSystem::mount_archive("../resources.tbpak", "../resources");
+        FileSystem::mount_archive("../cooked.tbpak", "../cooked");
+        AssetCache::mount("../cooked/");
+        // linked shaders are driver specific so they are kept apart from the cooked assets
+        ProgramCache::set_directory("../cache/programs");
+        AsyncLoader::set_enabled(true);
+        TextureStreamer::set_enabled(true);
+        m_scene_path = "../resources/scenes/test.scene";
+        currentScene->load(m_scene_path.c_str());
         currentScene->init();
         auto [width, height] = m_window.get_dimensions();
         Renderer::init(width, height);
@@ -27,9 +49,17 @@ void Application::start()
 			continue;
 		}
 
-        if(Input::is_key_pressed(GLFW_KEY_C))
+        // runs between frames so nothing is left holding on to the scene
+        if (m_run_scale_benchmark)
         {
-            Scene::recompile_shaders();
+            m_run_scale_benchmark = false;
+            run_scale_benchmark();
+        }
+
+        if (m_run_uber_shader_benchmark)
+        {
+            m_run_uber_shader_benchmark = false;
+            m_uber_shader_benchmark = ::run_uber_shader_benchmark(*currentScene);
         }
 
 		m_window.begin_frame();
@@ -38,6 +68,10 @@ void Application::start()
 
 		float delta_time = m_window.get_delta_time();
         inspector.render();
+        ShaderTable::update();
+        AsyncLoader::process_uploads();
+        TextureStreamer::update();
+        ResidencyManager::update();
         currentScene->update(delta_time);
 
 		//ImGui::ShowDemoWindow();
@@ -55,7 +89,9 @@ void Application::switch_scene(const char* scene_path)
 {
     info("Switching scene...\n");
     Timer t;
+    AsyncLoader::cancel_all();
     delete currentScene;
+    m_scene_path = scene_path;
     currentScene = new Scene(&m_window);
     currentScene->load(scene_path);
     currentScene->init();
@@ -64,9 +100,29 @@ void Application::switch_scene(const char* scene_path)
 
 void Application::shutdown()
 {
+    // workers can't be left decoding into objects that are about to go away
+    AsyncLoader::cancel_all();
+    ThreadPool::get().wait_idle();
     delete currentScene;
 }
 
+void Application::run_scale_benchmark()
+{
+    info("Running scale benchmark...\n");
+
+    // the stress scenes need the shared tables to themselves
+    AsyncLoader::cancel_all();
+    ThreadPool::get().wait_idle();
+    delete currentScene;
+    currentScene = nullptr;
+
+    m_benchmark_results = ::run_scale_benchmark(&m_window, { 1000, 10000, 100000, 1000000 }, StressSceneSettings{});
+
+    // copied since switch_scene overwrites it
+    std::string scene_path = m_scene_path;
+    switch_scene(scene_path.c_str());
+}
+
 void Application::display_dockspace()
 {
 	static ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDocking | ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoNavFocus;
@@ -115,7 +171,28 @@ void Application::display_menu()
 				ImGui::EndMenu();
 			}
 			
-			if (ImGui::BeginMenu("Save"))
+			if (ImGui::MenuItem("Scale Benchmark"))
+			{
+				m_run_scale_benchmark = true;
+			}
+
+			if (ImGui::MenuItem("Uniform Benchmark"))
+			{
+				m_uniform_benchmark = ::run_uniform_benchmark(100000);
+			}
+
+			if (ImGui::MenuItem("Uber Shader Benchmark"))
+			{
+				m_run_uber_shader_benchmark = true;
+			}
+
+			// only journals what changed, the scene file itself is rewritten when the journal gets folded in
+			if (ImGui::MenuItem("Save", nullptr, false, currentScene->get_journal().is_enabled()))
+			{
+				currentScene->save_incremental();
+			}
+
+			if (ImGui::BeginMenu("Save As"))
 			{
 				static char buf[32] = R"(test.scene)";
 				ImGui::Text("resources/scenes/");
@@ -161,6 +238,18 @@ void Application::display_menu()
                 }
                 ImGui::EndMenu();
             }
+
+            if (ImGui::BeginMenu("Prefab", !PrefabTable::get_prefabs().empty()))
+            {
+                for (const auto& [name, prefab] : PrefabTable::get_prefabs())
+                {
+                    if (ImGui::MenuItem(name.c_str()))
+                    {
+                        currentScene->place_prefab(name);
+                    }
+                }
+                ImGui::EndMenu();
+            }
 			ImGui::EndMenu();
 		}
 
@@ -171,6 +260,11 @@ void Application::display_menu()
 				display_bg_col_picker = true;
 			}
 
+            if(ImGui::MenuItem("Uber Shader", nullptr, Renderer::is_using_uber_shader()))
+            {
+                Renderer::set_uber_shader(!Renderer::is_using_uber_shader());
+            }
+
             if(ImGui::MenuItem("V-Sync Toggle"))
             {
                 m_window.toggle_vsync();
@@ -226,6 +320,46 @@ void Application::display_fps()
 {
 	ImGui::Begin("FPS");
 	ImGui::Text("Avg. %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+
+    ImGui::Text("%zu textures loaded", TextureTable::get_num_loaded());
+
+    if (AsyncLoader::get_num_pending() > 0)
+        ImGui::Text("Streaming %zu assets", AsyncLoader::get_num_pending());
+
+    ImGui::Text("%zu textures streaming mips, %zu levels streamed, %zu trimmed", TextureStreamer::get_num_streaming(), TextureStreamer::get_num_levels_streamed(), TextureStreamer::get_num_trimmed());
+
+    constexpr float MB = 1024.f * 1024.f;
+    float budget_mb = (float)ResidencyManager::get_budget() / MB;
+    ImGui::Text("Texture memory %.1f / %.1f MB", (float)ResidencyManager::get_usage() / MB, budget_mb);
+    ImGui::Text("%zu evictions, %zu reloads", ResidencyManager::get_num_evictions(), ResidencyManager::get_num_reloads());
+    if (ImGui::DragFloat("Budget (MB)", &budget_mb, 1.f, 16.f, 8192.f, "%.0f"))
+        ResidencyManager::set_budget((uint64_t)(budget_mb * MB));
+
+    bool autosave = currentScene->is_autosave_enabled();
+    if (ImGui::Checkbox("Autosave", &autosave))
+        currentScene->set_autosave(autosave);
+
+    const SceneJournal& journal = currentScene->get_journal();
+    if (journal.is_enabled())
+        ImGui::Text("Last autosave %.3f ms, journal %.1f KB, %zu compactions", journal.get_last_save_time(), (float)journal.get_journal_size() / 1024.f, journal.get_num_compactions());
+
+    ImGui::Text("%zu uniforms set, %zu unchanged ones skipped", ShaderProgram::get_num_uniform_sets(), ShaderProgram::get_num_uniform_skips());
+    if (ShaderTable::get_num_pending() > 0)
+        ImGui::Text("Compiling %zu shader programs", ShaderTable::get_num_pending());
+    ImGui::Text("%zu state changes issued, %zu redundant ones skipped last frame", GLState::get_num_issued(), GLState::get_num_skipped());
+    ImGui::Text("%zu program switches last frame", GLState::get_num_program_switches());
+
+    if (m_uniform_benchmark)
+        ImGui::Text("Uniforms for %u draws: bind and lookup %.2f ms, by name %.2f ms, handles %.2f ms, unchanged %.2f ms", m_uniform_benchmark->num_draws,
+                    m_uniform_benchmark->bind_and_lookup_ms, m_uniform_benchmark->by_name_ms, m_uniform_benchmark->handle_ms, m_uniform_benchmark->handle_unchanged_ms);
+
+    if (m_uber_shader_benchmark)
+        ImGui::Text("Specialised programs %.3f ms/frame, %zu switches; uber program %.3f ms/frame, %zu switches", m_uber_shader_benchmark->specialised_ms,
+                    m_uber_shader_benchmark->specialised_switches, m_uber_shader_benchmark->uber_ms, m_uber_shader_benchmark->uber_switches);
+
+    for (const ScaleBenchmarkResult& result : m_benchmark_results)
+        ImGui::Text("%u nodes: load %.1f ms, update %.3f ms, %.0f bytes/node", result.num_nodes, result.load_ms, result.update_ms, result.bytes_per_node);
+
 	ImGui::End();
 }
 
@@ -3,6 +3,9 @@
 #include "Window.h"
 #include "Scene.h"
 #include "Inspector.h"
+#include "SceneBenchmark.h"
+
+#include <optional>
 
 class Application
 {
@@ -20,7 +23,8 @@ public:
 private:
 	void display_dockspace();
 	void display_menu();
-	static void display_fps();
+	void display_fps();
+	void run_scale_benchmark();
 
     Scene* currentScene;
     Window m_window;
@@ -28,5 +32,12 @@ private:
 
 	bool m_running = false;
 	bool m_show_dock_space = true;
+
+    std::string m_scene_path;
+    bool m_run_scale_benchmark = false;
+    std::vector<ScaleBenchmarkResult> m_benchmark_results;
+    std::optional<UniformBenchmarkResult> m_uniform_benchmark;
+    bool m_run_uber_shader_benchmark = false;
+    std::optional<UberShaderBenchmarkResult> m_uber_shader_benchmark;
 };
 
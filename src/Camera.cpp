@@ -8,6 +8,7 @@
 #include <glm/gtx/rotate_vector.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include <imgui.h>
+#include <limits>
 
 glm::mat4 Camera::camera_look_at()
 {
@@ -32,6 +33,18 @@ void Camera::resize(int width, int height)
 	);
 }
 
+float Camera::get_screen_size(const glm::vec3& centre, float radius) const
+{
+    float distance = glm::length(centre - m_position);
+    if (distance <= radius)
+        return std::numeric_limits<float>::max();
+
+    float aspect_ratio = (float)m_screen_width / (float)m_screen_height;
+    float fov_y = atanf(tanf(glm::radians(m_fov/2)) / aspect_ratio) * 2;
+
+    return radius / (distance * tanf(fov_y / 2)) * (float)m_screen_height;
+}
+
 bool Camera::update(float elapsed_time)
 {
 	// block camera update if imgui menu is in use
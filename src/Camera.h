@@ -44,6 +44,9 @@ public:
 	inline const glm::mat4& get_perspective() { return m_perspective; }
 	inline const glm::mat4& get_orthographic() { return m_orthographic; }
 
+	// roughly how many pixels tall a sphere shows up on screen
+	[[nodiscard]] float get_screen_size(const glm::vec3& centre, float radius) const;
+
 	void resize(int width, int height);
 	void reset();
 
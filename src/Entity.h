@@ -8,9 +8,88 @@
 class Entity
 {
 public:
-	virtual void set_name(const std::string& name) { m_name = name; }
+	virtual void set_name(const std::string& name) { m_name = name; m_dirty = true; }
 	[[nodiscard]] const std::string& get_name() const { return m_name; }
 
+	// stays the same across saves so incremental saves can refer to the entity, 0 means it hasn't been given one yet
+	void set_id(uint32_t id) { m_id = id; }
+	[[nodiscard]] uint32_t get_id() const { return m_id; }
+
+	// set whenever something that gets saved changes, cleared once the change is on disk
+	void mark_dirty() { m_dirty = true; }
+	void clear_dirty() { m_dirty = false; }
+	[[nodiscard]] bool is_dirty() const { return m_dirty; }
+
+	// every node of a placed prefab remembers which template node it came from and the id of the instance's top node
+	void set_prefab(const std::string& prefab, uint32_t node, uint32_t instance, std::shared_ptr<const Entity> source)
+	{
+		m_prefab = prefab;
+		m_prefab_node = node;
+		m_prefab_instance = instance;
+		m_prefab_source = std::move(source);
+	}
+
+	[[nodiscard]] bool is_prefab() const { return !m_prefab.empty(); }
+	[[nodiscard]] const std::string& get_prefab() const { return m_prefab; }
+	[[nodiscard]] uint32_t get_prefab_node() const { return m_prefab_node; }
+	[[nodiscard]] uint32_t get_prefab_instance() const { return m_prefab_instance; }
+
+	// gives every shared component its own copy and forgets the prefab
+	void unlink_prefab()
+	{
+		for (auto& component : m_components)
+		{
+			if (is_shared(*component))
+				component = component->clone();
+		}
+
+		m_prefab.clear();
+		m_prefab_source = nullptr;
+		m_dirty = true;
+	}
+
+	// true while the component is still the prefab's own and has to be copied before anything writes to it
+	[[nodiscard]] bool is_shared(const Component& component) const
+	{
+		if (!m_prefab_source)
+			return false;
+
+		auto it = m_prefab_source->m_type_map.find(component.get_type());
+		return it != m_prefab_source->m_type_map.end() && m_prefab_source->m_components[it->second].get() == &component;
+	}
+
+	// adds the component without copying it, used to hand out a prefab's components
+	void share_component(const std::shared_ptr<Component>& component)
+	{
+		if (m_type_map.find(component->get_type()) == m_type_map.end())
+		{
+			m_components.push_back(component);
+			m_type_map[component->get_type()] = m_components.size() - 1;
+		}
+	}
+
+	void replace_component(std::shared_ptr<Component> component)
+	{
+		auto it = m_type_map.find(component->get_type());
+		if (it != m_type_map.end())
+		{
+			m_components[it->second] = std::move(component);
+			m_dirty = true;
+		}
+	}
+
+	// the component for writing to, copied first if it is still shared with a prefab
+	template<class T>
+	T& edit_component()
+	{
+		T& component = get_component<T>();
+		if (!is_shared(component))
+			return component;
+
+		replace_component(component.clone());
+		return get_component<T>();
+	}
+
 	template<class T>
 	void add_component(T&& component)
 	{
@@ -19,6 +98,7 @@ public:
 		{
 			m_components.emplace_back(std::make_shared<T>(std::forward<T>(component)));
 			m_type_map[type_hash] = m_components.size() - 1;
+			m_dirty = true;
 		}
 	}
 
@@ -41,6 +121,8 @@ public:
 					}
 				}
 
+				m_dirty = true;
+
 				return true;
 			}
 		}
@@ -75,6 +157,13 @@ protected:
 	}
 
 	std::string m_name;
+	uint32_t m_id = 0;
+	bool m_dirty = true;
+
+	std::string m_prefab;
+	uint32_t m_prefab_node = 0;
+	uint32_t m_prefab_instance = 0;
+	std::shared_ptr<const Entity> m_prefab_source;
 	std::unordered_map<size_t, size_t> m_type_map;
 	std::vector<std::shared_ptr<Component>> m_components;
 };
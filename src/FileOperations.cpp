@@ -1,21 +1,13 @@
 #include "pch.h"
 #include "FileOperations.h"
+#include "FileSystem.h"
 
 std::string file_to_string(const char* file_path)
 {
-	std::string line;
-	std::ifstream stream(file_path);
+	std::string src;
+	FileSystem::read(file_path, src);
 
-	std::stringstream ss;
-
-	while (getline(stream, line))
-	{
-		ss << line << "\n";
-	}
-
-	stream.close();
-
-	return ss.str();
+	return src;
 }
 
 void write_to_file(const char* file_path, const std::string& src)
@@ -1,6 +1,6 @@
 #include "pch.h"
 #include "GLTFLoader.h"
-#include "FileOperations.h"
+#include "FileSystem.h"
 #include "Log.h"
 
 int get_num_verts(const std::string& type)
@@ -24,9 +24,14 @@ GLTFLoader::GLTFLoader(const char* path)
 
 void GLTFLoader::read_file(const char* path)
 {
-    std::string src = file_to_string(path);
+    FileView src = FileSystem::map(path);
+    if (!src)
+    {
+        error("Could not read {}\n", path);
+        return;
+    }
 
-    m_json = json::parse(src);
+    m_json = json::parse(src.begin(), src.end());
 
     std::string uri = m_json["buffers"][0]["uri"];
 
@@ -227,18 +232,8 @@ std::string GLTFLoader::get_occlusion_texture() const
 
 void GLTFLoader::load_bin(const char* file_path)
 {
-	// open file
-	std::streampos file_size;
-	std::ifstream file(file_path, std::ios::binary);
-
-	// get size
-	file.seekg(0, std::ios::end);
-	file_size = file.tellg();
-	file.seekg(0, std::ios::beg);
-
-	// read data
-	m_data.assign(file_size, 0);
-	file.read((char*)&m_data[0], file_size);
+	if (!FileSystem::read(file_path, m_data))
+		error("Could not read {}\n", file_path);
 }
 
 void GLTFLoader::extract_floats(const json& accessor, std::vector<float>& flts) const
@@ -47,6 +47,11 @@ void Inspector::render()
 
     if (dragNode && dropNode)
     {
+        // moving a node out of a prefab instance or into one changes its shape
+        if (dragNode->entity()->is_prefab() && dragNode->entity()->get_prefab_node() != 0)
+            scene->unpack_prefab(dragNode);
+        scene->unpack_prefab(dropNode);
+
         dropNode->move_child(dragNode);
         scene->selectedNode = nullptr;
         dragNode = nullptr;
@@ -74,6 +79,16 @@ void Inspector::imguiRender(SceneNodePtr& currentNode)
             scene->m_nodes_to_remove.push(currentNode);
         }
 
+        if (ImGui::MenuItem("Make Prefab", nullptr, false, !currentNode->entity()->is_prefab()))
+        {
+            scene->make_prefab(currentNode);
+        }
+
+        if (ImGui::MenuItem("Unpack Prefab", nullptr, false, currentNode->entity()->is_prefab()))
+        {
+            scene->unpack_prefab(currentNode);
+        }
+
         if (ImGui::BeginMenu("Add Component"))
         {
             if (ImGui::MenuItem("Point Light"))
@@ -158,9 +173,26 @@ void Inspector::displayComponents()
                 scene->selectedNode->entity()->remove_component(*component);
             }
 
-            component->imgui_render();
+            // components shared with a prefab are edited on a copy that only replaces the shared one once something changes
+            if (scene->selectedNode->entity()->is_shared(*component))
+            {
+                std::shared_ptr<Component> copy = component->clone();
+                copy->imgui_render();
+
+                if (GImGui->ActiveIdHasBeenEditedThisFrame)
+                    scene->selectedNode->entity()->replace_component(copy);
+            }
+            else
+            {
+                component->imgui_render();
+            }
+
             ImGui::TreePop();
         }
     }
+
+    // whatever widget changed a value this frame belongs to one of the selected entity's components
+    if (GImGui->ActiveIdHasBeenEditedThisFrame)
+        scene->selectedNode->entity()->mark_dirty();
 }
 
@@ -1,11 +1,12 @@
 #include "ModelLoader.h"
+#include "MeshData.h"
+#include "AssetCache.h"
+#include "AssimpIO.h"
 
+// the model file is only parsed once something actually needs it, cooked meshes skip it entirely
 ModelLoader::ModelLoader(const char* file_path) :
-    m_scene(m_importer.ReadFile(file_path,
-                               aiProcess_CalcTangentSpace       |
-                               aiProcess_Triangulate            |
-                               aiProcess_JoinIdenticalVertices  |
-                               aiProcess_SortByPType)),
+    m_scene(nullptr),
+    m_file_path(file_path),
    m_primitive_type(PrimitiveTypes::None)
 {
     std::string path(file_path);
@@ -23,12 +24,20 @@ ModelLoader::ModelLoader(PrimitiveTypes primitive_type) :
 
 void ModelLoader::load_mesh(Mesh& mesh)
 {
-    if(m_scene)
+    if(m_primitive_type == PrimitiveTypes::None)
     {
-        std::vector<float> vertices = get_vertices(m_scene->mMeshes[0]);
-        std::vector<unsigned> indices = get_indices(m_scene->mMeshes[0]);
+        MeshData mesh_data;
+        std::string cooked_path = AssetCache::find(m_file_path);
 
-        mesh.load(vertices, indices);
+        if(!cooked_path.empty() && read_cooked_mesh(cooked_path, mesh_data))
+        {
+            mesh.load(mesh_data.vertices, mesh_data.indices);
+        }
+        else if(get_scene())
+        {
+            mesh_data = mesh_data_from_assimp(m_scene->mMeshes[0]);
+            mesh.load(mesh_data.vertices, mesh_data.indices);
+        }
     }
     else
     {
@@ -52,70 +61,54 @@ void ModelLoader::load_mesh(Mesh& mesh)
 
 void ModelLoader::load_material(Material& material)
 {
-
-    aiString diffuse_texture_path, specular_texture_path, normal_texture_path, occlusion_texture_path;
-    m_scene->mMaterials[0]->GetTexture(aiTextureType_DIFFUSE, 0, &diffuse_texture_path);
-
-    // don't bother to check other textures if no base colour is found
-    if (diffuse_texture_path.length == 0)
-    {
-        std::string textures[] = {
-                "../resources/textures/white_on_white.jpeg",
-                "none",
-                "none",
-                "none"
-        };
-        material.load(textures);
-        return;
-    }
-
-    m_scene->mMaterials[0]->GetTexture(aiTextureType_SPECULAR, 0, &specular_texture_path);
-    m_scene->mMaterials[0]->GetTexture(aiTextureType_NORMALS, 0, &normal_texture_path);
-    m_scene->mMaterials[0]->GetTexture(aiTextureType_AMBIENT, 0, &occlusion_texture_path);
-
     std::string textures[4];
-
-    textures[0] = m_base_dir + diffuse_texture_path.C_Str();
-    textures[1] = (specular_texture_path.length > 0) ? m_base_dir + specular_texture_path.C_Str() : "none";
-    textures[2] = (normal_texture_path.length > 0) ? m_base_dir + normal_texture_path.C_Str() : "none";
-    textures[3] = (occlusion_texture_path.length > 0) ? m_base_dir + occlusion_texture_path.C_Str() : "none";
-
+    get_texture_paths(textures);
     material.load(textures);
 }
 
-std::vector<float> ModelLoader::get_vertices(aiMesh* mesh)
+// doesn't touch GL so it is safe to call from a worker thread
+void ModelLoader::get_texture_paths(std::string textures[4])
 {
-    std::vector<float> vertices;
-    for(int i = 0; i < mesh->mNumVertices; ++i)
+    // the cooked mesh carries the paths so the model file is never imported just for them
+    std::string material_textures[4];
+    std::string cooked_path = AssetCache::find(m_file_path);
+    if(cooked_path.empty() || !read_cooked_mesh_textures(cooked_path, material_textures))
+        material_textures_from_assimp(get_scene(), material_textures);
+
+    // don't bother with the other textures if no base colour is found, a model that failed to import ends up here too
+    if (material_textures[0].empty())
     {
-        vertices.push_back(mesh->mVertices[i].x);
-        vertices.push_back(mesh->mVertices[i].y);
-        vertices.push_back(mesh->mVertices[i].z);
-        vertices.push_back(mesh->mNormals[i].x);
-        vertices.push_back(mesh->mNormals[i].y);
-        vertices.push_back(mesh->mNormals[i].z);
-        vertices.push_back(mesh->mTextureCoords[0][i].x);
-        vertices.push_back(mesh->mTextureCoords[0][i].y);
+        textures[0] = "../resources/textures/white_on_white.jpeg";
+        textures[1] = "none";
+        textures[2] = "none";
+        textures[3] = "none";
+        return;
     }
 
-    return vertices;
+    textures[0] = m_base_dir + material_textures[0];
+    for (int i = 1; i < 4; ++i)
+        textures[i] = material_textures[i].empty() ? "none" : m_base_dir + material_textures[i];
 }
 
-std::vector<unsigned> ModelLoader::get_indices(aiMesh* mesh)
+const aiScene* ModelLoader::get_scene()
 {
-    std::vector<unsigned> indices;
-    for(int i = 0; i < mesh->mNumFaces; ++i)
+    if(!m_scene && !m_file_path.empty())
     {
-        for(int j = 0; j < mesh->mFaces[i].mNumIndices; ++j)
-        {
-            indices.push_back(mesh->mFaces[i].mIndices[j]);
-        }
+        m_importer.SetIOHandler(new AssimpIOSystem);
+        m_scene = m_importer.ReadFile(m_file_path,
+                                      aiProcess_CalcTangentSpace       |
+                                      aiProcess_Triangulate            |
+                                      aiProcess_JoinIdenticalVertices  |
+                                      aiProcess_SortByPType);
     }
 
-    return indices;
+    return m_scene;
 }
 
 const char* ModelLoader::get_name()
 {
+    if (!get_scene() || m_scene->mNumMeshes == 0)
+        return "";
+
     return m_scene->mMeshes[0]->mName.C_Str();
 }
\ No newline at end of file
@@ -15,14 +15,15 @@ public:
     explicit ModelLoader(PrimitiveTypes primitive_type);
     void load_mesh(Mesh& mesh);
     void load_material(Material& material);
+    void get_texture_paths(std::string textures[4]);
     const char* get_name();
 
 private:
-    static std::vector<float> get_vertices(aiMesh* mesh);
-    static std::vector<unsigned> get_indices(aiMesh* mesh);
+    const aiScene* get_scene();
 
     Assimp::Importer m_importer;
     const aiScene* m_scene;
+    std::string m_file_path;
     std::string m_base_dir;
     PrimitiveTypes m_primitive_type;
 };
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int num_threads)
+{
+    if (num_threads == 0)
+        num_threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    for (unsigned int i = 0; i < num_threads; ++i)
+    {
+        m_workers.emplace_back([this]() { worker_loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_task_cv.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count == 0) return;
+
+    // state is shared since helpers that start late may still look at it after we return
+    struct ForState
+    {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<ForState>();
+
+    auto run = [state, count, &func]()
+    {
+        size_t i;
+        while ((i = state->next.fetch_add(1)) < count)
+        {
+            func(i);
+
+            if (state->done.fetch_add(1) + 1 == count)
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    size_t num_helpers = std::min(count, (size_t)get_num_threads());
+    for (size_t h = 1; h < num_helpers; ++h)
+    {
+        enqueue(run);
+    }
+
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done.load() == count; });
+}
+
+void ThreadPool::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle_cv.wait(lock, [this]() { return m_tasks.empty() && m_active == 0; });
+}
+
+ThreadPool& ThreadPool::get()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()>&& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push(std::move(task));
+    }
+
+    m_task_cv.notify_one();
+}
+
+void ThreadPool::worker_loop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_task_cv.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+            if (m_stopping && m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+            ++m_active;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+
+            if (m_tasks.empty() && m_active == 0)
+                m_idle_cv.notify_all();
+        }
+    }
+}
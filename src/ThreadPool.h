@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads that pull tasks from a shared queue
+class ThreadPool
+{
+public:
+    explicit ThreadPool(unsigned int num_threads = 0);
+    ~ThreadPool();
+
+    template<typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<F>>;
+
+    // runs func(i) for every i in [0, count), the calling thread helps out so this is safe to nest
+    void parallel_for(size_t count, const std::function<void(size_t)>& func);
+    void wait_idle();
+
+    [[nodiscard]] unsigned int get_num_threads() const { return (unsigned int)m_workers.size(); }
+
+    // shared pool used by the engine and the tools
+    static ThreadPool& get();
+
+private:
+    void enqueue(std::function<void()>&& task);
+    void worker_loop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_task_cv;
+    std::condition_variable m_idle_cv;
+    unsigned int m_active = 0;
+    bool m_stopping = false;
+};
+
+template<typename F>
+auto ThreadPool::submit(F&& task) -> std::future<std::invoke_result_t<F>>
+{
+    using R = std::invoke_result_t<F>;
+
+    auto packaged = std::make_shared<std::packaged_task<R()>>(std::forward<F>(task));
+    std::future<R> result = packaged->get_future();
+
+    enqueue([packaged]() { (*packaged)(); });
+
+    return result;
+}
@@ -4,6 +4,7 @@
 #include "Input.h"
 #include "ViewPort.h"
 #include "EventList.h"
+#include "renderer/GLState.h"
 
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -51,6 +52,7 @@ Window::Window(int width, int height, int viewport_width, int viewport_height)
 	// setup backends
 	ImGui_ImplGlfw_InitForOpenGL(m_window_handle, true);
 	ImGui_ImplOpenGL3_Init(glsl_version);
+	GLState::invalidate();
 	
 	// v-sync on
 	glfwSwapInterval(m_vsync);
@@ -116,8 +118,11 @@ void Window::end_frame()
 
 	ImGui::Render();
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+	// the backend sets its own state and only puts part of it back
+	GLState::invalidate();
 
 	glfwSwapBuffers(m_window_handle);
+	GLState::end_frame();
 	glfwPollEvents();
 }
 
@@ -0,0 +1,269 @@
+#include "pch.h"
+#include "Archive.h"
+#include "LzCodec.h"
+#include "Hash.h"
+#include "ThreadPool.h"
+#include "Log.h"
+
+#include <atomic>
+#include <cstring>
+
+// file data starts on this boundary so mapped files keep the alignment they were cooked with
+static constexpr uint64_t ARCHIVE_DATA_ALIGNMENT = 16;
+static constexpr uint64_t ARCHIVE_SECTION_ALIGNMENT = 8;
+
+static uint64_t align_to(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+static bool section_in_bounds(uint64_t offset, uint64_t size, uint64_t file_size)
+{
+    return offset % ARCHIVE_SECTION_ALIGNMENT == 0 && offset <= file_size && size <= file_size - offset;
+}
+
+bool Archive::open(const std::string& file_path)
+{
+    m_file = FileSystem::map(file_path);
+
+    if (!validate())
+    {
+        m_file = {};
+        return false;
+    }
+
+    return true;
+}
+
+bool Archive::validate() const
+{
+    if (m_file.size() < sizeof(ArchiveHeader))
+        return false;
+
+    const ArchiveHeader& h = header();
+    if (std::memcmp(h.magic, ArchiveHeader{}.magic, 4) != 0 || h.version != ArchiveHeader{}.version)
+        return false;
+
+    uint64_t file_size = m_file.size();
+    if (!section_in_bounds(h.entry_offset, (uint64_t)h.entry_count * sizeof(ArchiveEntry), file_size) ||
+        !section_in_bounds(h.chunk_offset, (uint64_t)h.chunk_count * sizeof(ArchiveChunk), file_size) ||
+        !section_in_bounds(h.string_offset, h.string_size, file_size))
+        return false;
+
+    // every path has to end inside the table
+    if (h.string_size == 0 || m_file.data()[h.string_offset + h.string_size - 1] != '\0')
+        return false;
+
+    for (uint32_t i = 0; i < h.chunk_count; ++i)
+    {
+        const ArchiveChunk& c = chunk(i);
+        if (c.size > ARCHIVE_CHUNK_SIZE || c.stored_size > c.size || c.offset > file_size || c.stored_size > file_size - c.offset)
+            return false;
+    }
+
+    for (uint32_t i = 0; i < h.entry_count; ++i)
+    {
+        const ArchiveEntry& e = entry(i);
+        if (e.path >= h.string_size || e.first_chunk > h.chunk_count || e.chunk_count > h.chunk_count - e.first_chunk)
+            return false;
+
+        if (i > 0 && entry(i - 1).path_hash > e.path_hash)
+            return false;
+
+        // chunks are decoded into place by their index so only the last one can be short
+        uint64_t size = 0;
+        for (uint32_t c = 0; c < e.chunk_count; ++c)
+        {
+            uint32_t chunk_size = chunk(e.first_chunk + c).size;
+            if (c + 1 < e.chunk_count && chunk_size != ARCHIVE_CHUNK_SIZE)
+                return false;
+
+            size += chunk_size;
+        }
+
+        if (size != e.size)
+            return false;
+    }
+
+    return true;
+}
+
+const ArchiveEntry* Archive::find(const std::string& path) const
+{
+    if (!m_file)
+        return nullptr;
+
+    uint64_t path_hash = hash_string(path);
+
+    const ArchiveEntry* begin = &entry(0);
+    const ArchiveEntry* end = begin + header().entry_count;
+    const ArchiveEntry* it = std::lower_bound(begin, end, path_hash, [](const ArchiveEntry& e, uint64_t h) { return e.path_hash < h; });
+
+    for (; it != end && it->path_hash == path_hash; ++it)
+    {
+        if (path == string(it->path))
+            return it;
+    }
+
+    return nullptr;
+}
+
+FileView Archive::read(const ArchiveEntry& e) const
+{
+    if (e.chunk_count == 0)
+        return { m_file.share(), 0 };
+
+    const ArchiveChunk& first = chunk(e.first_chunk);
+    if (e.chunk_count == 1 && first.stored_size == first.size)
+        return { m_file.share(first.offset), e.size };
+
+    auto bytes = std::make_shared<std::vector<unsigned char>>(e.size);
+    std::atomic<bool> ok = true;
+
+    auto decode_chunk = [&](size_t index)
+    {
+        const ArchiveChunk& c = chunk(e.first_chunk + (uint32_t)index);
+        unsigned char* dst = bytes->data() + index * ARCHIVE_CHUNK_SIZE;
+        const unsigned char* src = m_file.data() + c.offset;
+
+        if (c.stored_size == c.size)
+            std::memcpy(dst, src, c.size);
+        else if (!lz_decompress(src, c.stored_size, dst, c.size))
+            ok = false;
+    };
+
+    if (e.chunk_count == 1)
+        decode_chunk(0);
+    else
+        ThreadPool::get().parallel_for(e.chunk_count, decode_chunk);
+
+    if (!ok)
+    {
+        error("Corrupt chunk in archived file {}\n", string(e.path));
+        return {};
+    }
+
+    return { std::shared_ptr<const unsigned char>(bytes, bytes->data()), e.size };
+}
+
+bool write_archive(const std::string& input_dir, const std::string& file_path, bool compress, ArchiveStats* stats)
+{
+    std::filesystem::path output = std::filesystem::absolute(file_path).lexically_normal();
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(input_dir))
+    {
+        if (entry.is_regular_file() && std::filesystem::absolute(entry.path()).lexically_normal() != output)
+            files.push_back(entry.path());
+    }
+
+    // same input, same archive
+    std::sort(files.begin(), files.end());
+
+    std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    ArchiveHeader header;
+    out.write((const char*)&header, sizeof(header));
+
+    std::vector<ArchiveEntry> entries;
+    std::vector<ArchiveChunk> chunks;
+    std::string strings(1, '\0');
+    uint64_t offset = sizeof(header);
+    uint64_t source_bytes = 0;
+
+    auto pad_to = [&](uint64_t alignment)
+    {
+        uint64_t aligned = align_to(offset, alignment);
+        for (; offset < aligned; ++offset)
+            out.put(0);
+    };
+
+    for (const std::filesystem::path& path : files)
+    {
+        std::vector<unsigned char> bytes;
+        if (!FileSystem::read(path.string(), bytes))
+        {
+            error("Could not read {}\n", path.string());
+            return false;
+        }
+
+        std::string relative = path.lexically_relative(input_dir).generic_string();
+
+        ArchiveEntry entry{};
+        entry.path_hash = hash_string(relative);
+        entry.path = (uint32_t)strings.size();
+        entry.first_chunk = (uint32_t)chunks.size();
+        entry.chunk_count = (uint32_t)((bytes.size() + ARCHIVE_CHUNK_SIZE - 1) / ARCHIVE_CHUNK_SIZE);
+        entry.size = bytes.size();
+        entries.push_back(entry);
+
+        strings += relative;
+        strings.push_back('\0');
+        source_bytes += bytes.size();
+
+        // chunks are compressed in parallel and written in order
+        std::vector<std::vector<unsigned char>> packed(entry.chunk_count);
+
+        if (compress)
+        {
+            ThreadPool::get().parallel_for(entry.chunk_count, [&](size_t c)
+            {
+                size_t begin = c * ARCHIVE_CHUNK_SIZE;
+                size_t size = std::min<size_t>(ARCHIVE_CHUNK_SIZE, bytes.size() - begin);
+                if (!lz_compress(bytes.data() + begin, size, packed[c]))
+                    packed[c].clear();
+            });
+        }
+
+        pad_to(ARCHIVE_DATA_ALIGNMENT);
+
+        for (uint32_t c = 0; c < entry.chunk_count; ++c)
+        {
+            size_t begin = (size_t)c * ARCHIVE_CHUNK_SIZE;
+            uint32_t size = (uint32_t)std::min<size_t>(ARCHIVE_CHUNK_SIZE, bytes.size() - begin);
+
+            // chunks that didn't shrink are stored as is
+            bool stored = packed[c].empty();
+            const unsigned char* data = stored ? bytes.data() + begin : packed[c].data();
+            uint32_t stored_size = stored ? size : (uint32_t)packed[c].size();
+
+            chunks.push_back({ offset, stored_size, size });
+            out.write((const char*)data, stored_size);
+            offset += stored_size;
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const ArchiveEntry& a, const ArchiveEntry& b) { return a.path_hash < b.path_hash; });
+
+    pad_to(ARCHIVE_SECTION_ALIGNMENT);
+    header.entry_offset = offset;
+    header.entry_count = (uint32_t)entries.size();
+    out.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(ArchiveEntry)));
+    offset += entries.size() * sizeof(ArchiveEntry);
+
+    pad_to(ARCHIVE_SECTION_ALIGNMENT);
+    header.chunk_offset = offset;
+    header.chunk_count = (uint32_t)chunks.size();
+    out.write((const char*)chunks.data(), (std::streamsize)(chunks.size() * sizeof(ArchiveChunk)));
+    offset += chunks.size() * sizeof(ArchiveChunk);
+
+    pad_to(ARCHIVE_SECTION_ALIGNMENT);
+    header.string_offset = offset;
+    header.string_size = strings.size();
+    out.write(strings.data(), (std::streamsize)strings.size());
+    offset += strings.size();
+
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+
+    if (stats)
+    {
+        stats->num_files = (uint32_t)entries.size();
+        stats->source_bytes = source_bytes;
+        stats->archive_bytes = offset;
+    }
+
+    return out.good();
+}
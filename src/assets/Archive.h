@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FileSystem.h"
+
+#include <cstdint>
+#include <string>
+
+// a packed directory (.tbpak) that is mapped and read in place
+// files are split into chunks so big ones can be decompressed on several threads, chunks that don't shrink are stored as is
+
+// uncompressed size of every chunk but the last one of a file
+static constexpr uint32_t ARCHIVE_CHUNK_SIZE = 256 * 1024;
+
+struct ArchiveHeader
+{
+    char magic[4] = { 'T', 'B', 'P', 'K' };
+    uint32_t version = 1;
+    uint32_t entry_count = 0;
+    uint32_t chunk_count = 0;
+    uint64_t entry_offset = 0;
+    uint64_t chunk_offset = 0;
+    uint64_t string_offset = 0, string_size = 0;
+};
+
+// sorted by path hash so lookups are a binary search
+struct ArchiveEntry
+{
+    uint64_t path_hash;
+    uint32_t path; // string offset, relative to the packed directory with forward slashes
+    uint32_t first_chunk;
+    uint32_t chunk_count;
+    uint32_t padding;
+    uint64_t size;
+};
+
+struct ArchiveChunk
+{
+    uint64_t offset;      // from the start of the archive
+    uint32_t stored_size; // equal to size when the chunk isn't compressed
+    uint32_t size;
+};
+
+class Archive
+{
+public:
+    bool open(const std::string& file_path);
+
+    // nullptr if the path isn't in the archive, it has to be relative to the packed directory
+    [[nodiscard]] const ArchiveEntry* find(const std::string& path) const;
+
+    // files stored in a single uncompressed chunk point straight into the mapping, the rest are decompressed
+    [[nodiscard]] FileView read(const ArchiveEntry& entry) const;
+
+    [[nodiscard]] const ArchiveHeader& header() const { return *(const ArchiveHeader*)m_file.data(); }
+    [[nodiscard]] const ArchiveEntry& entry(uint32_t index) const { return ((const ArchiveEntry*)(m_file.data() + header().entry_offset))[index]; }
+    [[nodiscard]] const ArchiveChunk& chunk(uint32_t index) const { return ((const ArchiveChunk*)(m_file.data() + header().chunk_offset))[index]; }
+    [[nodiscard]] const char* string(uint32_t offset) const { return (const char*)(m_file.data() + header().string_offset + offset); }
+
+private:
+    bool validate() const;
+
+    FileView m_file;
+};
+
+struct ArchiveStats
+{
+    uint32_t num_files = 0;
+    uint64_t source_bytes = 0;
+    uint64_t archive_bytes = 0;
+};
+
+// packs every file under input_dir, compress = false stores everything as is
+bool write_archive(const std::string& input_dir, const std::string& file_path, bool compress, ArchiveStats* stats = nullptr);
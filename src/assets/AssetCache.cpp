@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "AssetCache.h"
+#include "Log.h"
+#include "Hash.h"
+#include "FileSystem.h"
+
+#include <nlohmann/json.hpp>
+
+using namespace nlohmann;
+
+std::string AssetCache::m_cache_dir;
+std::string AssetCache::m_source_root;
+std::unordered_map<std::string, std::string> AssetCache::m_entries;
+std::unordered_map<std::string, uint64_t> AssetCache::m_hashes;
+
+bool AssetCache::mount(const std::string& cache_dir)
+{
+    std::string resolved_dir = FileSystem::resolve(cache_dir);
+    std::filesystem::path manifest_path = std::filesystem::path(resolved_dir) / "manifest.json";
+
+    std::string manifest_src;
+    if (!FileSystem::read(manifest_path.string(), manifest_src))
+        return false;
+
+    json manifest = json::parse(manifest_src, nullptr, false);
+    if (manifest.is_discarded() || !manifest.contains("assets"))
+    {
+        warn("Asset cache manifest {} is corrupt, ignoring it\n", manifest_path.string());
+        return false;
+    }
+
+    unmount();
+
+    m_cache_dir = normalize_path(resolved_dir);
+    m_source_root = normalize_path(manifest.value("source_root", ""));
+
+    // lookups are relative to the root the assets were cooked from, if it isn't here nothing will be found
+    std::error_code ec;
+    if (!std::filesystem::is_directory(m_source_root, ec))
+        warn("Asset cache {} was cooked from {} which doesn't exist here\n", m_cache_dir, m_source_root);
+
+    for (const auto& [source, entry] : manifest["assets"].items())
+    {
+        std::string cooked = entry.value("cooked", "");
+        if (!cooked.empty())
+            m_entries[source] = (std::filesystem::path(m_cache_dir) / cooked).generic_string();
+
+        m_hashes[source] = string_to_hash(entry.value("hash", ""));
+    }
+
+    info("Mounted asset cache {} ({} assets)\n", m_cache_dir, m_entries.size());
+    return true;
+}
+
+void AssetCache::unmount()
+{
+    m_cache_dir.clear();
+    m_source_root.clear();
+    m_entries.clear();
+    m_hashes.clear();
+}
+
+std::string AssetCache::find(const std::string& source_path)
+{
+    if (!is_mounted())
+        return "";
+
+    std::string relative = std::filesystem::path(normalize_path(source_path)).lexically_relative(m_source_root).generic_string();
+
+    auto it = m_entries.find(relative);
+    if (it == m_entries.end())
+        return "";
+
+    return it->second;
+}
+
+uint64_t AssetCache::find_hash(const std::string& source_path)
+{
+    if (!is_mounted())
+        return 0;
+
+    std::string relative = std::filesystem::path(normalize_path(source_path)).lexically_relative(m_source_root).generic_string();
+
+    auto it = m_hashes.find(relative);
+    if (it == m_hashes.end())
+        return 0;
+
+    return it->second;
+}
+
+// canonical so the same file matches however it was reached, relative to a different working directory or through a symlink
+std::string AssetCache::normalize_path(const std::string& path)
+{
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(FileSystem::resolve(path), ec);
+    std::string normalized = (ec ? std::filesystem::path(path).lexically_normal() : canonical).generic_string();
+
+    // directories are stored without the trailing slash
+    while (normalized.size() > 1 && normalized.back() == '/')
+        normalized.pop_back();
+
+    return normalized;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// read side of the cooked asset cache written by toybox_cook
+class AssetCache
+{
+public:
+    // loads <cache_dir>/manifest.json, returns false if there is no cache there
+    static bool mount(const std::string& cache_dir);
+    static void unmount();
+    [[nodiscard]] static bool is_mounted() { return !m_cache_dir.empty(); }
+
+    // path to the cooked version of a source asset or an empty string if it was never cooked
+    [[nodiscard]] static std::string find(const std::string& source_path);
+
+    // content hash recorded when the asset was cooked, 0 if it isn't in the cache
+    [[nodiscard]] static uint64_t find_hash(const std::string& source_path);
+
+    [[nodiscard]] static std::string normalize_path(const std::string& path);
+
+private:
+    static std::string m_cache_dir;
+    static std::string m_source_root;
+    static std::unordered_map<std::string, std::string> m_entries;
+    static std::unordered_map<std::string, uint64_t> m_hashes;
+};
@@ -0,0 +1,68 @@
+#include "pch.h"
+#include "AssimpIO.h"
+#include "FileSystem.h"
+
+#include <cstring>
+
+class AssimpFileStream : public Assimp::IOStream
+{
+public:
+    explicit AssimpFileStream(FileView&& file) : m_file(std::move(file)) {}
+
+    size_t Read(void* buffer, size_t size, size_t count) override
+    {
+        if (size == 0)
+            return 0;
+
+        // only whole elements are read, like fread
+        size_t available = (size_t)(m_file.size() - m_position) / size;
+        count = std::min(count, available);
+
+        std::memcpy(buffer, m_file.data() + m_position, size * count);
+        m_position += size * count;
+
+        return count;
+    }
+
+    size_t Write(const void*, size_t, size_t) override { return 0; }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        uint64_t base = (origin == aiOrigin_CUR) ? m_position : (origin == aiOrigin_END) ? m_file.size() : 0;
+        if (origin == aiOrigin_END ? offset > base : offset > m_file.size() - base)
+            return aiReturn_FAILURE;
+
+        m_position = (origin == aiOrigin_END) ? base - offset : base + offset;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override { return (size_t)m_position; }
+    size_t FileSize() const override { return (size_t)m_file.size(); }
+    void Flush() override {}
+
+private:
+    FileView m_file;
+    uint64_t m_position = 0;
+};
+
+bool AssimpIOSystem::Exists(const char* file) const
+{
+    return FileSystem::exists(file);
+}
+
+Assimp::IOStream* AssimpIOSystem::Open(const char* file, const char* mode)
+{
+    if (std::strchr(mode, 'w') || std::strchr(mode, 'a') || std::strchr(mode, '+'))
+        return nullptr;
+
+    FileView view = FileSystem::map(file);
+    if (!view)
+        return nullptr;
+
+    return new AssimpFileStream(std::move(view));
+}
+
+void AssimpIOSystem::Close(Assimp::IOStream* stream)
+{
+    delete stream;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+// lets assimp open models and the buffers they reference through FileSystem so they can come out of an archive
+// the importer takes ownership of it: importer.SetIOHandler(new AssimpIOSystem)
+class AssimpIOSystem : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char* file) const override;
+    char getOsSeparator() const override { return '/'; }
+
+    // read only, anything opened for writing fails
+    Assimp::IOStream* Open(const char* file, const char* mode = "rb") override;
+    void Close(Assimp::IOStream* stream) override;
+};
@@ -0,0 +1,672 @@
+#include "pch.h"
+#include "BlockCompress.h"
+#include "ThreadPool.h"
+
+#include <cfloat>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define BLOCK_COMPRESS_SSE
+#include <emmintrin.h>
+#endif
+
+// a 4x4 block with each channel stored on its own so four pixels can be worked on at once
+struct PixelBlock
+{
+    alignas(16) float channels[4][16];
+};
+
+const char* compress_quality_to_str(CompressQuality quality)
+{
+    switch (quality)
+    {
+        case CompressQuality::Fast:   return "fast";
+        case CompressQuality::Normal: return "normal";
+        case CompressQuality::High:   return "high";
+    }
+
+    return "";
+}
+
+bool str_to_compress_quality(const std::string& str, CompressQuality& quality)
+{
+    if (str == "fast")   { quality = CompressQuality::Fast;   return true; }
+    if (str == "normal") { quality = CompressQuality::Normal; return true; }
+    if (str == "high")   { quality = CompressQuality::High;   return true; }
+
+    return false;
+}
+
+PixelFormat choose_compressed_format(const TextureData& texture)
+{
+    for (uint32_t face = 0; face < texture.faces; ++face)
+    {
+        const MipLevel& level = texture.level(face, 0);
+        const unsigned char* pixels = texture.level_data(face, 0);
+
+        for (uint64_t i = 0; i < (uint64_t)level.width * level.height; ++i)
+        {
+            if (pixels[i * 4 + 3] != 255)
+                return PixelFormat::BC3;
+        }
+    }
+
+    return PixelFormat::BC1;
+}
+
+uint32_t format_channel_mask(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat::RGBA8: return 0b1111;
+        case PixelFormat::BC1:   return 0b0111;
+        case PixelFormat::BC3:   return 0b1111;
+        case PixelFormat::BC4:   return 0b0001;
+        case PixelFormat::BC5:   return 0b0011;
+        case PixelFormat::BC7:   return 0b1111;
+    }
+
+    return 0;
+}
+
+// pixels past the edge of the image repeat the last row/column
+static void load_block(const unsigned char* rgba, uint32_t width, uint32_t height, uint32_t block_x, uint32_t block_y, PixelBlock& block)
+{
+    for (uint32_t y = 0; y < 4; ++y)
+    {
+        uint32_t py = std::min(block_y * 4 + y, height - 1);
+
+        for (uint32_t x = 0; x < 4; ++x)
+        {
+            uint32_t px = std::min(block_x * 4 + x, width - 1);
+            const unsigned char* pixel = rgba + ((uint64_t)py * width + px) * 4;
+
+            for (uint32_t c = 0; c < 4; ++c)
+                block.channels[c][y * 4 + x] = pixel[c];
+        }
+    }
+}
+
+// picks the closest palette entry for every pixel, the palette is laid out as [entry][channel]
+// returns the total squared error
+static float choose_indices(const float* const* channels, int num_channels, const float* palette, int palette_size, uint8_t indices[16])
+{
+    float total_error = 0.f;
+
+#ifdef BLOCK_COMPRESS_SSE
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 best_error = _mm_set1_ps(FLT_MAX);
+        __m128 best_index = _mm_setzero_ps();
+
+        for (int p = 0; p < palette_size; ++p)
+        {
+            __m128 error = _mm_setzero_ps();
+            for (int c = 0; c < num_channels; ++c)
+            {
+                __m128 diff = _mm_sub_ps(_mm_loadu_ps(channels[c] + i), _mm_set1_ps(palette[p * num_channels + c]));
+                error = _mm_add_ps(error, _mm_mul_ps(diff, diff));
+            }
+
+            __m128 closer = _mm_cmplt_ps(error, best_error);
+            best_error = _mm_min_ps(error, best_error);
+            best_index = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)p)), _mm_andnot_ps(closer, best_index));
+        }
+
+        alignas(16) float index_out[4], error_out[4];
+        _mm_store_ps(index_out, best_index);
+        _mm_store_ps(error_out, best_error);
+
+        for (int k = 0; k < 4; ++k)
+        {
+            indices[i + k] = (uint8_t)index_out[k];
+            total_error += error_out[k];
+        }
+    }
+#else
+    for (int i = 0; i < 16; ++i)
+    {
+        float best_error = FLT_MAX;
+        int best_index = 0;
+
+        for (int p = 0; p < palette_size; ++p)
+        {
+            float error = 0.f;
+            for (int c = 0; c < num_channels; ++c)
+            {
+                float diff = channels[c][i] - palette[p * num_channels + c];
+                error += diff * diff;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                best_index = p;
+            }
+        }
+
+        indices[i] = (uint8_t)best_index;
+        total_error += best_error;
+    }
+#endif
+
+    return total_error;
+}
+
+// solves for the two endpoints that best fit the pixels given their current indices
+// weights[i] is how much of the first endpoint palette entry i holds
+static bool least_squares_endpoints(const float* const* channels, int num_channels, const uint8_t indices[16], const float* weights, float* end0, float* end1)
+{
+    float aa = 0.f, ab = 0.f, bb = 0.f;
+    float ax[3] = {}, bx[3] = {};
+
+    for (int i = 0; i < 16; ++i)
+    {
+        float a = weights[indices[i]];
+        float b = 1.f - a;
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for (int c = 0; c < num_channels; ++c)
+        {
+            ax[c] += a * channels[c][i];
+            bx[c] += b * channels[c][i];
+        }
+    }
+
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f)
+        return false;
+
+    for (int c = 0; c < num_channels; ++c)
+    {
+        end0[c] = std::clamp((ax[c] * bb - bx[c] * ab) / det, 0.f, 255.f);
+        end1[c] = std::clamp((bx[c] * aa - ax[c] * ab) / det, 0.f, 255.f);
+    }
+
+    return true;
+}
+
+/* ---------------- BC1 ---------------- */
+
+static uint16_t pack_565(const float* colour)
+{
+    auto r = (uint16_t)std::lround(colour[0] * 31.f / 255.f);
+    auto g = (uint16_t)std::lround(colour[1] * 63.f / 255.f);
+    auto b = (uint16_t)std::lround(colour[2] * 31.f / 255.f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void unpack_565(uint16_t packed, int* colour)
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    colour[0] = (r << 3) | (r >> 2);
+    colour[1] = (g << 2) | (g >> 4);
+    colour[2] = (b << 3) | (b >> 2);
+}
+
+// same integer maths as the decoder so the error estimate matches what the GPU shows
+static void bc1_palette(uint16_t c0, uint16_t c1, bool four_colour, int palette[4][3])
+{
+    unpack_565(c0, palette[0]);
+    unpack_565(c1, palette[1]);
+
+    for (int c = 0; c < 3; ++c)
+    {
+        if (four_colour)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        else
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+}
+
+// quantizes the endpoints and fits the indices, always in four colour mode
+static float fit_bc1(const float* const* channels, const float* end0, const float* end1, uint16_t& c0, uint16_t& c1, uint8_t indices[16])
+{
+    c0 = pack_565(end0);
+    c1 = pack_565(end1);
+
+    if (c0 < c1)
+        std::swap(c0, c1);
+
+    int palette[4][3];
+    bc1_palette(c0, c1, true, palette);
+
+    float palette_f[4 * 3];
+    for (int p = 0; p < 4; ++p)
+        for (int c = 0; c < 3; ++c)
+            palette_f[p * 3 + c] = (float)palette[p][c];
+
+    // with equal endpoints every entry is the same colour in either mode
+    int palette_size = (c0 == c1) ? 1 : 4;
+    return choose_indices(channels, 3, palette_f, palette_size, indices);
+}
+
+static void principal_axis(const float* const* channels, const float* mean, float* axis)
+{
+    float cov[6] = {};
+    for (int i = 0; i < 16; ++i)
+    {
+        float r = channels[0][i] - mean[0], g = channels[1][i] - mean[1], b = channels[2][i] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // a few rounds of power iteration is plenty for a 3x3 matrix
+    axis[0] = 1.f; axis[1] = 1.f; axis[2] = 1.f;
+    for (int iter = 0; iter < 4; ++iter)
+    {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+        float length = std::max({ std::fabs(x), std::fabs(y), std::fabs(z) });
+        if (length < 1e-6f)
+            return;
+
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+    }
+}
+
+// pulls the endpoints in a bit since the extremes are rarely hit exactly once quantized
+static void inset_endpoints(float* end0, float* end1, int num_channels)
+{
+    for (int c = 0; c < num_channels; ++c)
+    {
+        float inset = (end0[c] - end1[c]) / 16.f;
+        end0[c] = std::clamp(end0[c] - inset, 0.f, 255.f);
+        end1[c] = std::clamp(end1[c] + inset, 0.f, 255.f);
+    }
+}
+
+static void encode_bc1_block(const PixelBlock& block, CompressQuality quality, unsigned char* out)
+{
+    const float* channels[3] = { block.channels[0], block.channels[1], block.channels[2] };
+
+    float end0[3], end1[3];
+
+    if (quality == CompressQuality::Fast)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            end0[c] = *std::max_element(channels[c], channels[c] + 16);
+            end1[c] = *std::min_element(channels[c], channels[c] + 16);
+        }
+    }
+    else
+    {
+        float mean[3] = {};
+        for (int c = 0; c < 3; ++c)
+        {
+            for (int i = 0; i < 16; ++i)
+                mean[c] += channels[c][i];
+            mean[c] /= 16.f;
+        }
+
+        float axis[3];
+        principal_axis(channels, mean, axis);
+
+        float min_proj = FLT_MAX, max_proj = -FLT_MAX;
+        for (int i = 0; i < 16; ++i)
+        {
+            float proj = (channels[0][i] - mean[0]) * axis[0] + (channels[1][i] - mean[1]) * axis[1] + (channels[2][i] - mean[2]) * axis[2];
+            min_proj = std::min(min_proj, proj);
+            max_proj = std::max(max_proj, proj);
+        }
+
+        float axis_length_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        for (int c = 0; c < 3; ++c)
+        {
+            end0[c] = std::clamp(mean[c] + axis[c] * max_proj / axis_length_sq, 0.f, 255.f);
+            end1[c] = std::clamp(mean[c] + axis[c] * min_proj / axis_length_sq, 0.f, 255.f);
+        }
+    }
+
+    inset_endpoints(end0, end1, 3);
+
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    float error = fit_bc1(channels, end0, end1, c0, c1, indices);
+
+    if (quality == CompressQuality::High)
+    {
+        static const float weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };
+
+        for (int iter = 0; iter < 2 && error > 0.f; ++iter)
+        {
+            if (c0 == c1 || !least_squares_endpoints(channels, 3, indices, weights, end0, end1))
+                break;
+
+            uint16_t new_c0, new_c1;
+            uint8_t new_indices[16];
+            float new_error = fit_bc1(channels, end0, end1, new_c0, new_c1, new_indices);
+
+            if (new_error >= error)
+                break;
+
+            error = new_error;
+            c0 = new_c0;
+            c1 = new_c1;
+            std::copy(new_indices, new_indices + 16, indices);
+        }
+    }
+
+    uint32_t packed_indices = 0;
+    for (int i = 0; i < 16; ++i)
+        packed_indices |= (uint32_t)indices[i] << (i * 2);
+
+    out[0] = (unsigned char)(c0 & 0xff);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xff);
+    out[3] = (unsigned char)(c1 >> 8);
+    std::memcpy(out + 4, &packed_indices, 4);
+}
+
+static void decode_bc1_block(const unsigned char* in, bool allow_three_colour, unsigned char rgba[16][4])
+{
+    uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+    uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+
+    uint32_t packed_indices;
+    std::memcpy(&packed_indices, in + 4, 4);
+
+    bool four_colour = !allow_three_colour || c0 > c1;
+
+    int palette[4][3];
+    bc1_palette(c0, c1, four_colour, palette);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        uint32_t index = (packed_indices >> (i * 2)) & 3;
+        for (int c = 0; c < 3; ++c)
+            rgba[i][c] = (unsigned char)palette[index][c];
+
+        rgba[i][3] = (!four_colour && index == 3) ? 0 : 255;
+    }
+}
+
+/* ---------------- BC4 ---------------- */
+
+static void bc4_palette(int r0, int r1, int palette[8])
+{
+    palette[0] = r0;
+    palette[1] = r1;
+
+    if (r0 > r1)
+    {
+        for (int k = 2; k < 8; ++k)
+            palette[k] = ((8 - k) * r0 + (k - 1) * r1) / 7;
+    }
+    else
+    {
+        for (int k = 2; k < 6; ++k)
+            palette[k] = ((6 - k) * r0 + (k - 1) * r1) / 5;
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+static float fit_bc4(const float* values, int r0, int r1, uint8_t indices[16])
+{
+    int palette[8];
+    bc4_palette(r0, r1, palette);
+
+    float palette_f[8];
+    for (int k = 0; k < 8; ++k)
+        palette_f[k] = (float)palette[k];
+
+    return choose_indices(&values, 1, palette_f, 8, indices);
+}
+
+static void encode_bc4_block(const float* values, CompressQuality quality, unsigned char* out)
+{
+    float min_value = *std::min_element(values, values + 16);
+    float max_value = *std::max_element(values, values + 16);
+
+    // eight value mode between the extremes
+    int r0 = (int)std::lround(max_value), r1 = (int)std::lround(min_value);
+    uint8_t indices[16];
+    float error = fit_bc4(values, r0, r1, indices);
+
+    if (quality != CompressQuality::Fast && error > 0.f)
+    {
+        // six value mode gets exact 0 and 255 for free, so the endpoints only have to cover what is in between
+        float inner_min = 255.f, inner_max = 0.f;
+        for (int i = 0; i < 16; ++i)
+        {
+            if (values[i] > 0.5f && values[i] < 254.5f)
+            {
+                inner_min = std::min(inner_min, values[i]);
+                inner_max = std::max(inner_max, values[i]);
+            }
+        }
+
+        if (inner_min <= inner_max)
+        {
+            int s0 = (int)std::lround(inner_min), s1 = (int)std::lround(inner_max);
+            uint8_t six_indices[16];
+            float six_error = fit_bc4(values, s0, s1, six_indices);
+
+            if (six_error < error)
+            {
+                error = six_error;
+                r0 = s0;
+                r1 = s1;
+                std::copy(six_indices, six_indices + 16, indices);
+            }
+        }
+    }
+
+    if (quality == CompressQuality::High && r0 > r1)
+    {
+        static const float weights[8] = { 1.f, 0.f, 6.f / 7.f, 5.f / 7.f, 4.f / 7.f, 3.f / 7.f, 2.f / 7.f, 1.f / 7.f };
+
+        for (int iter = 0; iter < 2 && error > 0.f; ++iter)
+        {
+            float end0, end1;
+            if (!least_squares_endpoints(&values, 1, indices, weights, &end0, &end1))
+                break;
+
+            int n0 = (int)std::lround(end0), n1 = (int)std::lround(end1);
+            if (n0 <= n1)
+                break;
+
+            uint8_t new_indices[16];
+            float new_error = fit_bc4(values, n0, n1, new_indices);
+
+            if (new_error >= error)
+                break;
+
+            error = new_error;
+            r0 = n0;
+            r1 = n1;
+            std::copy(new_indices, new_indices + 16, indices);
+        }
+    }
+
+    uint64_t packed_indices = 0;
+    for (int i = 0; i < 16; ++i)
+        packed_indices |= (uint64_t)indices[i] << (i * 3);
+
+    out[0] = (unsigned char)r0;
+    out[1] = (unsigned char)r1;
+    for (int b = 0; b < 6; ++b)
+        out[2 + b] = (unsigned char)(packed_indices >> (b * 8));
+}
+
+static void decode_bc4_block(const unsigned char* in, unsigned char values[16])
+{
+    int palette[8];
+    bc4_palette(in[0], in[1], palette);
+
+    uint64_t packed_indices = 0;
+    for (int b = 0; b < 6; ++b)
+        packed_indices |= (uint64_t)in[2 + b] << (b * 8);
+
+    for (int i = 0; i < 16; ++i)
+        values[i] = (unsigned char)palette[(packed_indices >> (i * 3)) & 7];
+}
+
+/* ---------------- levels ---------------- */
+
+static void encode_block(PixelFormat format, const PixelBlock& block, CompressQuality quality, unsigned char* out)
+{
+    switch (format)
+    {
+        case PixelFormat::BC1:
+            encode_bc1_block(block, quality, out);
+            break;
+        case PixelFormat::BC3:
+            encode_bc4_block(block.channels[3], quality, out);
+            encode_bc1_block(block, quality, out + 8);
+            break;
+        case PixelFormat::BC4:
+            encode_bc4_block(block.channels[0], quality, out);
+            break;
+        case PixelFormat::BC5:
+            encode_bc4_block(block.channels[0], quality, out);
+            encode_bc4_block(block.channels[1], quality, out + 8);
+            break;
+        default:
+            break;
+    }
+}
+
+bool compress_texture(const TextureData& texture, PixelFormat format, CompressQuality quality, TextureData& compressed)
+{
+    if (texture.format != PixelFormat::RGBA8 || !is_block_compressed(format) || format == PixelFormat::BC7)
+        return false;
+
+    compressed.format = format;
+    compressed.width = texture.width;
+    compressed.height = texture.height;
+    compressed.faces = texture.faces;
+    compressed.num_levels = texture.num_levels;
+    compressed.flags = texture.flags;
+    compressed.levels.clear();
+    compressed.mapped_pixels.reset();
+
+    uint64_t total_size = 0;
+    for (const MipLevel& level : texture.levels)
+    {
+        uint64_t size = level_size(format, level.width, level.height);
+        compressed.levels.push_back({ level.width, level.height, total_size, size });
+        total_size += size;
+    }
+
+    compressed.pixels.resize(total_size);
+
+    for (size_t l = 0; l < texture.levels.size(); ++l)
+    {
+        const MipLevel& level = texture.levels[l];
+        const unsigned char* src = texture.data() + level.offset;
+        unsigned char* dst = compressed.pixels.data() + compressed.levels[l].offset;
+
+        uint32_t blocks_x = (level.width + 3) / 4;
+        uint32_t blocks_y = (level.height + 3) / 4;
+        uint32_t bytes = block_size(format);
+
+        ThreadPool::get().parallel_for(blocks_y, [&](size_t block_y)
+        {
+            PixelBlock block;
+            for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+            {
+                load_block(src, level.width, level.height, block_x, (uint32_t)block_y, block);
+                encode_block(format, block, quality, dst + (block_y * blocks_x + block_x) * bytes);
+            }
+        });
+    }
+
+    return true;
+}
+
+bool decompress_level(PixelFormat format, const unsigned char* blocks, uint32_t width, uint32_t height, unsigned char* rgba)
+{
+    if (!is_block_compressed(format) || format == PixelFormat::BC7)
+        return false;
+
+    uint32_t blocks_x = (width + 3) / 4;
+    uint32_t blocks_y = (height + 3) / 4;
+    uint32_t bytes = block_size(format);
+
+    for (uint32_t block_y = 0; block_y < blocks_y; ++block_y)
+    {
+        for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+        {
+            const unsigned char* in = blocks + ((uint64_t)block_y * blocks_x + block_x) * bytes;
+            unsigned char decoded[16][4] = {};
+            unsigned char channel[16];
+
+            switch (format)
+            {
+                case PixelFormat::BC1:
+                    decode_bc1_block(in, true, decoded);
+                    break;
+                case PixelFormat::BC3:
+                    decode_bc1_block(in + 8, false, decoded);
+                    decode_bc4_block(in, channel);
+                    for (int i = 0; i < 16; ++i) decoded[i][3] = channel[i];
+                    break;
+                case PixelFormat::BC4:
+                    decode_bc4_block(in, channel);
+                    for (int i = 0; i < 16; ++i) { decoded[i][0] = channel[i]; decoded[i][3] = 255; }
+                    break;
+                case PixelFormat::BC5:
+                    decode_bc4_block(in, channel);
+                    for (int i = 0; i < 16; ++i) { decoded[i][0] = channel[i]; decoded[i][3] = 255; }
+                    decode_bc4_block(in + 8, channel);
+                    for (int i = 0; i < 16; ++i) decoded[i][1] = channel[i];
+                    break;
+                default:
+                    break;
+            }
+
+            for (uint32_t y = 0; y < 4 && block_y * 4 + y < height; ++y)
+            {
+                for (uint32_t x = 0; x < 4 && block_x * 4 + x < width; ++x)
+                {
+                    uint64_t pixel = (uint64_t)(block_y * 4 + y) * width + block_x * 4 + x;
+                    std::memcpy(rgba + pixel * 4, decoded[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+double compute_psnr(const unsigned char* a, const unsigned char* b, uint64_t pixel_count, uint32_t channel_mask)
+{
+    double squared_error = 0.0;
+    uint64_t samples = 0;
+
+    for (uint32_t c = 0; c < 4; ++c)
+    {
+        if (!(channel_mask & (1u << c)))
+            continue;
+
+        for (uint64_t i = 0; i < pixel_count; ++i)
+        {
+            double diff = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+            squared_error += diff * diff;
+        }
+
+        samples += pixel_count;
+    }
+
+    if (samples == 0 || squared_error == 0.0)
+        return 100.0;
+
+    double mse = squared_error / (double)samples;
+    return std::min(100.0, 10.0 * std::log10(255.0 * 255.0 / mse));
+}
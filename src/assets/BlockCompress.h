@@ -0,0 +1,32 @@
+#pragma once
+
+#include "TextureData.h"
+
+#include <cstdint>
+#include <string>
+
+// how hard the encoder looks for good endpoints, trading cook time for quality
+enum class CompressQuality : uint32_t
+{
+    Fast,   // bounding box endpoints
+    Normal, // endpoints along the principal axis of the block
+    High    // principal axis plus least squares refinement
+};
+
+const char* compress_quality_to_str(CompressQuality quality);
+bool str_to_compress_quality(const std::string& str, CompressQuality& quality);
+
+// BC3 if any pixel is not fully opaque, BC1 otherwise
+PixelFormat choose_compressed_format(const TextureData& texture);
+
+// which rgba channels survive a round trip through the format, bit 0 is red
+uint32_t format_channel_mask(PixelFormat format);
+
+// encodes every level of an RGBA8 texture, blocks are spread over the shared thread pool
+bool compress_texture(const TextureData& texture, PixelFormat format, CompressQuality quality, TextureData& compressed);
+
+// expands one level back to RGBA8, only the formats the encoder writes are supported
+bool decompress_level(PixelFormat format, const unsigned char* blocks, uint32_t width, uint32_t height, unsigned char* rgba);
+
+// peak signal to noise ratio in dB over the channels in the mask, capped at 100 for identical images
+double compute_psnr(const unsigned char* a, const unsigned char* b, uint64_t pixel_count, uint32_t channel_mask);
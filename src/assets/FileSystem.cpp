@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "FileSystem.h"
+#include "Archive.h"
+#include "Log.h"
+
+#ifdef PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// only changed during startup, workers just read them
+std::vector<std::string> FileSystem::m_search_paths;
+std::vector<FileSystem::MountedArchive> FileSystem::m_archives;
+
+// stands in for the data of empty files so their views still count as open
+static const unsigned char EMPTY_FILE[1] = {};
+
+template<typename Buffer>
+static bool read_whole_file(const std::string& path, Buffer& buffer)
+{
+    std::string resolved = FileSystem::resolve(path);
+
+#ifdef PLATFORM_LINUX
+    int fd = open(resolved.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        return false;
+    }
+
+    buffer.resize((size_t)st.st_size);
+
+    // read can come back short on large files so keep going until everything is in
+    size_t total = 0;
+    while (total < buffer.size())
+    {
+        ssize_t n = ::read(fd, (char*)buffer.data() + total, buffer.size() - total);
+        if (n <= 0)
+            break;
+
+        total += (size_t)n;
+    }
+
+    close(fd);
+    return total == buffer.size();
+#else
+    std::ifstream in(resolved, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+
+    buffer.resize((size_t)in.tellg());
+    in.seekg(0);
+    in.read((char*)buffer.data(), (std::streamsize)buffer.size());
+
+    return in.good() || buffer.empty();
+#endif
+}
+
+template<typename Buffer>
+static bool copy_view(const FileView& view, Buffer& buffer)
+{
+    if (!view)
+        return false;
+
+    buffer.assign(view.begin(), view.end());
+    return true;
+}
+
+// the part of the path inside the mount point or an empty string if it's somewhere else
+static std::string archive_relative_path(const std::string& path, const std::string& mount_point)
+{
+    std::string normal = std::filesystem::path(path).lexically_normal().generic_string();
+
+    if (mount_point == ".")
+        return normal.starts_with("..") ? std::string() : normal;
+
+    if (normal.size() <= mount_point.size() || !normal.starts_with(mount_point) || normal[mount_point.size()] != '/')
+        return {};
+
+    return normal.substr(mount_point.size() + 1);
+}
+
+bool FileSystem::mount_archive(const std::string& archive_path, const std::string& mount_point)
+{
+    auto archive = std::make_shared<Archive>();
+    if (!archive->open(archive_path))
+        return false;
+
+    std::string normal = std::filesystem::path(mount_point).lexically_normal().generic_string();
+    if (normal.size() > 1 && normal.back() == '/')
+        normal.pop_back();
+
+    info("Mounted archive {} at {} ({} files)\n", archive_path, normal, archive->header().entry_count);
+
+    m_archives.insert(m_archives.begin(), { normal, std::move(archive) });
+    return true;
+}
+
+void FileSystem::unmount_archives()
+{
+    m_archives.clear();
+}
+
+const ArchiveEntry* FileSystem::find_in_archives(const std::string& path, const Archive** archive)
+{
+    for (const MountedArchive& mounted : m_archives)
+    {
+        std::string relative = archive_relative_path(path, mounted.mount_point);
+        if (relative.empty())
+            continue;
+
+        if (const ArchiveEntry* entry = mounted.archive->find(relative))
+        {
+            *archive = mounted.archive.get();
+            return entry;
+        }
+    }
+
+    return nullptr;
+}
+
+void FileSystem::add_search_path(const std::string& dir)
+{
+    if (!dir.empty() && std::find(m_search_paths.begin(), m_search_paths.end(), dir) == m_search_paths.end())
+        m_search_paths.push_back(dir);
+}
+
+void FileSystem::clear_search_paths()
+{
+    m_search_paths.clear();
+}
+
+std::string FileSystem::resolve(const std::string& path)
+{
+    const Archive* archive;
+    if (find_in_archives(path, &archive))
+        return path;
+
+    std::error_code ec;
+    std::filesystem::path p(path);
+
+    if (p.is_absolute() || std::filesystem::exists(p, ec))
+        return path;
+
+    for (const std::string& dir : m_search_paths)
+    {
+        std::filesystem::path candidate = std::filesystem::path(dir) / p;
+        if (std::filesystem::exists(candidate, ec))
+            return candidate.lexically_normal().string();
+    }
+
+    return path;
+}
+
+bool FileSystem::exists(const std::string& path)
+{
+    const Archive* archive;
+    if (find_in_archives(path, &archive))
+        return true;
+
+    std::error_code ec;
+    return std::filesystem::exists(resolve(path), ec);
+}
+
+std::string FileSystem::get_executable_dir()
+{
+#ifdef PLATFORM_LINUX
+    std::error_code ec;
+    std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+    return ec ? std::string() : exe.parent_path().string();
+#else
+    return {};
+#endif
+}
+
+bool FileSystem::read(const std::string& path, std::vector<unsigned char>& bytes)
+{
+    const Archive* archive;
+    if (const ArchiveEntry* entry = find_in_archives(path, &archive))
+        return copy_view(archive->read(*entry), bytes);
+
+    return read_whole_file(path, bytes);
+}
+
+bool FileSystem::read(const std::string& path, std::string& text)
+{
+    const Archive* archive;
+    if (const ArchiveEntry* entry = find_in_archives(path, &archive))
+        return copy_view(archive->read(*entry), text);
+
+    return read_whole_file(path, text);
+}
+
+FileView FileSystem::map(const std::string& path)
+{
+    const Archive* archive;
+    if (const ArchiveEntry* entry = find_in_archives(path, &archive))
+        return archive->read(*entry);
+
+#ifdef PLATFORM_LINUX
+    std::string resolved = resolve(path);
+
+    int fd = open(resolved.c_str(), O_RDONLY);
+    if (fd < 0)
+        return {};
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        close(fd);
+        return {};
+    }
+
+    uint64_t file_size = (uint64_t)st.st_size;
+    if (file_size == 0)
+    {
+        close(fd);
+        return { std::shared_ptr<const unsigned char>(std::shared_ptr<const unsigned char>(), EMPTY_FILE), 0 };
+    }
+
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+        return {};
+
+    return { std::shared_ptr<const unsigned char>((const unsigned char*)mapping, [file_size](const unsigned char* p) { munmap((void*)p, file_size); }), file_size };
+#else
+    auto bytes = std::make_shared<std::vector<unsigned char>>();
+    if (!read_whole_file(path, *bytes))
+        return {};
+
+    return { std::shared_ptr<const unsigned char>(bytes, bytes->empty() ? EMPTY_FILE : bytes->data()), bytes->size() };
+#endif
+}
+
+void FileSystem::prefetch(const unsigned char* data, uint64_t size)
+{
+    if (!data || size == 0)
+        return;
+
+#ifdef PLATFORM_LINUX
+    // readahead for the whole range first so the reads below mostly find the pages already there
+    uint64_t page_size = (uint64_t)sysconf(_SC_PAGESIZE);
+    uintptr_t begin = (uintptr_t)data & ~(uintptr_t)(page_size - 1);
+    madvise((void*)begin, (uintptr_t)data + size - begin, MADV_WILLNEED);
+#else
+    uint64_t page_size = 4096;
+#endif
+
+    volatile unsigned char sink = 0;
+    for (uint64_t offset = 0; offset < size; offset += page_size)
+        sink = sink + data[offset];
+    sink = sink + data[size - 1];
+}
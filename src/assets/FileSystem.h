@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// read only view of a whole file, mapped where the platform allows it and read into one allocation otherwise
+// copies share the same memory, it is released once the last one goes away
+class FileView
+{
+public:
+    FileView() = default;
+    FileView(std::shared_ptr<const unsigned char> data, uint64_t size) : m_data(std::move(data)), m_size(size) {}
+
+    [[nodiscard]] const unsigned char* data() const { return m_data.get(); }
+    [[nodiscard]] uint64_t size() const { return m_size; }
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+    [[nodiscard]] explicit operator bool() const { return (bool)m_data; }
+
+    [[nodiscard]] const char* begin() const { return (const char*)m_data.get(); }
+    [[nodiscard]] const char* end() const { return begin() + m_size; }
+    [[nodiscard]] std::string_view as_string() const { return { begin(), (size_t)m_size }; }
+
+    // keeps the whole file alive for as long as the returned pointer is
+    [[nodiscard]] std::shared_ptr<const unsigned char> share(uint64_t offset = 0) const { return { m_data, m_data.get() + offset }; }
+
+private:
+    std::shared_ptr<const unsigned char> m_data;
+    uint64_t m_size = 0;
+};
+
+class Archive;
+struct ArchiveEntry;
+
+class FileSystem
+{
+public:
+    // paths under mount_point are looked up in the archive before the disk, the latest mount wins
+    static bool mount_archive(const std::string& archive_path, const std::string& mount_point);
+    static void unmount_archives();
+
+    // relative paths that don't exist from the working directory are looked up in these, in the order they were added
+    static void add_search_path(const std::string& dir);
+    static void clear_search_paths();
+
+    // first existing location of the path or the path itself if there is none or it's in an archive
+    [[nodiscard]] static std::string resolve(const std::string& path);
+    [[nodiscard]] static bool exists(const std::string& path);
+
+    // directory the running executable is in, empty if it can't be found
+    [[nodiscard]] static std::string get_executable_dir();
+
+    // the whole file in a single read sized up front, false if it couldn't be opened or read completely
+    static bool read(const std::string& path, std::vector<unsigned char>& bytes);
+    static bool read(const std::string& path, std::string& text);
+
+    // an empty view if the file couldn't be opened
+    [[nodiscard]] static FileView map(const std::string& path);
+
+    // faults in the pages of part of a mapping, blocks until they're in so it's meant for worker threads
+    static void prefetch(const unsigned char* data, uint64_t size);
+
+private:
+    struct MountedArchive
+    {
+        std::string mount_point;
+        std::shared_ptr<Archive> archive;
+    };
+
+    static const ArchiveEntry* find_in_archives(const std::string& path, const Archive** archive);
+
+    static std::vector<std::string> m_search_paths;
+    static std::vector<MountedArchive> m_archives;
+};
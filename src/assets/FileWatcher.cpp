@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "FileWatcher.h"
+#include "FileSystem.h"
+#include "Log.h"
+
+#ifdef PLATFORM_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::~FileWatcher()
+{
+    clear();
+}
+
+std::string FileWatcher::normalise(const std::string& path)
+{
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::weakly_canonical(FileSystem::resolve(path), ec);
+    return ec ? std::filesystem::path(path).lexically_normal().string() : p.string();
+}
+
+bool FileWatcher::watch(const std::string& path)
+{
+    std::error_code ec;
+    std::string file = normalise(path);
+
+    // a missing file is still watched so it's picked up once it gets created, only its directory has to exist
+    std::string dir = std::filesystem::path(file).parent_path().string();
+    if (!std::filesystem::is_directory(dir, ec))
+        return false;
+
+    if (!m_files.insert(file).second)
+        return true;
+
+#ifdef PLATFORM_LINUX
+    if (m_fd == -1)
+    {
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd == -1)
+        {
+            error("Could not start watching files\n");
+            return false;
+        }
+    }
+
+    // watches are per directory, adding the same one again hands back the same descriptor
+    int wd = inotify_add_watch(m_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd == -1)
+    {
+        error("Could not watch {}\n", dir);
+        return false;
+    }
+
+    m_directories[wd] = dir;
+#else
+    // a file that doesn't exist yet gets the minimum time, so creating it counts as a change
+    auto write_time = std::filesystem::last_write_time(file, ec);
+    m_write_times[file] = ec ? std::filesystem::file_time_type::min() : write_time;
+#endif
+
+    return true;
+}
+
+void FileWatcher::clear()
+{
+    m_files.clear();
+
+#ifdef PLATFORM_LINUX
+    // closing the descriptor drops every watch on it
+    if (m_fd != -1)
+        close(m_fd);
+
+    m_fd = -1;
+    m_directories.clear();
+#else
+    m_write_times.clear();
+#endif
+}
+
+std::vector<std::string> FileWatcher::poll()
+{
+    std::vector<std::string> changed;
+
+    auto add_changed = [&](const std::string& file)
+    {
+        if (m_files.contains(file) && std::find(changed.begin(), changed.end(), file) == changed.end())
+            changed.push_back(file);
+    };
+
+#ifdef PLATFORM_LINUX
+    if (m_fd == -1)
+        return changed;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t n = read(m_fd, buffer, sizeof(buffer));
+        if (n <= 0)
+            break;
+
+        for (ssize_t offset = 0; offset < n;)
+        {
+            const auto* event = (const inotify_event*)(buffer + offset);
+            offset += (ssize_t)(sizeof(inotify_event) + event->len);
+
+            auto it = m_directories.find(event->wd);
+            if (it != m_directories.end() && event->len > 0)
+                add_changed((std::filesystem::path(it->second) / event->name).string());
+        }
+    }
+#else
+    for (auto& [file, write_time] : m_write_times)
+    {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(file, ec);
+        if (!ec && time != write_time)
+        {
+            write_time = time;
+            add_changed(file);
+        }
+    }
+#endif
+
+    return changed;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// reports files that were written since the last poll, inotify on linux and modification times elsewhere
+class FileWatcher
+{
+public:
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // false if the file's directory doesn't exist, watching a file twice does nothing
+    bool watch(const std::string& path);
+    void clear();
+
+    // normalised paths of the watched files that changed, each only once however many times it was written
+    [[nodiscard]] std::vector<std::string> poll();
+
+    [[nodiscard]] static std::string normalise(const std::string& path);
+
+private:
+    std::unordered_set<std::string> m_files;
+
+#ifdef PLATFORM_LINUX
+    int m_fd = -1;
+    // editors often replace the file instead of writing to it so the directory is what gets watched
+    std::unordered_map<int, std::string> m_directories;
+#else
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_write_times;
+#endif
+};
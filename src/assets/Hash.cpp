@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "Hash.h"
+#include "FileSystem.h"
+
+#include <cstring>
+
+static constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read_u64(const unsigned char* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t read_u32(const unsigned char* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input)
+{
+    acc += input * PRIME_2;
+    acc = rotl(acc, 31);
+    return acc * PRIME_1;
+}
+
+static inline uint64_t merge_round(uint64_t acc, uint64_t val)
+{
+    acc ^= hash_round(0, val);
+    return acc * PRIME_1 + PRIME_4;
+}
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed)
+{
+    const auto* p = (const unsigned char*)data;
+    const unsigned char* end = p + size;
+    uint64_t h;
+
+    if (size >= 32)
+    {
+        const unsigned char* limit = end - 32;
+        uint64_t v1 = seed + PRIME_1 + PRIME_2;
+        uint64_t v2 = seed + PRIME_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME_1;
+
+        do
+        {
+            v1 = hash_round(v1, read_u64(p)); p += 8;
+            v2 = hash_round(v2, read_u64(p)); p += 8;
+            v3 = hash_round(v3, read_u64(p)); p += 8;
+            v4 = hash_round(v4, read_u64(p)); p += 8;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge_round(h, v1);
+        h = merge_round(h, v2);
+        h = merge_round(h, v3);
+        h = merge_round(h, v4);
+    }
+    else
+    {
+        h = seed + PRIME_5;
+    }
+
+    h += (uint64_t)size;
+
+    while (p + 8 <= end)
+    {
+        h ^= hash_round(0, read_u64(p));
+        h = rotl(h, 27) * PRIME_1 + PRIME_4;
+        p += 8;
+    }
+
+    if (p + 4 <= end)
+    {
+        h ^= (uint64_t)read_u32(p) * PRIME_1;
+        h = rotl(h, 23) * PRIME_2 + PRIME_3;
+        p += 4;
+    }
+
+    while (p < end)
+    {
+        h ^= (*p) * PRIME_5;
+        h = rotl(h, 11) * PRIME_1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME_2;
+    h ^= h >> 29;
+    h *= PRIME_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+uint64_t hash_string(const std::string& str, uint64_t seed)
+{
+    return hash_bytes(str.data(), str.size(), seed);
+}
+
+uint64_t hash_combine(uint64_t h, uint64_t value)
+{
+    return hash_bytes(&value, sizeof(value), h);
+}
+
+uint64_t hash_file(const std::string& file_path)
+{
+    FileView file = FileSystem::map(file_path);
+
+    if (!file)
+        return 0;
+
+    return hash_bytes(file.data(), file.size());
+}
+
+std::string hash_to_string(uint64_t h)
+{
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+    return buf;
+}
+
+uint64_t string_to_hash(const std::string& str)
+{
+    return std::strtoull(str.c_str(), nullptr, 16);
+}
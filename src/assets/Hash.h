@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// 64 bit content hash (xxHash64), used to tell if an asset has changed
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0);
+uint64_t hash_string(const std::string& str, uint64_t seed = 0);
+uint64_t hash_combine(uint64_t h, uint64_t value);
+
+// returns 0 if the file could not be read
+uint64_t hash_file(const std::string& file_path);
+
+std::string hash_to_string(uint64_t h);
+uint64_t string_to_hash(const std::string& str);
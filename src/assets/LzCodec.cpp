@@ -0,0 +1,192 @@
+#include "pch.h"
+#include "LzCodec.h"
+
+#include <cstring>
+
+static constexpr size_t LZ_MIN_MATCH = 4;
+static constexpr size_t LZ_MAX_OFFSET = 65535;
+static constexpr size_t LZ_HASH_BITS = 16;
+
+// the block always ends in literals and no match starts too close to the end, same as LZ4
+static constexpr size_t LZ_LAST_LITERALS = 5;
+static constexpr size_t LZ_MATCH_LIMIT = 12;
+
+static constexpr uint32_t LZ_NO_POSITION = UINT32_MAX;
+
+static uint32_t read_u32(const unsigned char* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash_sequence(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// lengths that don't fit in the token carry on in bytes of 255 and end with a smaller one
+static void write_length(std::vector<unsigned char>& out, size_t length)
+{
+    while (length >= 255)
+    {
+        out.push_back(255);
+        length -= 255;
+    }
+
+    out.push_back((unsigned char)length);
+}
+
+static void write_sequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literal_length, size_t offset, size_t match_length)
+{
+    size_t match_code = (match_length == 0) ? 0 : match_length - LZ_MIN_MATCH;
+
+    unsigned char token = (unsigned char)((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(match_code, 15));
+    out.push_back(token);
+
+    if (literal_length >= 15)
+        write_length(out, literal_length - 15);
+
+    out.insert(out.end(), literals, literals + literal_length);
+
+    // the last sequence is literals only
+    if (match_length == 0)
+        return;
+
+    out.push_back((unsigned char)(offset & 0xff));
+    out.push_back((unsigned char)(offset >> 8));
+
+    if (match_code >= 15)
+        write_length(out, match_code - 15);
+}
+
+bool lz_compress(const unsigned char* src, size_t size, std::vector<unsigned char>& out)
+{
+    out.clear();
+    out.reserve(size);
+
+    size_t anchor = 0;
+
+    if (size > LZ_MATCH_LIMIT)
+    {
+        std::vector<uint32_t> table((size_t)1 << LZ_HASH_BITS, LZ_NO_POSITION);
+
+        size_t limit = size - LZ_MATCH_LIMIT;
+        size_t match_end_limit = size - LZ_LAST_LITERALS;
+        size_t i = 0;
+
+        while (i < limit)
+        {
+            uint32_t sequence = read_u32(src + i);
+            uint32_t h = hash_sequence(sequence);
+            size_t candidate = table[h];
+            table[h] = (uint32_t)i;
+
+            if (candidate == LZ_NO_POSITION || i - candidate > LZ_MAX_OFFSET || read_u32(src + candidate) != sequence)
+            {
+                ++i;
+                continue;
+            }
+
+            size_t length = LZ_MIN_MATCH;
+            while (i + length < match_end_limit && src[candidate + length] == src[i + length])
+                ++length;
+
+            // the match might have started a bit earlier than where it was found
+            while (i > anchor && candidate > 0 && src[i - 1] == src[candidate - 1])
+            {
+                --i;
+                --candidate;
+                ++length;
+            }
+
+            write_sequence(out, src + anchor, i - anchor, i - candidate, length);
+
+            i += length;
+            anchor = i;
+
+            // no point carrying on once it's clear the chunk won't shrink
+            if (out.size() >= size)
+                return false;
+        }
+    }
+
+    write_sequence(out, src + anchor, size - anchor, 0, 0);
+
+    return out.size() < size;
+}
+
+static bool read_length(const unsigned char*& ip, const unsigned char* end, size_t& length)
+{
+    unsigned char b;
+    do
+    {
+        if (ip >= end)
+            return false;
+
+        b = *ip++;
+        length += b;
+    } while (b == 255);
+
+    return true;
+}
+
+bool lz_decompress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size)
+{
+    const unsigned char* ip = src;
+    const unsigned char* ip_end = src + src_size;
+    unsigned char* op = dst;
+    unsigned char* op_end = dst + dst_size;
+
+    while (ip < ip_end)
+    {
+        unsigned char token = *ip++;
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(ip, ip_end, literal_length))
+            return false;
+
+        if (literal_length > (size_t)(ip_end - ip) || literal_length > (size_t)(op_end - op))
+            return false;
+
+        std::memcpy(op, ip, literal_length);
+        ip += literal_length;
+        op += literal_length;
+
+        if (ip == ip_end)
+            break;
+
+        if (ip_end - ip < 2)
+            return false;
+
+        size_t offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+
+        if (offset == 0 || offset > (size_t)(op - dst))
+            return false;
+
+        size_t match_length = token & 15;
+        if (match_length == 15 && !read_length(ip, ip_end, match_length))
+            return false;
+
+        match_length += LZ_MIN_MATCH;
+        if (match_length > (size_t)(op_end - op))
+            return false;
+
+        const unsigned char* match = op - offset;
+
+        // overlapping matches repeat the bytes just written so they have to go one at a time
+        if (offset >= match_length)
+        {
+            std::memcpy(op, match, match_length);
+            op += match_length;
+        }
+        else
+        {
+            for (size_t i = 0; i < match_length; ++i)
+                *op++ = match[i];
+        }
+    }
+
+    return op == op_end;
+}
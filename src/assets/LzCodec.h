@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// byte oriented LZ77 in the LZ4 block layout: a token with literal and match lengths, the literals, then a 16 bit offset
+// fast enough to decode on load, the encoder is a single pass with a hash table of the last position of every 4 bytes
+
+// false if the data didn't get any smaller, out is only valid on success
+bool lz_compress(const unsigned char* src, size_t size, std::vector<unsigned char>& out);
+
+// dst_size has to be exactly the uncompressed size, anything malformed is rejected instead of read or written out of bounds
+bool lz_decompress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size);
@@ -0,0 +1,181 @@
+#include "pch.h"
+#include "MeshData.h"
+#include "FileSystem.h"
+#include "AssimpIO.h"
+
+#include <cstring>
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+struct CookedMeshHeader
+{
+    char magic[4] = { 'T', 'B', 'M', 'S' };
+    uint32_t version = 2;
+    uint32_t vertex_float_count = 0;
+    uint32_t index_count = 0;
+};
+
+MeshData mesh_data_from_assimp(const aiMesh* mesh)
+{
+    MeshData mesh_data;
+    mesh_data.vertices.reserve(mesh->mNumVertices * 8);
+
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+    {
+        mesh_data.vertices.push_back(mesh->mVertices[i].x);
+        mesh_data.vertices.push_back(mesh->mVertices[i].y);
+        mesh_data.vertices.push_back(mesh->mVertices[i].z);
+        mesh_data.vertices.push_back(mesh->mNormals[i].x);
+        mesh_data.vertices.push_back(mesh->mNormals[i].y);
+        mesh_data.vertices.push_back(mesh->mNormals[i].z);
+        mesh_data.vertices.push_back(mesh->mTextureCoords[0][i].x);
+        mesh_data.vertices.push_back(mesh->mTextureCoords[0][i].y);
+    }
+
+    mesh_data.indices.reserve(mesh->mNumFaces * 3);
+
+    for (unsigned int i = 0; i < mesh->mNumFaces; ++i)
+    {
+        for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; ++j)
+        {
+            mesh_data.indices.push_back(mesh->mFaces[i].mIndices[j]);
+        }
+    }
+
+    return mesh_data;
+}
+
+void material_textures_from_assimp(const aiScene* scene, std::string textures[4])
+{
+    for (int i = 0; i < 4; ++i)
+        textures[i].clear();
+
+    if (!scene || scene->mNumMaterials == 0 || !scene->mMaterials[0])
+        return;
+
+    const aiTextureType types[4] = { aiTextureType_DIFFUSE, aiTextureType_SPECULAR, aiTextureType_NORMALS, aiTextureType_AMBIENT };
+    for (int i = 0; i < 4; ++i)
+    {
+        aiString path;
+        if (scene->mMaterials[0]->GetTexture(types[i], 0, &path) == AI_SUCCESS)
+            textures[i] = path.C_Str();
+    }
+}
+
+bool import_mesh_data(const std::string& file_path, MeshData& mesh_data)
+{
+    Assimp::Importer importer;
+    importer.SetIOHandler(new AssimpIOSystem);
+    const aiScene* scene = importer.ReadFile(file_path,
+                                             aiProcess_CalcTangentSpace       |
+                                             aiProcess_Triangulate            |
+                                             aiProcess_JoinIdenticalVertices  |
+                                             aiProcess_SortByPType);
+
+    if (!scene || scene->mNumMeshes == 0)
+        return false;
+
+    mesh_data = mesh_data_from_assimp(scene->mMeshes[0]);
+    material_textures_from_assimp(scene, mesh_data.textures);
+    return true;
+}
+
+bool write_cooked_mesh(const std::string& file_path, const MeshData& mesh_data)
+{
+    std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+
+    if (!out)
+        return false;
+
+    CookedMeshHeader header;
+    header.vertex_float_count = (uint32_t)mesh_data.vertices.size();
+    header.index_count = (uint32_t)mesh_data.indices.size();
+
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)mesh_data.vertices.data(), (std::streamsize)(mesh_data.vertices.size() * sizeof(float)));
+    out.write((const char*)mesh_data.indices.data(), (std::streamsize)(mesh_data.indices.size() * sizeof(unsigned int)));
+
+    // texture paths go last, each as its length followed by the characters
+    for (const std::string& texture : mesh_data.textures)
+    {
+        auto length = (uint32_t)texture.size();
+        out.write((const char*)&length, sizeof(length));
+        out.write(texture.data(), (std::streamsize)length);
+    }
+
+    return out.good();
+}
+
+static bool read_cooked_header(const FileView& file, CookedMeshHeader& header)
+{
+    if (file.size() < sizeof(CookedMeshHeader))
+        return false;
+
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, "TBMS", 4) != 0 || header.version != CookedMeshHeader{}.version)
+        return false;
+
+    uint64_t vertex_bytes = (uint64_t)header.vertex_float_count * sizeof(float);
+    uint64_t index_bytes = (uint64_t)header.index_count * sizeof(unsigned int);
+    return file.size() - sizeof(header) >= vertex_bytes + index_bytes;
+}
+
+static bool read_textures(const FileView& file, uint64_t offset, std::string textures[4])
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        uint32_t length = 0;
+        if (file.size() - offset < sizeof(length))
+            return false;
+
+        std::memcpy(&length, file.data() + offset, sizeof(length));
+        offset += sizeof(length);
+
+        if (file.size() - offset < length)
+            return false;
+
+        textures[i].assign((const char*)file.data() + offset, length);
+        offset += length;
+    }
+
+    return true;
+}
+
+bool read_cooked_mesh(const std::string& file_path, MeshData& mesh_data)
+{
+    FileView file = FileSystem::map(file_path);
+
+    CookedMeshHeader header;
+    if (!read_cooked_header(file, header))
+        return false;
+
+    uint64_t vertex_bytes = (uint64_t)header.vertex_float_count * sizeof(float);
+    uint64_t index_bytes = (uint64_t)header.index_count * sizeof(unsigned int);
+
+    if (!read_textures(file, sizeof(header) + vertex_bytes + index_bytes, mesh_data.textures))
+        return false;
+
+    const unsigned char* data = file.data() + sizeof(header);
+    mesh_data.vertices.resize(header.vertex_float_count);
+    mesh_data.indices.resize(header.index_count);
+
+    std::memcpy(mesh_data.vertices.data(), data, vertex_bytes);
+    std::memcpy(mesh_data.indices.data(), data + vertex_bytes, index_bytes);
+
+    return true;
+}
+
+bool read_cooked_mesh_textures(const std::string& file_path, std::string textures[4])
+{
+    FileView file = FileSystem::map(file_path);
+
+    CookedMeshHeader header;
+    if (!read_cooked_header(file, header))
+        return false;
+
+    uint64_t vertex_bytes = (uint64_t)header.vertex_float_count * sizeof(float);
+    uint64_t index_bytes = (uint64_t)header.index_count * sizeof(unsigned int);
+    return read_textures(file, sizeof(header) + vertex_bytes + index_bytes, textures);
+}
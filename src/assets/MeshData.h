@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct aiMesh;
+struct aiScene;
+
+// cpu side mesh data, interleaved as position (3), normal (3), uv (2)
+struct MeshData
+{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    // base colour, specular, normal map and occlusion of the first material, relative to the model file and empty when it has none
+    std::string textures[4];
+};
+
+MeshData mesh_data_from_assimp(const aiMesh* mesh);
+void material_textures_from_assimp(const aiScene* scene, std::string textures[4]);
+
+// loads the first mesh in a model file without touching any GL state
+bool import_mesh_data(const std::string& file_path, MeshData& mesh_data);
+
+bool write_cooked_mesh(const std::string& file_path, const MeshData& mesh_data);
+bool read_cooked_mesh(const std::string& file_path, MeshData& mesh_data);
+// just the texture paths, the geometry is skipped over
+bool read_cooked_mesh_textures(const std::string& file_path, std::string textures[4]);
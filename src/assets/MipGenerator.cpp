@@ -0,0 +1,395 @@
+#include "pch.h"
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define MIP_GENERATOR_SSE
+#include <emmintrin.h>
+#endif
+
+// destination rows handled per task, the source rows a band needs are only filtered horizontally once
+static constexpr uint32_t BAND_HEIGHT = 16;
+
+static constexpr float KAISER_RADIUS = 2.f; // in destination pixels
+static constexpr float KAISER_ALPHA = 4.f;
+
+// which source pixels feed each destination pixel along one axis
+struct FilterTaps
+{
+    uint32_t count = 0;
+    std::vector<int> first;
+    std::vector<float> weights; // count per destination pixel
+};
+
+static float sinc(float x)
+{
+    if (std::fabs(x) < 1e-5f)
+        return 1.f;
+
+    x *= 3.14159265f;
+    return std::sin(x) / x;
+}
+
+// zeroth order modified Bessel function of the first kind
+static float bessel_i0(float x)
+{
+    float sum = 1.f, term = 1.f;
+    for (int k = 1; k < 20; ++k)
+    {
+        term *= (x / (2.f * (float)k)) * (x / (2.f * (float)k));
+        sum += term;
+    }
+
+    return sum;
+}
+
+static float kaiser(float t)
+{
+    if (std::fabs(t) > 1.f)
+        return 0.f;
+
+    return bessel_i0(KAISER_ALPHA * std::sqrt(1.f - t * t)) / bessel_i0(KAISER_ALPHA);
+}
+
+static FilterTaps build_taps(MipFilter filter, uint32_t src_size, uint32_t dst_size)
+{
+    FilterTaps taps;
+
+    if (filter == MipFilter::Box)
+    {
+        taps.count = 2;
+        for (uint32_t d = 0; d < dst_size; ++d)
+        {
+            taps.first.push_back((int)d * 2);
+            taps.weights.push_back(0.5f);
+            taps.weights.push_back(0.5f);
+        }
+
+        return taps;
+    }
+
+    float scale = (float)src_size / (float)dst_size;
+    float src_radius = KAISER_RADIUS * scale;
+    taps.count = (uint32_t)std::ceil(src_radius * 2.f) + 1;
+
+    for (uint32_t d = 0; d < dst_size; ++d)
+    {
+        float centre = ((float)d + 0.5f) * scale;
+        int first = (int)std::floor(centre - src_radius);
+        taps.first.push_back(first);
+
+        float total = 0.f;
+        size_t start = taps.weights.size();
+        for (uint32_t k = 0; k < taps.count; ++k)
+        {
+            float x = ((float)(first + (int)k) + 0.5f - centre) / scale;
+            float w = sinc(x) * kaiser(x / KAISER_RADIUS);
+            taps.weights.push_back(w);
+            total += w;
+        }
+
+        for (uint32_t k = 0; k < taps.count; ++k)
+            taps.weights[start + k] /= total;
+    }
+
+    return taps;
+}
+
+static const float* srgb_to_linear_table()
+{
+    static const auto table = []()
+    {
+        std::array<float, 256> t{};
+        for (int i = 0; i < 256; ++i)
+        {
+            float c = (float)i / 255.f;
+            t[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+
+    return table.data();
+}
+
+// indexed by linear value * 65535, fine enough that dark values still round trip
+static const unsigned char* linear_to_srgb_table()
+{
+    static const auto table = []()
+    {
+        std::vector<unsigned char> t(65536);
+        for (size_t i = 0; i < t.size(); ++i)
+        {
+            float c = (float)i / 65535.f;
+            float s = (c <= 0.0031308f) ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+            t[i] = (unsigned char)std::lround(std::clamp(s, 0.f, 1.f) * 255.f);
+        }
+        return t;
+    }();
+
+    return table.data();
+}
+
+enum class PixelSpace
+{
+    Linear,
+    SRGB,
+    Normal
+};
+
+static void decode_row(const unsigned char* src, uint32_t width, PixelSpace space, float* out)
+{
+    const float* to_linear = srgb_to_linear_table();
+
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            unsigned char v = src[x * 4 + c];
+
+            switch (space)
+            {
+                case PixelSpace::Linear: out[x * 4 + c] = (float)v / 255.f; break;
+                case PixelSpace::SRGB:   out[x * 4 + c] = to_linear[v]; break;
+                case PixelSpace::Normal: out[x * 4 + c] = (float)v / 127.5f - 1.f; break;
+            }
+        }
+
+        out[x * 4 + 3] = (float)src[x * 4 + 3] / 255.f;
+    }
+}
+
+static void encode_row(const float* row, uint32_t width, PixelSpace space, unsigned char* dst)
+{
+    const unsigned char* to_srgb = linear_to_srgb_table();
+
+    for (uint32_t x = 0; x < width; ++x)
+    {
+        float r = row[x * 4 + 0], g = row[x * 4 + 1], b = row[x * 4 + 2];
+
+        if (space == PixelSpace::Normal)
+        {
+            float length = std::sqrt(r * r + g * g + b * b);
+            if (length > 1e-6f)
+            {
+                r /= length; g /= length; b /= length;
+            }
+
+            dst[x * 4 + 0] = (unsigned char)std::lround(std::clamp(r * 0.5f + 0.5f, 0.f, 1.f) * 255.f);
+            dst[x * 4 + 1] = (unsigned char)std::lround(std::clamp(g * 0.5f + 0.5f, 0.f, 1.f) * 255.f);
+            dst[x * 4 + 2] = (unsigned char)std::lround(std::clamp(b * 0.5f + 0.5f, 0.f, 1.f) * 255.f);
+        }
+        else if (space == PixelSpace::SRGB)
+        {
+            dst[x * 4 + 0] = to_srgb[std::lround(std::clamp(r, 0.f, 1.f) * 65535.f)];
+            dst[x * 4 + 1] = to_srgb[std::lround(std::clamp(g, 0.f, 1.f) * 65535.f)];
+            dst[x * 4 + 2] = to_srgb[std::lround(std::clamp(b, 0.f, 1.f) * 65535.f)];
+        }
+        else
+        {
+            dst[x * 4 + 0] = (unsigned char)std::lround(std::clamp(r, 0.f, 1.f) * 255.f);
+            dst[x * 4 + 1] = (unsigned char)std::lround(std::clamp(g, 0.f, 1.f) * 255.f);
+            dst[x * 4 + 2] = (unsigned char)std::lround(std::clamp(b, 0.f, 1.f) * 255.f);
+        }
+
+        dst[x * 4 + 3] = (unsigned char)std::lround(std::clamp(row[x * 4 + 3], 0.f, 1.f) * 255.f);
+    }
+}
+
+// out = sum of rows[k][x] * weights[k], every pixel is four floats
+static void weighted_sum(const float* const* pixels, const float* weights, uint32_t count, float* out)
+{
+#ifdef MIP_GENERATOR_SSE
+    __m128 sum = _mm_setzero_ps();
+    for (uint32_t k = 0; k < count; ++k)
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pixels[k]), _mm_set1_ps(weights[k])));
+
+    _mm_storeu_ps(out, sum);
+#else
+    float sum[4] = {};
+    for (uint32_t k = 0; k < count; ++k)
+        for (uint32_t c = 0; c < 4; ++c)
+            sum[c] += pixels[k][c] * weights[k];
+
+    std::copy(sum, sum + 4, out);
+#endif
+}
+
+static void downsample_band(const unsigned char* src, uint32_t src_width, uint32_t src_height, unsigned char* dst, uint32_t dst_width,
+                            uint32_t y_begin, uint32_t y_end, const FilterTaps& x_taps, const FilterTaps& y_taps, PixelSpace space)
+{
+    auto clamp_row = [&](int y) { return (uint32_t)std::clamp(y, 0, (int)src_height - 1); };
+    auto clamp_col = [&](int x) { return (uint32_t)std::clamp(x, 0, (int)src_width - 1); };
+
+    int first_row = y_taps.first[y_begin];
+    int last_row = y_taps.first[y_end - 1] + (int)y_taps.count - 1;
+    uint32_t band_rows = (uint32_t)(last_row - first_row + 1);
+
+    std::vector<float> decoded(src_width * 4);
+    std::vector<float> filtered((size_t)band_rows * dst_width * 4);
+    std::vector<const float*> taps(std::max(x_taps.count, y_taps.count));
+
+    // horizontal pass over every source row the band touches
+    for (uint32_t r = 0; r < band_rows; ++r)
+    {
+        decode_row(src + (size_t)clamp_row(first_row + (int)r) * src_width * 4, src_width, space, decoded.data());
+
+        for (uint32_t x = 0; x < dst_width; ++x)
+        {
+            for (uint32_t k = 0; k < x_taps.count; ++k)
+                taps[k] = decoded.data() + clamp_col(x_taps.first[x] + (int)k) * 4;
+
+            weighted_sum(taps.data(), x_taps.weights.data() + (size_t)x * x_taps.count, x_taps.count, filtered.data() + ((size_t)r * dst_width + x) * 4);
+        }
+    }
+
+    // vertical pass, the band rows already repeat the edge where the taps run off the image
+    std::vector<float> row(dst_width * 4);
+    for (uint32_t y = y_begin; y < y_end; ++y)
+    {
+        for (uint32_t x = 0; x < dst_width; ++x)
+        {
+            for (uint32_t k = 0; k < y_taps.count; ++k)
+            {
+                auto band_row = (size_t)(y_taps.first[y] + (int)k - first_row);
+                taps[k] = filtered.data() + (band_row * dst_width + x) * 4;
+            }
+
+            weighted_sum(taps.data(), y_taps.weights.data() + (size_t)y * y_taps.count, y_taps.count, row.data() + x * 4);
+        }
+
+        encode_row(row.data(), dst_width, space, dst + (size_t)y * dst_width * 4);
+    }
+}
+
+bool is_cut_out(const unsigned char* rgba, uint64_t pixel_count)
+{
+    uint64_t transparent = 0;
+    for (uint64_t i = 0; i < pixel_count; ++i)
+        transparent += (rgba[i * 4 + 3] == 0);
+
+    // soft edges are fine, the alpha test only cares about the holes
+    return transparent >= pixel_count / 20;
+}
+
+// fraction of pixels that pass the alpha test once alpha is multiplied by scale
+static float alpha_coverage(const uint64_t histogram[256], uint64_t pixel_count, float scale)
+{
+    uint64_t covered = 0;
+    for (int a = 0; a < 256; ++a)
+    {
+        if ((float)a * scale / 255.f >= ALPHA_TEST_CUTOFF)
+            covered += histogram[a];
+    }
+
+    return (float)covered / (float)pixel_count;
+}
+
+static void alpha_histogram(const unsigned char* rgba, uint64_t pixel_count, uint64_t histogram[256])
+{
+    std::fill(histogram, histogram + 256, 0);
+    for (uint64_t i = 0; i < pixel_count; ++i)
+        ++histogram[rgba[i * 4 + 3]];
+}
+
+// filtering spreads alpha out so cut-outs get thicker with every mip, scale alpha back until the coverage matches
+static void preserve_coverage(unsigned char* rgba, uint64_t pixel_count, float target_coverage)
+{
+    uint64_t histogram[256];
+    alpha_histogram(rgba, pixel_count, histogram);
+
+    float low = 0.f, high = 4.f;
+    for (int iter = 0; iter < 16; ++iter)
+    {
+        float mid = (low + high) * 0.5f;
+        if (alpha_coverage(histogram, pixel_count, mid) > target_coverage)
+            high = mid;
+        else
+            low = mid;
+    }
+
+    float scale = (low + high) * 0.5f;
+    for (uint64_t i = 0; i < pixel_count; ++i)
+        rgba[i * 4 + 3] = (unsigned char)std::min(255.f, std::round((float)rgba[i * 4 + 3] * scale));
+}
+
+void generate_mips(TextureData& texture, MipFilter filter)
+{
+    if (texture.format != PixelFormat::RGBA8)
+        return;
+
+    PixelSpace space = PixelSpace::Linear;
+    if (texture.flags & TextureFlags::NormalMap)
+        space = PixelSpace::Normal;
+    else if (texture.flags & TextureFlags::SRGB)
+        space = PixelSpace::SRGB;
+
+    uint32_t num_levels = mip_count(texture.width, texture.height);
+
+    // lay the chain out again face by face, the top levels are carried over
+    std::vector<MipLevel> levels;
+    uint64_t total_size = 0;
+    for (uint32_t face = 0; face < texture.faces; ++face)
+    {
+        uint32_t width = texture.width, height = texture.height;
+        for (uint32_t i = 0; i < num_levels; ++i)
+        {
+            uint64_t size = level_size(PixelFormat::RGBA8, width, height);
+            levels.push_back({ width, height, total_size, size });
+            total_size += size;
+
+            width = std::max(1u, width / 2);
+            height = std::max(1u, height / 2);
+        }
+    }
+
+    std::vector<unsigned char> pixels(total_size);
+    for (uint32_t face = 0; face < texture.faces; ++face)
+    {
+        const MipLevel& top = texture.level(face, 0);
+        std::memcpy(pixels.data() + levels[face * num_levels].offset, texture.level_data(face, 0), top.size);
+    }
+
+    for (uint32_t face = 0; face < texture.faces; ++face)
+    {
+        const MipLevel& top = levels[face * num_levels];
+        uint64_t top_pixels = (uint64_t)top.width * top.height;
+
+        bool cut_out = (texture.flags & TextureFlags::CutOut) != 0;
+        float target_coverage = 0.f;
+        if (cut_out)
+        {
+            uint64_t histogram[256];
+            alpha_histogram(pixels.data() + top.offset, top_pixels, histogram);
+            target_coverage = alpha_coverage(histogram, top_pixels, 1.f);
+        }
+
+        for (uint32_t i = 1; i < num_levels; ++i)
+        {
+            const MipLevel& src = levels[face * num_levels + i - 1];
+            const MipLevel& dst = levels[face * num_levels + i];
+
+            FilterTaps x_taps = build_taps(filter, src.width, dst.width);
+            FilterTaps y_taps = build_taps(filter, src.height, dst.height);
+
+            uint32_t num_bands = (dst.height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+            ThreadPool::get().parallel_for(num_bands, [&](size_t band)
+            {
+                uint32_t y_begin = (uint32_t)band * BAND_HEIGHT;
+                uint32_t y_end = std::min(dst.height, y_begin + BAND_HEIGHT);
+                downsample_band(pixels.data() + src.offset, src.width, src.height, pixels.data() + dst.offset, dst.width, y_begin, y_end, x_taps, y_taps, space);
+            });
+
+            if (cut_out)
+                preserve_coverage(pixels.data() + dst.offset, (uint64_t)dst.width * dst.height, target_coverage);
+        }
+    }
+
+    texture.num_levels = num_levels;
+    texture.levels = std::move(levels);
+    texture.pixels = std::move(pixels);
+    texture.mapped_pixels.reset();
+}
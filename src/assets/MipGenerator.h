@@ -0,0 +1,19 @@
+#pragma once
+
+#include "TextureData.h"
+
+enum class MipFilter : uint32_t
+{
+    Box,   // plain 2x2 average
+    Kaiser // windowed sinc, keeps distant mips sharper
+};
+
+// alpha below this is discarded by the lit shaders, cut-out textures keep the same coverage at it on every mip
+static constexpr float ALPHA_TEST_CUTOFF = 0.01f;
+
+// true when a noticeable part of the image is fully transparent, i.e. it relies on the alpha test to cut holes
+bool is_cut_out(const unsigned char* rgba, uint64_t pixel_count);
+
+// fills in every level after the first from the one before it, the first level has to already be in place
+// sRGB data is filtered in linear space, normal maps are renormalized and cut-outs keep their alpha coverage
+void generate_mips(TextureData& texture, MipFilter filter = MipFilter::Kaiser);
@@ -0,0 +1,775 @@
+#include "pch.h"
+#include "SceneData.h"
+#include "FileSystem.h"
+#include "Log.h"
+
+#include <cstring>
+#include <map>
+#include <nlohmann/json.hpp>
+
+using namespace nlohmann;
+
+// every section starts on this boundary so the records can be read straight out of the mapping
+static constexpr uint64_t SCENE_SECTION_ALIGNMENT = 8;
+
+// material slots in the order the json names them
+static const char* MATERIAL_TEXTURE_NAMES[4] = { "base_colour", "specular", "normal_map", "occlusion" };
+
+static uint64_t align_section(uint64_t offset)
+{
+    return (offset + SCENE_SECTION_ALIGNMENT - 1) & ~(SCENE_SECTION_ALIGNMENT - 1);
+}
+
+static bool section_in_bounds(uint64_t offset, uint64_t size, uint64_t file_size)
+{
+    return offset % SCENE_SECTION_ALIGNMENT == 0 && offset <= file_size && size <= file_size - offset;
+}
+
+bool SceneView::open(const std::string& file_path)
+{
+    FileView file = FileSystem::map(file_path);
+    if (file.size() < sizeof(SceneHeader))
+        return false;
+
+    m_file = file.share();
+    m_bytes.clear();
+    m_data = m_file.get();
+    m_size = file.size();
+
+    return validate();
+}
+
+bool SceneView::open(std::vector<unsigned char>&& bytes)
+{
+    m_file.reset();
+    m_bytes = std::move(bytes);
+    m_data = m_bytes.data();
+    m_size = m_bytes.size();
+
+    return validate();
+}
+
+const char* SceneView::string(uint32_t offset) const
+{
+    if (offset == SCENE_NONE)
+        return "";
+
+    return (const char*)(m_data + header().string_offset + offset);
+}
+
+bool SceneView::validate()
+{
+    if (m_size < sizeof(SceneHeader))
+        return false;
+
+    const SceneHeader& h = header();
+    if (std::memcmp(h.magic, SceneHeader{}.magic, 4) != 0 || h.version != SceneHeader{}.version)
+        return false;
+
+    if (!section_in_bounds(h.node_offset, (uint64_t)h.node_count * sizeof(SceneNodeRecord), m_size) ||
+        !section_in_bounds(h.asset_offset, (uint64_t)h.asset_count * sizeof(SceneAssetRecord), m_size) ||
+        !section_in_bounds(h.blob_offset, h.blob_size, m_size) ||
+        !section_in_bounds(h.string_offset, h.string_size, m_size))
+        return false;
+
+    // the last string has to be terminated so nothing can read past the table
+    if (h.string_size == 0 || m_data[h.string_offset + h.string_size - 1] != '\0')
+        return false;
+
+    auto valid_string = [&](uint32_t offset) { return offset == SCENE_NONE || offset < h.string_size; };
+    auto valid_asset = [&](uint32_t index) { return index == SCENE_NONE || index < h.asset_count; };
+    auto valid_blob = [&](uint32_t offset, size_t size) { return offset == SCENE_NONE || (offset % 4 == 0 && offset + size <= h.blob_size); };
+
+    if (!valid_string(h.skybox_path))
+        return false;
+
+    for (uint32_t i = 0; i < h.asset_count; ++i)
+    {
+        if (!valid_string(asset(i).type) || !valid_string(asset(i).path))
+            return false;
+    }
+
+    for (uint32_t i = 0; i < h.node_count; ++i)
+    {
+        const SceneNodeRecord& record = node(i);
+
+        // parents come first so the loader can build the tree in a single pass
+        if (!valid_string(record.name) || (record.parent != SCENE_NONE && record.parent >= i))
+            return false;
+
+        if (!valid_blob(record.transform, sizeof(TransformBlob)) || !valid_blob(record.light, sizeof(LightBlob)) ||
+            !valid_blob(record.mesh, sizeof(MeshBlob)) || !valid_blob(record.material, sizeof(MaterialBlob)))
+            return false;
+
+        if (const auto* mesh = blob<MeshBlob>(record.mesh); mesh && !valid_asset(mesh->asset))
+            return false;
+
+        if (const auto* material = blob<MaterialBlob>(record.material))
+        {
+            if (!valid_string(material->shader))
+                return false;
+
+            for (uint32_t texture : material->textures)
+            {
+                if (!valid_asset(texture))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// goes through the file system so scenes inside mounted archives are recognised too
+bool is_binary_scene(const std::string& file_path)
+{
+    FileView file = FileSystem::map(file_path);
+    return file.size() >= 4 && std::memcmp(file.data(), SceneHeader{}.magic, 4) == 0;
+}
+
+// builds the sections separately and lays them out at the end, strings and assets are deduplicated
+class SceneWriter
+{
+public:
+    // the string table is never empty, which keeps the terminator check simple
+    SceneWriter() { add_string(""); }
+
+    uint32_t add_string(const std::string& str)
+    {
+        auto [it, inserted] = m_string_offsets.try_emplace(str, (uint32_t)m_strings.size());
+        if (inserted)
+            m_strings.insert(m_strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+
+        return it->second;
+    }
+
+    uint32_t add_asset(const std::string& type, const std::string& path)
+    {
+        auto [it, inserted] = m_asset_indices.try_emplace({ type, path }, (uint32_t)m_assets.size());
+        if (inserted)
+            m_assets.push_back({ add_string(type), add_string(path) });
+
+        return it->second;
+    }
+
+    template<typename T>
+    uint32_t add_blob(const T& blob)
+    {
+        static_assert(sizeof(T) % 4 == 0);
+
+        auto offset = (uint32_t)m_blobs.size();
+        m_blobs.insert(m_blobs.end(), (const unsigned char*)&blob, (const unsigned char*)&blob + sizeof(T));
+        return offset;
+    }
+
+    void write(SceneHeader& header, std::vector<unsigned char>& bytes) const
+    {
+        header.node_count = (uint32_t)nodes.size();
+        header.asset_count = (uint32_t)m_assets.size();
+        header.node_offset = align_section(sizeof(SceneHeader));
+        header.asset_offset = align_section(header.node_offset + nodes.size() * sizeof(SceneNodeRecord));
+        header.blob_offset = align_section(header.asset_offset + m_assets.size() * sizeof(SceneAssetRecord));
+        header.blob_size = m_blobs.size();
+        header.string_offset = align_section(header.blob_offset + m_blobs.size());
+        header.string_size = m_strings.size();
+
+        bytes.assign(header.string_offset + header.string_size, 0);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.data() + header.node_offset, nodes.data(), nodes.size() * sizeof(SceneNodeRecord));
+        std::memcpy(bytes.data() + header.asset_offset, m_assets.data(), m_assets.size() * sizeof(SceneAssetRecord));
+        std::memcpy(bytes.data() + header.blob_offset, m_blobs.data(), m_blobs.size());
+        std::memcpy(bytes.data() + header.string_offset, m_strings.data(), m_strings.size());
+    }
+
+    std::vector<SceneNodeRecord> nodes;
+
+private:
+    std::vector<char> m_strings;
+    std::unordered_map<std::string, uint32_t> m_string_offsets;
+    std::vector<SceneAssetRecord> m_assets;
+    std::map<std::pair<std::string, std::string>, uint32_t> m_asset_indices;
+    std::vector<unsigned char> m_blobs;
+};
+
+static void read_floats(const json& accessor, float* values, size_t count)
+{
+    if (!accessor.is_array())
+        return;
+
+    for (size_t i = 0; i < count && i < accessor.size(); ++i)
+        values[i] = accessor[i].get<float>();
+}
+
+static json float_array(const float* values, size_t count)
+{
+    json array = json::array();
+    for (size_t i = 0; i < count; ++i)
+        array.push_back(values[i]);
+
+    return array;
+}
+
+bool scene_json_to_binary(const json& scene, std::vector<unsigned char>& bytes)
+{
+    if (!scene.is_object())
+        return false;
+
+    SceneWriter writer;
+    SceneHeader header;
+
+    if (scene.contains("camera"))
+    {
+        read_floats(scene["camera"].value("position", json()), header.camera_position, 3);
+        read_floats(scene["camera"].value("forward", json()), header.camera_forward, 3);
+    }
+
+    read_floats(scene.value("background_colour", json()), header.background_colour, 4);
+
+    if (scene.contains("skybox") && scene["skybox"].is_object())
+    {
+        header.skybox_path = writer.add_string(scene["skybox"].value("path", ""));
+        header.skybox_format = scene["skybox"].value("image_format", 0u);
+    }
+
+    // binary scenes don't share nodes, placed prefabs are stored in full
+    static const json no_models = json::array();
+    json expanded = scene.contains("prefabs") ? expand_scene_prefabs(scene) : json();
+    const json& models = !expanded.is_null() ? expanded : scene.contains("models") ? scene["models"] : no_models;
+    if (!models.is_array())
+        return false;
+
+    if (!expanded.is_null())
+        header.flags |= SCENE_FLAG_PREFABS;
+
+    // the json only links parents to children, the binary format wants it the other way around
+    std::vector<uint32_t> parents(models.size(), SCENE_NONE);
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        int child_count = models[i].value("child_count", 0);
+        const json children = models[i].value("children", json::array());
+
+        for (int c = 0; c < child_count && c < (int)children.size(); ++c)
+        {
+            auto child = children[c].get<size_t>();
+            if (child <= i || child >= models.size())
+                return false;
+
+            parents[child] = (uint32_t)i;
+        }
+    }
+
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        const json& model = models[i];
+        // expanded prefab nodes have no ids of their own so positions are used throughout
+        uint32_t id = expanded.is_null() ? scene_node_id(model, i) : (uint32_t)i + 1;
+        SceneNodeRecord record{ writer.add_string(model.value("name", "no_name")), parents[i], SCENE_NONE, SCENE_NONE, SCENE_NONE, SCENE_NONE, id };
+
+        if (model.contains("transform"))
+        {
+            const json& accessor = model["transform"];
+            TransformBlob transform{ {}, { 0.f, 1.f, 0.f, 0.f }, 1.f };
+            read_floats(accessor.value("translate", json()), transform.translate, 3);
+            read_floats(accessor.value("rotation", json()), transform.rotation, 4);
+            transform.scale = accessor.value("scale", 1.f);
+
+            record.transform = writer.add_blob(transform);
+        }
+
+        // lights of an unknown type are skipped, same as when the json is loaded directly
+        std::string light_type = (model.contains("light") && model["light"].is_object()) ? model["light"].value("type", "") : "";
+        if (light_type == "point_light" || light_type == "directional_light")
+        {
+            const json& accessor = model["light"];
+            LightBlob light{ SceneLightType::Point, { 1.f, 1.f, 1.f, 1.f }, 1.f, 1.f, {}, 0 };
+            light.type = (light_type == "point_light") ? SceneLightType::Point : SceneLightType::Directional;
+
+            read_floats(accessor.value("colour", json()), light.colour, 4);
+            read_floats(accessor.value("direction", json()), light.direction, 3);
+            light.brightness = accessor.value("brightness", 1.f);
+            light.range = accessor.value("range", 1.f);
+            light.cast_shadow = accessor.value("cast_shadow", false);
+
+            record.light = writer.add_blob(light);
+        }
+
+        if (model.contains("mesh") && model["mesh"].is_object())
+        {
+            const json& accessor = model["mesh"];
+            MeshBlob mesh{};
+            mesh.asset = writer.add_asset(accessor.value("mesh_type", ""), accessor.value("mesh_name", ""));
+            mesh.instanced = accessor.value("instanced", false);
+            mesh.use_scale_outline = accessor.value("use_scale_outline", true);
+            mesh.outlining_factor = accessor.value("outlining_factor", 0.02f);
+
+            record.mesh = writer.add_blob(mesh);
+
+            if (model.contains("material") && model["material"].is_object())
+            {
+                const json& material_accessor = model["material"];
+                const json properties = material_accessor.value("properties", json::object());
+                const json textures = material_accessor.value("textures", json::object());
+
+                MaterialBlob material{};
+                material.shader = writer.add_string(material_accessor.value("shader", "default"));
+                material.texturing_mode = material_accessor.value("texturing_mode", 0u);
+                material.colour[0] = material.colour[1] = material.colour[2] = material.colour[3] = 1.f;
+                read_floats(properties.value("colour", json()), material.colour, 4);
+                material.metallic = properties.value("metallic_property", 0.f);
+                material.roughness = properties.value("roughness", 0.f);
+
+                // "none" and an empty path both mean the slot is unused
+                for (int t = 0; t < 4; ++t)
+                {
+                    std::string path = textures.value(MATERIAL_TEXTURE_NAMES[t], "");
+                    material.textures[t] = (path.empty() || path == "none") ? SCENE_NONE : writer.add_asset("texture", path);
+                }
+
+                record.material = writer.add_blob(material);
+            }
+        }
+
+        writer.nodes.push_back(record);
+    }
+
+    writer.write(header, bytes);
+    return true;
+}
+
+bool scene_binary_to_json(const SceneView& view, json& scene)
+{
+    const SceneHeader& header = view.header();
+
+    scene = json::object();
+    scene["camera"]["position"] = float_array(header.camera_position, 3);
+    scene["camera"]["forward"] = float_array(header.camera_forward, 3);
+    scene["background_colour"] = float_array(header.background_colour, 4);
+
+    if (header.skybox_path != SCENE_NONE)
+    {
+        scene["skybox"]["path"] = view.string(header.skybox_path);
+        scene["skybox"]["image_format"] = header.skybox_format;
+    }
+
+    json& models = scene["models"] = json::array();
+
+    for (uint32_t i = 0; i < header.node_count; ++i)
+    {
+        const SceneNodeRecord& record = view.node(i);
+        json model;
+        model["name"] = view.string(record.name);
+        model["id"] = record.id;
+
+        if (const auto* transform = view.blob<TransformBlob>(record.transform))
+        {
+            model["transform"]["translate"] = float_array(transform->translate, 3);
+            model["transform"]["rotation"] = float_array(transform->rotation, 4);
+            model["transform"]["scale"] = transform->scale;
+        }
+
+        if (const auto* light = view.blob<LightBlob>(record.light))
+        {
+            model["light"]["colour"] = float_array(light->colour, 4);
+            model["light"]["brightness"] = light->brightness;
+            model["light"]["cast_shadow"] = light->cast_shadow != 0;
+
+            if (light->type == SceneLightType::Point)
+            {
+                model["light"]["type"] = "point_light";
+                model["light"]["range"] = light->range;
+            }
+            else
+            {
+                model["light"]["type"] = "directional_light";
+                model["light"]["direction"] = float_array(light->direction, 3);
+            }
+        }
+
+        if (const auto* mesh = view.blob<MeshBlob>(record.mesh))
+        {
+            model["mesh"]["mesh_name"] = view.asset_path(mesh->asset);
+            model["mesh"]["mesh_type"] = view.string(view.asset(mesh->asset).type);
+            model["mesh"]["instanced"] = mesh->instanced != 0;
+            model["mesh"]["use_scale_outline"] = mesh->use_scale_outline != 0;
+            model["mesh"]["outlining_factor"] = mesh->outlining_factor;
+        }
+
+        if (const auto* material = view.blob<MaterialBlob>(record.material))
+        {
+            model["material"]["shader"] = view.string(material->shader);
+            model["material"]["texturing_mode"] = material->texturing_mode;
+            model["material"]["properties"]["colour"] = float_array(material->colour, 4);
+            model["material"]["properties"]["metallic_property"] = material->metallic;
+            model["material"]["properties"]["roughness"] = material->roughness;
+
+            for (int t = 0; t < 4; ++t)
+                model["material"]["textures"][MATERIAL_TEXTURE_NAMES[t]] = view.asset_path(material->textures[t]);
+        }
+
+        models.push_back(std::move(model));
+
+        if (record.parent != SCENE_NONE)
+        {
+            models[record.parent]["children"].push_back(i);
+            models[record.parent]["child_count"] = models[record.parent]["children"].size();
+        }
+    }
+
+    scene["model_count"] = header.node_count;
+    return true;
+}
+
+bool write_binary_scene(const std::string& file_path, const std::vector<unsigned char>& bytes)
+{
+    std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    out.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+    return out.good();
+}
+
+json prefab_node_delta(const json& node, const json& prefab_node)
+{
+    static const char* STRUCTURE_KEYS[] = { "id", "children", "child_count" };
+    auto is_structure = [](const std::string& key) { return std::find(std::begin(STRUCTURE_KEYS), std::end(STRUCTURE_KEYS), key) != std::end(STRUCTURE_KEYS); };
+
+    json delta = json::object();
+
+    for (const auto& [key, value] : node.items())
+    {
+        if (!is_structure(key) && (!prefab_node.contains(key) || prefab_node[key] != value))
+            delta[key] = value;
+    }
+
+    for (const auto& [key, value] : prefab_node.items())
+    {
+        if (!is_structure(key) && !node.contains(key))
+            delta[key] = nullptr;
+    }
+
+    return delta;
+}
+
+json expand_scene_prefabs(const json& scene)
+{
+    json models = scene.value("models", json::array());
+    if (!models.is_array())
+        return models;
+
+    const json prefabs = scene.value("prefabs", json::object());
+    json flat = json::array();
+
+    auto add_child = [&](size_t parent, size_t child)
+    {
+        flat[parent]["children"].push_back(child);
+        flat[parent]["child_count"] = flat[parent]["children"].size();
+    };
+
+    auto children_of = [](const json& node)
+    {
+        std::vector<size_t> children;
+        int child_count = node.value("child_count", 0);
+        const json list = node.value("children", json::array());
+
+        for (int c = 0; c < child_count && c < (int)list.size(); ++c)
+            children.push_back(list[c].get<size_t>());
+
+        return children;
+    };
+
+    // prefab nodes come out in the same order they are stored, so parents still come before their children
+    std::function<size_t(const json&, size_t, const json&)> emit_prefab_node = [&](const json& nodes, size_t node_index, const json& instance) -> size_t
+    {
+        json node = nodes[node_index];
+        node.erase("children");
+        node.erase("child_count");
+        node.erase("id");
+
+        const json overrides = instance.value("overrides", json::object());
+        if (overrides.contains(std::to_string(node_index)))
+            node.merge_patch(overrides[std::to_string(node_index)]);
+
+        if (node_index == 0)
+        {
+            for (const char* key : { "name", "id", "transform" })
+            {
+                if (instance.contains(key))
+                    node[key] = instance[key];
+            }
+        }
+
+        size_t index = flat.size();
+        flat.push_back(std::move(node));
+
+        for (size_t child : children_of(nodes[node_index]))
+        {
+            if (child > node_index && child < nodes.size())
+                add_child(index, emit_prefab_node(nodes, child, instance));
+        }
+
+        return index;
+    };
+
+    std::function<size_t(size_t)> emit_model = [&](size_t model_index) -> size_t
+    {
+        const json& model = models[model_index];
+        std::string prefab = model.value("prefab", "");
+
+        size_t index;
+        if (!prefab.empty() && prefabs.contains(prefab) && prefabs[prefab].is_array() && !prefabs[prefab].empty())
+        {
+            index = emit_prefab_node(prefabs[prefab], 0, model);
+        }
+        else
+        {
+            if (!prefab.empty())
+                warn("Scene places missing prefab {}\n", prefab);
+
+            json node = model;
+            node.erase("children");
+            node.erase("child_count");
+
+            index = flat.size();
+            flat.push_back(std::move(node));
+        }
+
+        for (size_t child : children_of(model))
+        {
+            if (child > model_index && child < models.size())
+                add_child(index, emit_model(child));
+        }
+
+        return index;
+    };
+
+    // only the top level nodes start a walk, everything else is reached through its parent
+    std::vector<bool> is_child(models.size(), false);
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        for (size_t child : children_of(models[i]))
+        {
+            if (child < models.size())
+                is_child[child] = true;
+        }
+    }
+
+    for (size_t i = 0; i < models.size(); ++i)
+    {
+        if (!is_child[i])
+            emit_model(i);
+    }
+
+    return flat;
+}
+
+std::string scene_journal_path(const std::string& scene_path)
+{
+    return scene_path + ".journal";
+}
+
+uint32_t scene_node_id(const json& model, size_t index)
+{
+    return model.value("id", (uint32_t)index + 1);
+}
+
+struct JournalNode
+{
+    json data;
+    uint32_t parent = 0;
+    std::vector<uint32_t> children;
+};
+
+bool fold_scene_journal(const std::string& scene_path, const std::string& journal_path)
+{
+    std::string journal_src;
+    if (!FileSystem::read(journal_path, journal_src))
+        return true;
+
+    std::string scene_src;
+    if (!FileSystem::read(scene_path, scene_src) || is_binary_scene(scene_path))
+        return false;
+
+    json scene = json::parse(scene_src, nullptr, false);
+    if (scene.is_discarded())
+        return false;
+
+    // the flat depth first list turned back into a tree keyed by id, 0 is the root
+    std::unordered_map<uint32_t, JournalNode> nodes;
+    std::vector<uint32_t> roots;
+
+    auto children_of = [&](uint32_t id) -> std::vector<uint32_t>& { return (id == 0) ? roots : nodes[id].children; };
+
+    auto detach = [&](uint32_t id)
+    {
+        std::vector<uint32_t>& siblings = children_of(nodes[id].parent);
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), id), siblings.end());
+    };
+
+    json& models = scene["models"];
+    if (models.is_array())
+    {
+        std::vector<uint32_t> ids(models.size());
+        std::vector<uint32_t> parents(models.size(), 0);
+
+        for (size_t i = 0; i < models.size(); ++i)
+            ids[i] = scene_node_id(models[i], i);
+
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            int child_count = models[i].value("child_count", 0);
+            const json children = models[i].value("children", json::array());
+
+            for (int c = 0; c < child_count && c < (int)children.size(); ++c)
+            {
+                auto child = children[c].get<size_t>();
+                if (child < models.size())
+                    parents[child] = ids[i];
+            }
+        }
+
+        // parents always come first so their entries are there when the children get added
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            JournalNode& node = nodes[ids[i]];
+            node.data = std::move(models[i]);
+            node.data.erase("children");
+            node.data.erase("child_count");
+            node.data["id"] = ids[i];
+            node.parent = parents[i];
+            children_of(node.parent).push_back(ids[i]);
+        }
+    }
+
+    size_t num_records = 0;
+    for (size_t begin = 0; begin < journal_src.size();)
+    {
+        size_t end = journal_src.find('\n', begin);
+        if (end == std::string::npos)
+            end = journal_src.size();
+
+        std::string_view line(journal_src.data() + begin, end - begin);
+        begin = end + 1;
+
+        if (line.empty())
+            continue;
+
+        // a crash in the middle of a save cuts a line short, and a journal appended to a failed compaction can carry that line in the middle
+        json record = json::parse(line.begin(), line.end(), nullptr, false);
+        if (record.is_discarded())
+            continue;
+
+        std::string op = record.value("op", "");
+        uint32_t id = record.value("id", 0u);
+
+        if (op == "set" && id != 0)
+        {
+            uint32_t parent = record.value("parent", 0u);
+
+            // the parent went away later on, so would this
+            if (parent != 0 && !nodes.contains(parent))
+                continue;
+
+            if (nodes.contains(id))
+                detach(id);
+
+            JournalNode& node = nodes[id];
+            node.data = record.value("node", json::object());
+            node.data["id"] = id;
+            node.parent = parent;
+
+            std::vector<uint32_t>& siblings = children_of(parent);
+            size_t index = std::min(record.value("index", siblings.size()), siblings.size());
+            siblings.insert(siblings.begin() + (std::ptrdiff_t)index, id);
+        }
+        else if (op == "remove" && nodes.contains(id))
+        {
+            detach(id);
+
+            std::vector<uint32_t> to_erase = { id };
+            while (!to_erase.empty())
+            {
+                uint32_t erase_id = to_erase.back();
+                to_erase.pop_back();
+
+                to_erase.insert(to_erase.end(), nodes[erase_id].children.begin(), nodes[erase_id].children.end());
+                nodes.erase(erase_id);
+            }
+        }
+        else if (op == "prefab" && record.contains("name"))
+        {
+            scene["prefabs"][record["name"].get<std::string>()] = record.value("nodes", json::array());
+        }
+        else if (op == "scene")
+        {
+            for (const char* key : { "camera", "background_colour", "skybox" })
+            {
+                if (!record.contains(key))
+                    continue;
+
+                if (record[key].is_null())
+                    scene.erase(key);
+                else
+                    scene[key] = record[key];
+            }
+        }
+
+        ++num_records;
+    }
+
+    json flat = json::array();
+
+    // depth first with a stack of its own, generated scenes can nest deeper than the call stack allows
+    struct PendingNode
+    {
+        uint32_t id;
+        size_t parent; // index in flat, SIZE_MAX for top level nodes
+        size_t slot;
+    };
+
+    std::vector<PendingNode> stack;
+    for (size_t r = roots.size(); r-- > 0;)
+        stack.push_back({ roots[r], SIZE_MAX, 0 });
+
+    while (!stack.empty())
+    {
+        PendingNode pending = stack.back();
+        stack.pop_back();
+
+        JournalNode& node = nodes[pending.id];
+        size_t index = flat.size();
+        flat.push_back(std::move(node.data));
+
+        if (pending.parent != SIZE_MAX)
+            flat[pending.parent]["children"][pending.slot] = index;
+
+        if (!node.children.empty())
+            flat[index]["child_count"] = node.children.size();
+
+        // pushed last to first so the first child comes off next
+        for (size_t c = node.children.size(); c-- > 0;)
+            stack.push_back({ node.children[c], index, c });
+    }
+
+    scene["model_count"] = flat.size();
+    scene["models"] = std::move(flat);
+
+    // written next to it and swapped in so a crash never leaves half a scene behind
+    std::string temp_path = scene_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::trunc);
+        out << scene.dump();
+        if (!out.good())
+            return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, scene_path, ec);
+    if (ec)
+        return false;
+
+    std::filesystem::remove(journal_path, ec);
+
+    info("Folded {} journal records into {}\n", num_records, scene_path);
+    return true;
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json_fwd.hpp>
+
+// binary scenes (.tbscene) are laid out so they can be mapped and read in place
+// nodes are stored parents first, everything else is referenced by offset or index
+
+// stands in for a missing string, blob, parent or asset
+static constexpr uint32_t SCENE_NONE = UINT32_MAX;
+
+// the source had prefabs, the placed ones are written out in full and the definitions are gone
+static constexpr uint32_t SCENE_FLAG_PREFABS = 1;
+
+struct SceneHeader
+{
+    char magic[4] = { 'T', 'B', 'S', 'C' };
+    uint32_t version = 2;
+    uint32_t node_count = 0;
+    uint32_t asset_count = 0;
+    uint64_t node_offset = 0;
+    uint64_t asset_offset = 0;
+    uint64_t blob_offset = 0, blob_size = 0;
+    uint64_t string_offset = 0, string_size = 0;
+
+    float camera_position[3] = {};
+    float camera_forward[3] = { 0.f, 0.f, -1.f };
+    float background_colour[4] = { 0.f, 0.f, 0.f, 1.f };
+    uint32_t skybox_path = SCENE_NONE;
+    uint32_t skybox_format = 0;
+    uint32_t flags = 0;
+};
+
+struct SceneNodeRecord
+{
+    uint32_t name;      // string offset
+    uint32_t parent;    // node index, SCENE_NONE for nodes directly under the root
+    uint32_t transform; // blob offsets, SCENE_NONE when the node doesn't have the component
+    uint32_t light;
+    uint32_t mesh;
+    uint32_t material;
+    uint32_t id;        // the id the node has in the json scene, so journals written against it still apply
+};
+
+// every file the scene pulls in, so tools can find them without walking the nodes
+struct SceneAssetRecord
+{
+    uint32_t type; // string offset, the mesh type ("primitive", "gltf", ...) or "texture"
+    uint32_t path; // string offset
+};
+
+struct TransformBlob
+{
+    float translate[3];
+    float rotation[4]; // angle then axis
+    float scale;
+};
+
+enum class SceneLightType : uint32_t
+{
+    Point = 0,
+    Directional
+};
+
+struct LightBlob
+{
+    SceneLightType type;
+    float colour[4];
+    float brightness;
+    float range;        // point lights
+    float direction[3]; // directional lights
+    uint32_t cast_shadow;
+};
+
+struct MeshBlob
+{
+    uint32_t asset;
+    uint32_t instanced;
+    uint32_t use_scale_outline;
+    float outlining_factor;
+};
+
+struct MaterialBlob
+{
+    uint32_t shader; // string offset
+    uint32_t texturing_mode;
+    float colour[4];
+    float metallic;
+    float roughness;
+    uint32_t textures[4]; // asset indices in material slot order
+};
+
+// read only view of a binary scene, everything is checked once when it is opened so the accessors don't have to
+class SceneView
+{
+public:
+    bool open(const std::string& file_path);
+    bool open(std::vector<unsigned char>&& bytes);
+
+    [[nodiscard]] const SceneHeader& header() const { return *(const SceneHeader*)m_data; }
+    [[nodiscard]] const SceneNodeRecord& node(uint32_t index) const { return ((const SceneNodeRecord*)(m_data + header().node_offset))[index]; }
+    [[nodiscard]] const SceneAssetRecord& asset(uint32_t index) const { return ((const SceneAssetRecord*)(m_data + header().asset_offset))[index]; }
+
+    // an empty string for SCENE_NONE
+    [[nodiscard]] const char* string(uint32_t offset) const;
+    [[nodiscard]] const char* asset_path(uint32_t index) const { return (index == SCENE_NONE) ? "" : string(asset(index).path); }
+
+    // nullptr for SCENE_NONE
+    template<typename T>
+    [[nodiscard]] const T* blob(uint32_t offset) const { return (offset == SCENE_NONE) ? nullptr : (const T*)(m_data + header().blob_offset + offset); }
+
+private:
+    bool validate();
+
+    std::shared_ptr<const unsigned char> m_file;
+    std::vector<unsigned char> m_bytes;
+    const unsigned char* m_data = nullptr;
+    uint64_t m_size = 0;
+};
+
+[[nodiscard]] bool is_binary_scene(const std::string& file_path);
+
+// the json layout is the one SceneSerializer::save writes
+bool scene_json_to_binary(const nlohmann::json& scene, std::vector<unsigned char>& bytes);
+bool scene_binary_to_json(const SceneView& view, nlohmann::json& scene);
+
+bool write_binary_scene(const std::string& file_path, const std::vector<unsigned char>& bytes);
+
+// prefabs are kept under "prefabs" as name -> nodes, laid out like "models" with node 0 at the top
+// a placed prefab is a single model naming it in "prefab" with its own "transform" and an "overrides" object
+// keyed by prefab node index, each holding only the parts of that node the instance changed (null for removed ones)
+[[nodiscard]] nlohmann::json prefab_node_delta(const nlohmann::json& node, const nlohmann::json& prefab_node);
+
+// the scene's models with every placed prefab written out in full, for formats that don't know about prefabs
+[[nodiscard]] nlohmann::json expand_scene_prefabs(const nlohmann::json& scene);
+
+// incremental saves append one json record per line to <scene>.journal:
+//   {"op": "set", "id": 3, "parent": 1, "index": 0, "node": {...}}  adds or replaces a node, parent 0 is the root
+//   {"op": "remove", "id": 3}                                         removes a node and everything under it
+//   {"op": "scene", "camera": {...}, "background_colour": [...], "skybox": {...}}
+//   {"op": "prefab", "name": "...", "nodes": [...]}                  adds a prefab definition
+[[nodiscard]] std::string scene_journal_path(const std::string& scene_path);
+
+// the id a node is saved with, nodes from files written before ids existed get one from their position
+[[nodiscard]] uint32_t scene_node_id(const nlohmann::json& model, size_t index);
+
+// applies a journal to a json scene and rewrites it, the journal is only deleted once the new scene is on disk
+// true if there was nothing to fold
+bool fold_scene_journal(const std::string& scene_path, const std::string& journal_path);
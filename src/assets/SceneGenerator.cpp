@@ -0,0 +1,198 @@
+#include "pch.h"
+#include "SceneGenerator.h"
+#include "Log.h"
+
+#include <cmath>
+#include <random>
+#include <nlohmann/json.hpp>
+
+using namespace nlohmann;
+
+static json material_json(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    json material;
+    material["shader"] = "default";
+    material["texturing_mode"] = 0;
+    material["properties"]["colour"] = { unit(rng), unit(rng), unit(rng), 1.f };
+    material["properties"]["metallic_property"] = unit(rng);
+    material["properties"]["roughness"] = unit(rng);
+    material["textures"] = { { "base_colour", "" }, { "specular", "" }, { "normal_map", "" }, { "occlusion", "" } };
+
+    return material;
+}
+
+bool write_stress_scene(const std::string& file_path, const StressSceneSettings& settings, StressSceneStats* stats)
+{
+    uint32_t num_nodes = settings.num_nodes;
+    uint32_t fan_out = std::max(settings.fan_out, 1u);
+
+    // breadth first every parent gets its children in one run, so they only need the first index and a count
+    std::vector<uint32_t> first_child(num_nodes, 0), child_count(num_nodes, 0), level(num_nodes, 0);
+    std::vector<uint32_t> top_level;
+    size_t open_parent = 0;
+    std::vector<uint32_t> parents_with_room;
+
+    for (uint32_t i = 0; i < num_nodes; ++i)
+    {
+        while (open_parent < parents_with_room.size() && child_count[parents_with_room[open_parent]] == fan_out)
+            ++open_parent;
+
+        if (open_parent == parents_with_room.size())
+        {
+            top_level.push_back(i);
+            parents_with_room.clear();
+            open_parent = 0;
+        }
+        else
+        {
+            uint32_t parent = parents_with_room[open_parent];
+            if (child_count[parent]++ == 0)
+                first_child[parent] = i;
+
+            level[i] = level[parent] + 1;
+        }
+
+        if (level[i] + 1 < settings.depth)
+            parents_with_room.push_back(i);
+    }
+
+    // the file lists nodes depth first, so every node needs its position in that order before anything is written
+    std::vector<uint32_t> order(num_nodes);
+    {
+        uint32_t next = 0;
+        std::vector<uint32_t> stack;
+        for (uint32_t top : top_level)
+        {
+            stack.push_back(top);
+            while (!stack.empty())
+            {
+                uint32_t node = stack.back();
+                stack.pop_back();
+                order[node] = next++;
+
+                for (uint32_t c = child_count[node]; c > 0; --c)
+                    stack.push_back(first_child[node] + c - 1);
+            }
+        }
+    }
+
+    std::ofstream out(file_path, std::ios::trunc | std::ios::binary);
+    if (!out)
+    {
+        error("Could not write {}\n", file_path);
+        return false;
+    }
+
+    uint32_t total_nodes = num_nodes + (settings.directional_shadow ? 1 : 0);
+
+    json header;
+    header["camera"]["position"] = { 0.f, 40.f, 80.f };
+    header["camera"]["forward"] = { 0.f, -0.447f, -0.894f };
+    header["background_colour"] = { 0.05f, 0.05f, 0.08f, 1.f };
+    header["model_count"] = total_nodes;
+
+    // everything but the models goes first, they are streamed into the array that closes the object
+    std::string header_text = header.dump();
+    header_text.pop_back();
+    out << header_text << ",\"models\":[";
+
+    std::mt19937 rng(settings.seed);
+    std::uniform_real_distribution<float> offset(-2.f, 2.f);
+    std::uniform_real_distribution<float> angle(0.f, 360.f);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    uint32_t grid_width = (uint32_t)std::ceil(std::sqrt((double)top_level.size()));
+    uint32_t light_spacing = settings.num_point_lights ? std::max(num_nodes / settings.num_point_lights, 1u) : 0;
+    uint32_t num_lights = 0, num_instanced = 0;
+    bool first = true;
+
+    std::vector<uint32_t> stack;
+    for (size_t t = 0; t < top_level.size(); ++t)
+    {
+        stack.push_back(top_level[t]);
+        while (!stack.empty())
+        {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            uint32_t index = order[node];
+
+            json model;
+            model["name"] = "node " + std::to_string(index);
+            model["id"] = index + 1;
+
+            // top level nodes sit on a grid, everything under them is scattered around its parent
+            if (level[node] == 0)
+                model["transform"]["translate"] = { (float)(t % grid_width) * 8.f, 0.f, (float)(t / grid_width) * 8.f };
+            else
+                model["transform"]["translate"] = { offset(rng), offset(rng), offset(rng) };
+
+            model["transform"]["rotation"] = { angle(rng), 0.f, 1.f, 0.f };
+            model["transform"]["scale"] = (level[node] == 0) ? 1.f : 0.6f;
+
+            // instancing is per mesh so instanced and regular nodes can't both be cubes
+            bool instanced = unit(rng) < settings.instanced_share;
+            num_instanced += instanced;
+
+            model["mesh"]["mesh_name"] = instanced ? "cube" : "quad";
+            model["mesh"]["mesh_type"] = "primitive";
+            model["mesh"]["instanced"] = instanced;
+            model["mesh"]["outlining_factor"] = 0.02f;
+            model["mesh"]["use_scale_outline"] = true;
+            model["material"] = material_json(rng);
+
+            if (light_spacing && index % light_spacing == 0 && num_lights < settings.num_point_lights)
+            {
+                model["light"]["type"] = "point_light";
+                model["light"]["colour"] = { unit(rng), unit(rng), unit(rng), 1.f };
+                model["light"]["range"] = 20.f;
+                model["light"]["brightness"] = 1.f;
+                model["light"]["cast_shadow"] = num_lights < settings.num_shadow_casters;
+                ++num_lights;
+            }
+
+            for (uint32_t c = 0; c < child_count[node]; ++c)
+                model["children"][c] = order[first_child[node] + c];
+
+            if (child_count[node])
+                model["child_count"] = child_count[node];
+
+            out << (first ? "" : ",") << model.dump();
+            first = false;
+
+            for (uint32_t c = child_count[node]; c > 0; --c)
+                stack.push_back(first_child[node] + c - 1);
+        }
+    }
+
+    if (settings.directional_shadow)
+    {
+        json sun;
+        sun["name"] = "Sun";
+        sun["id"] = num_nodes + 1;
+        sun["transform"] = { { "translate", { 0.f, 40.f, 40.f } }, { "rotation", { 0.f, 1.f, 0.f, 0.f } }, { "scale", 1.f } };
+        sun["light"] = { { "type", "directional_light" }, { "colour", { 1.f, 1.f, 1.f, 1.f } }, { "brightness", 0.5f }, { "direction", { 0.f, 40.f, 40.f } }, { "cast_shadow", true } };
+
+        out << (first ? "" : ",") << sun.dump();
+    }
+
+    out << "]}";
+    out.flush();
+
+    if (!out.good())
+    {
+        error("Could not write {}\n", file_path);
+        return false;
+    }
+
+    if (stats)
+    {
+        stats->num_nodes = total_nodes;
+        stats->num_top_level = (uint32_t)top_level.size();
+        stats->num_instanced = num_instanced;
+        stats->file_size = (uint64_t)out.tellp();
+    }
+
+    return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// shape of a generated stress scene, the tree is filled breadth first so a top level node only
+// gets started once the one before it is full
+struct StressSceneSettings
+{
+    uint32_t num_nodes = 1000;
+    uint32_t depth = 4;              // levels including the top one, 1 keeps every node at the top
+    uint32_t fan_out = 8;            // children per node
+    float instanced_share = 0.5f;    // drawn as instanced cubes, the rest are quads with a material of their own
+    uint32_t num_point_lights = 4;   // hung on nodes spread evenly through the scene
+    uint32_t num_shadow_casters = 0; // how many of the point lights cast shadows
+    bool directional_shadow = true;  // a shadow casting directional light on top of num_nodes
+    uint32_t seed = 1;
+};
+
+struct StressSceneStats
+{
+    uint32_t num_nodes = 0;
+    uint32_t num_top_level = 0;
+    uint32_t num_instanced = 0;
+    uint64_t file_size = 0;
+};
+
+// written one node at a time in the json layout SceneSerializer::save uses, so the scene never sits in memory as a whole
+bool write_stress_scene(const std::string& file_path, const StressSceneSettings& settings, StressSceneStats* stats = nullptr);
@@ -0,0 +1,325 @@
+#include "pch.h"
+#include "TextureData.h"
+#include "MipGenerator.h"
+#include "AssetCache.h"
+#include "FileSystem.h"
+#include "ThreadPool.h"
+#include "Log.h"
+
+#include <cstring>
+#include <stb_image.h>
+
+
+// pixel data starts on this boundary so mapped levels can be handed to GL as is
+static constexpr uint64_t COOKED_DATA_ALIGNMENT = 16;
+
+struct CookedTextureHeader
+{
+    char magic[4] = { 'T', 'B', 'T', 'X' };
+    uint32_t version = 2;
+    uint32_t format = 0;
+    uint32_t width = 0, height = 0;
+    uint32_t faces = 0;
+    uint32_t num_levels = 0;
+    uint32_t flags = 0;
+    uint64_t data_offset = 0;
+    uint64_t data_size = 0;
+};
+
+bool is_block_compressed(PixelFormat format)
+{
+    return format != PixelFormat::RGBA8;
+}
+
+uint32_t block_size(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat::RGBA8: return 4;
+        case PixelFormat::BC1:   return 8;
+        case PixelFormat::BC3:   return 16;
+        case PixelFormat::BC4:   return 8;
+        case PixelFormat::BC5:   return 16;
+        case PixelFormat::BC7:   return 16;
+    }
+
+    return 0;
+}
+
+// for compressed formats this counts whole 4x4 blocks, so small mips still take up a full block
+uint64_t level_size(PixelFormat format, uint32_t width, uint32_t height)
+{
+    if (!is_block_compressed(format))
+        return (uint64_t)width * height * block_size(format);
+
+    uint64_t blocks_x = (width + 3) / 4;
+    uint64_t blocks_y = (height + 3) / 4;
+    return blocks_x * blocks_y * block_size(format);
+}
+
+const char* pixel_format_to_str(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat::RGBA8: return "rgba8";
+        case PixelFormat::BC1:   return "bc1";
+        case PixelFormat::BC3:   return "bc3";
+        case PixelFormat::BC4:   return "bc4";
+        case PixelFormat::BC5:   return "bc5";
+        case PixelFormat::BC7:   return "bc7";
+    }
+
+    return "";
+}
+
+bool decode_image(const std::string& file_path, ImageData& image, int desired_channels, bool flip)
+{
+    // the flag is thread local so workers can decode at the same time
+    stbi_set_flip_vertically_on_load_thread(flip);
+
+    FileView file = FileSystem::map(file_path);
+    if (!file || file.size() > INT32_MAX)
+        return false;
+
+    unsigned char* data = stbi_load_from_memory(file.data(), (int)file.size(), &image.width, &image.height, &image.channels, desired_channels);
+
+    if (!data)
+        return false;
+
+    if (desired_channels != 0)
+        image.channels = desired_channels;
+
+    image.pixels.assign(data, data + (size_t)image.width * image.height * image.channels);
+    stbi_image_free(data);
+
+    return true;
+}
+
+uint32_t mip_count(uint32_t width, uint32_t height)
+{
+    uint32_t levels = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        ++levels;
+    }
+
+    return levels;
+}
+
+TextureData texture_data_from_image(ImageData&& image, bool with_mips, uint32_t flags)
+{
+    TextureData texture;
+    texture.format = PixelFormat::RGBA8;
+    texture.width = (uint32_t)image.width;
+    texture.height = (uint32_t)image.height;
+    texture.flags = flags;
+
+    if (is_cut_out(image.pixels.data(), (uint64_t)image.width * image.height))
+        texture.flags |= TextureFlags::CutOut;
+
+    texture.num_levels = 1;
+    texture.levels.push_back({ texture.width, texture.height, 0, level_size(PixelFormat::RGBA8, texture.width, texture.height) });
+    texture.pixels = std::move(image.pixels);
+
+    if (with_mips)
+        generate_mips(texture);
+
+    return texture;
+}
+
+bool decode_cube_faces(const std::string* face_paths, TextureData& texture, bool with_mips)
+{
+    ImageData images[6];
+    bool decoded[6];
+
+    ThreadPool::get().parallel_for(6, [&](size_t i)
+    {
+        decoded[i] = decode_image(face_paths[i], images[i], 4, false);
+    });
+
+    for (int i = 0; i < 6; ++i)
+    {
+        if (!decoded[i])
+        {
+            warn("Could not decode cube face {}\n", face_paths[i]);
+            return false;
+        }
+
+        if (images[i].width != images[0].width || images[i].height != images[0].height)
+        {
+            warn("Cube face {} is {}x{}, expected {}x{}\n", face_paths[i], images[i].width, images[i].height, images[0].width, images[0].height);
+            return false;
+        }
+    }
+
+    texture = {};
+    texture.format = PixelFormat::RGBA8;
+    texture.width = (uint32_t)images[0].width;
+    texture.height = (uint32_t)images[0].height;
+    texture.faces = 6;
+    texture.num_levels = 1;
+    texture.flags = TextureFlags::SRGB;
+
+    uint64_t face_size = level_size(PixelFormat::RGBA8, texture.width, texture.height);
+    texture.pixels.resize(face_size * 6);
+
+    for (uint32_t face = 0; face < 6; ++face)
+    {
+        texture.levels.push_back({ texture.width, texture.height, face * face_size, face_size });
+        std::memcpy(texture.pixels.data() + face * face_size, images[face].pixels.data(), face_size);
+    }
+
+    if (with_mips)
+        generate_mips(texture);
+
+    return true;
+}
+
+static uint64_t aligned_data_offset(uint32_t num_levels, uint32_t faces)
+{
+    uint64_t offset = sizeof(CookedTextureHeader) + (uint64_t)num_levels * faces * sizeof(MipLevel);
+    return (offset + COOKED_DATA_ALIGNMENT - 1) & ~(COOKED_DATA_ALIGNMENT - 1);
+}
+
+static bool valid_header(const CookedTextureHeader& header, uint64_t file_size)
+{
+    if (std::memcmp(header.magic, "TBTX", 4) != 0 || header.version != CookedTextureHeader{}.version)
+        return false;
+
+    // bounded so the level table's size can't overflow, nothing is wider than 2^31 or has more than a cube's faces
+    if (header.format > (uint32_t)PixelFormat::BC4 || header.num_levels == 0 || header.num_levels > 32 || header.faces == 0 || header.faces > 6)
+        return false;
+
+    // written so none of the sums can wrap around on a corrupt header
+    return header.data_offset >= aligned_data_offset(header.num_levels, header.faces) && header.data_offset <= file_size &&
+           header.data_size <= file_size - header.data_offset;
+}
+
+// every level has to be the size its mip and format call for and sit inside the pixel data
+// the upload and streaming paths hand the dimensions straight to GL, which reads that many bytes without checking
+static bool valid_levels(const CookedTextureHeader& header, const MipLevel* levels)
+{
+    if (header.width == 0 || header.height == 0 || header.num_levels > mip_count(header.width, header.height))
+        return false;
+
+    auto format = (PixelFormat)header.format;
+    for (uint32_t face = 0; face < header.faces; ++face)
+    {
+        for (uint32_t mip = 0; mip < header.num_levels; ++mip)
+        {
+            const MipLevel& level = levels[face * header.num_levels + mip];
+
+            if (level.width != std::max(header.width >> mip, 1u) || level.height != std::max(header.height >> mip, 1u))
+                return false;
+
+            if (level.size != level_size(format, level.width, level.height))
+                return false;
+
+            if (level.offset > header.data_size || level.size > header.data_size - level.offset)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void copy_header(const CookedTextureHeader& header, TextureData& texture)
+{
+    texture.format = (PixelFormat)header.format;
+    texture.width = header.width;
+    texture.height = header.height;
+    texture.faces = header.faces;
+    texture.num_levels = header.num_levels;
+    texture.flags = header.flags;
+}
+
+bool write_cooked_texture(const std::string& file_path, const TextureData& texture)
+{
+    std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+
+    if (!out)
+        return false;
+
+    CookedTextureHeader header;
+    header.format = (uint32_t)texture.format;
+    header.width = texture.width;
+    header.height = texture.height;
+    header.faces = texture.faces;
+    header.num_levels = texture.num_levels;
+    header.flags = texture.flags;
+    header.data_offset = aligned_data_offset(texture.num_levels, texture.faces);
+    header.data_size = texture.data_size();
+
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)texture.levels.data(), (std::streamsize)(texture.levels.size() * sizeof(MipLevel)));
+
+    static const char padding[COOKED_DATA_ALIGNMENT] = {};
+    out.write(padding, (std::streamsize)(header.data_offset - (uint64_t)out.tellp()));
+
+    out.write((const char*)texture.data(), (std::streamsize)texture.data_size());
+
+    return out.good();
+}
+
+bool read_cooked_texture(const std::string& file_path, TextureData& texture)
+{
+    if (!map_cooked_texture(file_path, texture))
+        return false;
+
+    // copied out so the file can go away and nothing touches it after this
+    const unsigned char* pixels = texture.mapped_pixels.get();
+    texture.pixels.assign(pixels, pixels + texture.mapped_size);
+    texture.mapped_pixels.reset();
+    texture.mapped_size = 0;
+
+    return true;
+}
+
+bool map_cooked_texture(const std::string& file_path, TextureData& texture)
+{
+    FileView file = FileSystem::map(file_path);
+    if (file.size() < sizeof(CookedTextureHeader))
+        return false;
+
+    CookedTextureHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (!valid_header(header, file.size()))
+        return false;
+
+    const auto* levels = (const MipLevel*)(file.data() + sizeof(CookedTextureHeader));
+    if (!valid_levels(header, levels))
+        return false;
+
+    copy_header(header, texture);
+    texture.levels.assign(levels, levels + (size_t)header.faces * header.num_levels);
+
+    // the mapping gets released once the last reference to the pixels goes away
+    texture.pixels.clear();
+    texture.mapped_size = header.data_size;
+    texture.mapped_pixels = file.share(header.data_offset);
+
+    return true;
+}
+
+bool load_texture_data(const std::string& source_path, TextureData& texture, bool srgb, bool map_cooked)
+{
+    std::string cooked_path = AssetCache::find(source_path);
+    if (!cooked_path.empty())
+    {
+        if (map_cooked ? map_cooked_texture(cooked_path, texture) : read_cooked_texture(cooked_path, texture))
+            return true;
+
+        warn("Could not read cooked texture {}, falling back to {}\n", cooked_path, source_path);
+    }
+
+    ImageData image;
+    if (!decode_image(source_path, image))
+        return false;
+
+    uint32_t flags = TextureFlags::Flipped | (srgb ? (uint32_t)TextureFlags::SRGB : 0u);
+    texture = texture_data_from_image(std::move(image), true, flags);
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// decoded image straight from disk
+struct ImageData
+{
+    int width = 0, height = 0;
+    int channels = 0;
+    std::vector<unsigned char> pixels;
+};
+
+bool decode_image(const std::string& file_path, ImageData& image, int desired_channels = 4, bool flip = true);
+
+enum class PixelFormat : uint32_t
+{
+    RGBA8 = 0,
+    BC1   = 1, // rgb + 1 bit alpha, 8 bytes per 4x4 block
+    BC3   = 2, // rgba, 16 bytes per block
+    BC5   = 3, // two channels, meant for normal maps
+    BC7   = 4, // high quality rgba, 16 bytes per block
+    BC4   = 5  // single channel, 8 bytes per block
+};
+
+[[nodiscard]] bool is_block_compressed(PixelFormat format);
+[[nodiscard]] uint32_t block_size(PixelFormat format);
+[[nodiscard]] uint64_t level_size(PixelFormat format, uint32_t width, uint32_t height);
+[[nodiscard]] const char* pixel_format_to_str(PixelFormat format);
+
+namespace TextureFlags {
+    enum : uint32_t
+    {
+        SRGB      = 1,
+        Flipped   = 2,
+        NormalMap = 4,
+        CutOut    = 8  // alpha is only used for the alpha test
+    };
+}
+
+struct MipLevel
+{
+    uint32_t width, height;
+    uint64_t offset, size; // in bytes from the start of the pixel data
+};
+
+// a texture ready to upload, levels are stored face by face
+struct TextureData
+{
+    PixelFormat format = PixelFormat::RGBA8;
+    uint32_t width = 0, height = 0;
+    uint32_t faces = 1;
+    uint32_t num_levels = 0;
+    uint32_t flags = 0;
+    std::vector<MipLevel> levels;
+    std::vector<unsigned char> pixels;
+
+    // set instead of pixels when the data is read straight out of a mapped file
+    std::shared_ptr<const unsigned char> mapped_pixels;
+    uint64_t mapped_size = 0;
+
+    [[nodiscard]] const unsigned char* data() const { return mapped_pixels ? mapped_pixels.get() : pixels.data(); }
+    [[nodiscard]] uint64_t data_size() const { return mapped_pixels ? mapped_size : pixels.size(); }
+
+    [[nodiscard]] const MipLevel& level(uint32_t face, uint32_t mip) const { return levels[face * num_levels + mip]; }
+    [[nodiscard]] const unsigned char* level_data(uint32_t face, uint32_t mip) const { return data() + level(face, mip).offset; }
+};
+
+uint32_t mip_count(uint32_t width, uint32_t height);
+
+// takes a 4 channel image and builds a texture out of it, optionally with the full mip chain
+// cut-outs are detected from the alpha channel and flagged
+TextureData texture_data_from_image(ImageData&& image, bool with_mips, uint32_t flags = TextureFlags::SRGB | TextureFlags::Flipped);
+
+// file names of the faces in a skybox directory, in GL order (+x, -x, +y, -y, +z, -z)
+inline constexpr const char* CUBE_FACE_NAMES[6] = { "right", "left", "top", "bottom", "front", "back" };
+
+// decodes all six faces at once on the thread pool, cube maps are never flipped
+// every face has to be the same size
+bool decode_cube_faces(const std::string* face_paths, TextureData& texture, bool with_mips);
+
+bool write_cooked_texture(const std::string& file_path, const TextureData& texture);
+bool read_cooked_texture(const std::string& file_path, TextureData& texture);
+
+// maps the file instead of copying it, the mapping lives as long as the texture data does
+bool map_cooked_texture(const std::string& file_path, TextureData& texture);
+
+// the cooked version if the asset cache has one, otherwise the source gets decoded and its mips built
+// mapping skips a copy but leaves the actual reads to whoever touches the pixels first
+bool load_texture_data(const std::string& source_path, TextureData& texture, bool srgb, bool map_cooked = false);
@@ -2,6 +2,8 @@
 
 #include "nlohmann/json_fwd.hpp"
 
+#include <memory>
+
 class Component
 {
 public:
@@ -11,4 +13,7 @@ public:
     [[nodiscard]] virtual size_t get_type() const = 0;
 	virtual void imgui_render() = 0;
 	virtual void serialize(nlohmann::json& accessor) const = 0;
+
+	// an independent copy, used when an entity writes to a component it shares with a prefab
+	[[nodiscard]] virtual std::shared_ptr<Component> clone() const = 0;
 };
\ No newline at end of file
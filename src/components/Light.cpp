@@ -123,6 +123,7 @@ void PointLight::serialize(json& accessor) const
 
 	accessor["light"]["range"] = m_range;
     accessor["light"]["brightness"] = m_brightness;
+    accessor["light"]["cast_shadow"] = m_shadow_casting;
 }
 
 void PointLight::shadow_init(const glm::vec3 &light_pos)
@@ -60,6 +60,7 @@ public:
 	[[nodiscard]] size_t get_type() const override { return typeid(DirectionalLight).hash_code(); }
 	void imgui_render() override;
 	void serialize(nlohmann::json& accessor) const override;
+	[[nodiscard]] std::shared_ptr<Component> clone() const override { return std::make_shared<DirectionalLight>(*this); }
 
     void shadow_init(const glm::vec3& light_pos) override;
 
@@ -100,6 +101,7 @@ public:
 	[[nodiscard]] size_t get_type() const override { return typeid(PointLight).hash_code(); }
 	void imgui_render() override;
 	void serialize(nlohmann::json& accessor) const override;
+	[[nodiscard]] std::shared_ptr<Component> clone() const override { return std::make_shared<PointLight>(*this); }
 
 private:
 	float m_range;
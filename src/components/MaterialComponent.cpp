@@ -38,7 +38,7 @@ void MaterialComponent::imgui_render()
             if (ImGui::Selectable(name.c_str(), is_selected))
             {
                 combo_preview = name;
-                m_material->m_shader = ShaderTable::get(combo_preview);
+                m_material->set_shader(ShaderTable::get(combo_preview));
             }
 
             if (is_selected)
@@ -81,7 +81,11 @@ void MaterialComponent::imgui_render()
     else
     {
         ImGui::Text("\nBase Colour\n");
-        texture_viewer(m_material->m_textures[0]->get_id(), (float)m_material->m_textures[0]->get_width(), (float)m_material->m_textures[0]->get_height());
+        // can still be empty while the model's textures are being streamed in
+        if(m_material->m_textures[0])
+            texture_viewer(m_material->m_textures[0]->get_id(), (float)m_material->m_textures[0]->get_width(), (float)m_material->m_textures[0]->get_height());
+        else
+            display_empty_texture();
 
         ImGui::Text("\nMetallic Roughness\n");
         if(m_material->m_textures[1])
@@ -103,6 +107,13 @@ void MaterialComponent::imgui_render()
     }
 }
 
+std::shared_ptr<Component> MaterialComponent::clone() const
+{
+    auto copy = std::make_shared<MaterialComponent>(*this);
+    copy->m_material = std::make_shared<Material>(*m_material);
+    return copy;
+}
+
 void MaterialComponent::serialize(json& accessor) const
 {
     accessor["material"]["texturing_mode"] = (int)m_texturing_mode;
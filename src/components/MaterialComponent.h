@@ -24,6 +24,9 @@ public:
     void imgui_render() override;
     void serialize(nlohmann::json& accessor) const override;
 
+    // the copy gets its own material so editing it leaves the original alone
+    [[nodiscard]] std::shared_ptr<Component> clone() const override;
+
 private:
     std::shared_ptr<Material> m_material;
     TexturingMode m_texturing_mode = TexturingMode::NO_TEXTURE;
@@ -28,6 +28,7 @@ public:
 	[[nodiscard]] size_t get_type() const override { return typeid(MeshComponent).hash_code(); }
 	void imgui_render() override;
 	void serialize(nlohmann::json& accessor) const override;
+	[[nodiscard]] std::shared_ptr<Component> clone() const override { return std::make_shared<MeshComponent>(*this); }
 
     int m_instance_id = -1;
 
@@ -36,6 +36,7 @@ public:
 	[[nodiscard]] size_t get_type() const override { return typeid(Transform).hash_code(); }
 	void imgui_render() override;
 	void serialize(nlohmann::json& accessor) const override;
+	[[nodiscard]] std::shared_ptr<Component> clone() const override { return std::make_shared<Transform>(*this); }
 
 	Transform operator* (const Transform& other) const;
 
@@ -0,0 +1,381 @@
+#include "pch.h"
+#include "AssetCooker.h"
+#include "ThreadPool.h"
+#include "Log.h"
+#include "Hash.h"
+#include "MeshData.h"
+#include "TextureData.h"
+#include "SceneData.h"
+
+#include <atomic>
+#include <unordered_set>
+#include <nlohmann/json.hpp>
+
+using namespace nlohmann;
+
+// bump whenever the output of any cook step changes so old caches get rebuilt
+static constexpr uint64_t COOK_VERSION = 6;
+
+const char* cook_type_to_str(CookType type)
+{
+    switch (type)
+    {
+        case CookType::Texture: return "texture";
+        case CookType::Mesh:    return "mesh";
+        case CookType::Scene:   return "scene";
+        case CookType::CubeMap: return "cubemap";
+    }
+
+    return "";
+}
+
+static bool str_to_cook_type(const std::string& str, CookType& type)
+{
+    if (str == "texture")   { type = CookType::Texture; return true; }
+    if (str == "mesh")      { type = CookType::Mesh; return true; }
+    if (str == "scene")     { type = CookType::Scene; return true; }
+    if (str == "cubemap")   { type = CookType::CubeMap; return true; }
+
+    return false;
+}
+
+static bool classify(const std::filesystem::path& path, CookType& type, std::string& extension)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+    if (ext == ".png" || ext == ".jpg" || ext == ".jpeg")
+    {
+        type = CookType::Texture;
+        extension = ".tbtx";
+        return true;
+    }
+
+    if (ext == ".gltf" || ext == ".glb" || ext == ".obj" || ext == ".fbx")
+    {
+        type = CookType::Mesh;
+        extension = ".tbmesh";
+        return true;
+    }
+
+    if (ext == ".scene")
+    {
+        type = CookType::Scene;
+        extension = ".tbscene";
+        return true;
+    }
+
+    return false;
+}
+
+// skybox directories hold one image per face, named after the face
+static bool find_cube_faces(const std::filesystem::path& dir, std::string face_paths[6])
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        face_paths[i].clear();
+        for (const char* ext : { ".jpg", ".png", ".jpeg" })
+        {
+            std::filesystem::path path = dir / (std::string(CUBE_FACE_NAMES[i]) + ext);
+            if (std::filesystem::is_regular_file(path))
+            {
+                face_paths[i] = path.string();
+                break;
+            }
+        }
+
+        if (face_paths[i].empty())
+            return false;
+    }
+
+    return true;
+}
+
+// there is no metadata to go on so this goes by the usual naming, e.g. Default_normal.png
+static bool is_normal_map(const std::filesystem::path& path)
+{
+    std::string name = path.stem().string();
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+    return name.find("normal") != std::string::npos || name.ends_with("_n");
+}
+
+AssetCooker::AssetCooker(CookOptions options)
+    : m_options(std::move(options)),
+    m_input_dir(std::filesystem::path(m_options.input_dir).lexically_normal()),
+    m_output_dir(std::filesystem::path(m_options.output_dir).lexically_normal())
+{
+}
+
+int AssetCooker::run()
+{
+    if (!std::filesystem::is_directory(m_input_dir))
+    {
+        error("Input directory {} does not exist\n", m_input_dir.string());
+        return 1;
+    }
+
+    std::filesystem::create_directories(m_output_dir);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    load_manifest();
+    gather_jobs();
+
+    ThreadPool pool(m_options.num_threads);
+    std::atomic<int> num_failed = 0, num_cooked = 0, num_skipped = 0;
+
+    pool.parallel_for(m_jobs.size(), [&](size_t i)
+    {
+        CookJob& job = m_jobs[i];
+        job.hash = hash_job(job);
+
+        if (!m_options.force && is_up_to_date(job))
+        {
+            std::lock_guard<std::mutex> lock(m_manifest_mutex);
+            m_manifest[job.relative_path] = { job.type, job.hash, job.cooked_path };
+            ++num_skipped;
+            return;
+        }
+
+        if (!cook(job))
+        {
+            error("Failed to cook {} {}\n", cook_type_to_str(job.type), job.relative_path);
+            ++num_failed;
+            return;
+        }
+
+        info("Cooked {} {}\n", cook_type_to_str(job.type), job.relative_path);
+
+        std::lock_guard<std::mutex> lock(m_manifest_mutex);
+        m_manifest[job.relative_path] = { job.type, job.hash, job.cooked_path };
+        ++num_cooked;
+    });
+
+    save_manifest();
+
+    auto duration = std::chrono::high_resolution_clock::now() - start;
+    auto time_in_ms = (float)std::chrono::duration_cast<std::chrono::microseconds>(duration).count() * 0.001f;
+    info("Cooked {} assets, {} up to date, {} failed on {} threads in {} ms\n", num_cooked.load(), num_skipped.load(), num_failed.load(), pool.get_num_threads(), time_in_ms);
+
+    return num_failed;
+}
+
+void AssetCooker::gather_jobs()
+{
+    std::unordered_set<std::string> cube_dirs;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(m_input_dir))
+    {
+        // the faces of a skybox are cooked together into one file instead of on their own
+        std::string face_paths[6];
+        if (entry.is_directory() && find_cube_faces(entry.path(), face_paths))
+        {
+            CookJob job;
+            job.type = CookType::CubeMap;
+            job.source = entry.path();
+            job.relative_path = entry.path().lexically_relative(m_input_dir).generic_string();
+            job.cooked_path = job.relative_path + ".tbtx";
+
+            cube_dirs.insert(entry.path().generic_string());
+            m_jobs.push_back(std::move(job));
+            continue;
+        }
+
+        if (!entry.is_regular_file() || cube_dirs.contains(entry.path().parent_path().generic_string()))
+            continue;
+
+        CookType type;
+        std::string extension;
+        if (!classify(entry.path(), type, extension))
+            continue;
+
+        CookJob job;
+        job.type = type;
+        job.source = entry.path();
+        job.relative_path = entry.path().lexically_relative(m_input_dir).generic_string();
+        job.cooked_path = job.relative_path + extension;
+
+        m_jobs.push_back(std::move(job));
+    }
+}
+
+void AssetCooker::load_manifest()
+{
+    std::ifstream manifest_file(m_output_dir / "manifest.json");
+    if (!manifest_file)
+        return;
+
+    json manifest = json::parse(manifest_file, nullptr, false);
+    if (manifest.is_discarded() || manifest.value("version", 0) != (int)COOK_VERSION)
+        return;
+
+    for (const auto& [source, entry] : manifest["assets"].items())
+    {
+        CookType type;
+        if (!str_to_cook_type(entry.value("type", ""), type))
+            continue;
+
+        m_previous[source] = { type, string_to_hash(entry.value("hash", "")), entry.value("cooked", "") };
+    }
+}
+
+void AssetCooker::save_manifest() const
+{
+    json manifest;
+    manifest["version"] = COOK_VERSION;
+    // canonical like the paths the game looks up, otherwise cooking from another directory makes every lookup miss
+    std::error_code ec;
+    std::filesystem::path source_root = std::filesystem::weakly_canonical(m_input_dir, ec);
+    manifest["source_root"] = (ec ? m_input_dir : source_root).generic_string();
+    manifest["assets"] = json::object();
+
+    for (const auto& [source, entry] : m_manifest)
+    {
+        manifest["assets"][source]["type"] = cook_type_to_str(entry.type);
+        manifest["assets"][source]["hash"] = hash_to_string(entry.hash);
+        manifest["assets"][source]["cooked"] = entry.cooked_path;
+    }
+
+    std::ofstream out(m_output_dir / "manifest.json", std::ios::trunc);
+    out << manifest.dump(4);
+}
+
+bool AssetCooker::is_up_to_date(const CookJob& job) const
+{
+    auto it = m_previous.find(job.relative_path);
+    if (it == m_previous.end())
+        return false;
+
+    return (it->second.hash == job.hash) && std::filesystem::exists(m_output_dir / job.cooked_path);
+}
+
+bool AssetCooker::cook(const CookJob& job) const
+{
+    std::filesystem::create_directories((m_output_dir / job.cooked_path).parent_path());
+
+    switch (job.type)
+    {
+        case CookType::Texture: return cook_texture(job);
+        case CookType::Mesh:    return cook_mesh(job);
+        case CookType::Scene:   return cook_scene(job);
+        case CookType::CubeMap: return cook_cube_map(job);
+    }
+
+    return false;
+}
+
+bool AssetCooker::cook_texture(const CookJob& job) const
+{
+    ImageData image;
+    if (!decode_image(job.source.string(), image))
+        return false;
+
+    // normal maps hold vectors rather than colours so their mips get renormalized instead of gamma corrected
+    uint32_t flags = TextureFlags::Flipped;
+    flags |= is_normal_map(job.source) ? TextureFlags::NormalMap : TextureFlags::SRGB;
+
+    TextureData texture = texture_data_from_image(std::move(image), true, flags);
+
+    if (m_options.compress_textures)
+    {
+        TextureData compressed;
+        if (!compress_texture(texture, choose_compressed_format(texture), m_options.quality, compressed))
+            return false;
+
+        return write_cooked_texture((m_output_dir / job.cooked_path).string(), compressed);
+    }
+
+    return write_cooked_texture((m_output_dir / job.cooked_path).string(), texture);
+}
+
+bool AssetCooker::cook_mesh(const CookJob& job) const
+{
+    MeshData mesh_data;
+    if (!import_mesh_data(job.source.string(), mesh_data))
+        return false;
+
+    return write_cooked_mesh((m_output_dir / job.cooked_path).string(), mesh_data);
+}
+
+bool AssetCooker::cook_scene(const CookJob& job) const
+{
+    std::ifstream scene_file(job.source);
+    json scene = json::parse(scene_file, nullptr, false);
+
+    std::vector<unsigned char> bytes;
+    if (scene.is_discarded() || !scene_json_to_binary(scene, bytes))
+        return false;
+
+    return write_binary_scene((m_output_dir / job.cooked_path).string(), bytes);
+}
+
+bool AssetCooker::cook_cube_map(const CookJob& job) const
+{
+    std::string face_paths[6];
+    if (!find_cube_faces(job.source, face_paths))
+        return false;
+
+    // the mips are filtered per face, same as any other texture
+    TextureData texture;
+    if (!decode_cube_faces(face_paths, texture, true))
+        return false;
+
+    if (m_options.compress_textures)
+    {
+        TextureData compressed;
+        if (!compress_texture(texture, choose_compressed_format(texture), m_options.quality, compressed))
+            return false;
+
+        return write_cooked_texture((m_output_dir / job.cooked_path).string(), compressed);
+    }
+
+    return write_cooked_texture((m_output_dir / job.cooked_path).string(), texture);
+}
+
+uint64_t AssetCooker::hash_job(const CookJob& job) const
+{
+    uint64_t h = COOK_VERSION;
+
+    // a cube map's source is a directory so it goes by its faces instead
+    if (job.type == CookType::CubeMap)
+    {
+        std::string face_paths[6];
+        find_cube_faces(job.source, face_paths);
+
+        for (const std::string& face_path : face_paths)
+            h = hash_combine(h, hash_file(face_path));
+    }
+    else if (job.type == CookType::Scene)
+    {
+        // the game compares this against the json to tell if the cooked scene is stale, the manifest version already covers COOK_VERSION
+        h = hash_file(job.source.string());
+    }
+    else
+    {
+        h = hash_combine(hash_file(job.source.string()), COOK_VERSION);
+    }
+
+    // switching compression on or changing the preset has to recook every texture
+    if ((job.type == CookType::Texture || job.type == CookType::CubeMap) && m_options.compress_textures)
+        h = hash_combine(h, (uint64_t)m_options.quality + 1);
+
+    // gltf files keep their geometry in separate buffers so those need to be part of the hash
+    if (job.source.extension() == ".gltf")
+    {
+        std::ifstream gltf_file(job.source);
+        json gltf = json::parse(gltf_file, nullptr, false);
+
+        if (!gltf.is_discarded() && gltf.contains("buffers"))
+        {
+            for (const auto& buffer : gltf["buffers"])
+            {
+                std::string uri = buffer.value("uri", "");
+                if (!uri.empty() && uri.rfind("data:", 0) != 0)
+                    h = hash_combine(h, hash_file((job.source.parent_path() / uri).string()));
+            }
+        }
+    }
+
+    return h;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "BlockCompress.h"
+
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class CookType
+{
+    Texture = 0,
+    Mesh,
+    Scene,
+    CubeMap
+};
+
+struct CookOptions
+{
+    std::string input_dir = "../resources";
+    std::string output_dir = "../cooked";
+    unsigned int num_threads = 0;
+    bool force = false;
+    bool compress_textures = false;
+    CompressQuality quality = CompressQuality::Normal;
+};
+
+struct CookJob
+{
+    CookType type;
+    std::filesystem::path source;
+    std::string relative_path; // key in the manifest
+    std::string cooked_path;   // relative to the output directory
+    uint64_t hash = 0;
+};
+
+// walks a resource directory and writes engine ready versions of everything it finds, no GL needed
+class AssetCooker
+{
+public:
+    explicit AssetCooker(CookOptions options);
+
+    // returns the number of assets that failed to cook
+    int run();
+
+private:
+    void gather_jobs();
+    void load_manifest();
+    void save_manifest() const;
+    [[nodiscard]] bool is_up_to_date(const CookJob& job) const;
+
+    bool cook(const CookJob& job) const;
+    bool cook_texture(const CookJob& job) const;
+    bool cook_mesh(const CookJob& job) const;
+    bool cook_scene(const CookJob& job) const;
+    bool cook_cube_map(const CookJob& job) const;
+
+    [[nodiscard]] uint64_t hash_job(const CookJob& job) const;
+
+    CookOptions m_options;
+    std::filesystem::path m_input_dir;
+    std::filesystem::path m_output_dir;
+    std::vector<CookJob> m_jobs;
+
+    struct ManifestEntry
+    {
+        CookType type;
+        uint64_t hash;
+        std::string cooked_path;
+    };
+
+    std::unordered_map<std::string, ManifestEntry> m_previous;
+    std::unordered_map<std::string, ManifestEntry> m_manifest;
+    mutable std::mutex m_manifest_mutex;
+};
+
+const char* cook_type_to_str(CookType type);
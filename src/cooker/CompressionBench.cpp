@@ -0,0 +1,107 @@
+#include "pch.h"
+#include "CompressionBench.h"
+#include "BlockCompress.h"
+#include "TextureData.h"
+#include "ThreadPool.h"
+#include "Log.h"
+
+#include <chrono>
+#include <filesystem>
+
+struct BenchCase
+{
+    const char* name;
+    bool auto_format; // BC1 or BC3 depending on alpha
+    PixelFormat format;
+    CompressQuality quality;
+    double min_psnr; // the average has to stay above this, anything lower is a quality regression
+
+    double total_psnr = 0.0;
+    double total_megapixels = 0.0;
+    double total_seconds = 0.0;
+    int num_images = 0;
+};
+
+int run_compression_bench(const std::string& input_dir)
+{
+    std::vector<BenchCase> cases;
+    // floors sit a little under what each preset reaches on the bundled textures so only a real drop trips them
+    cases.push_back({ "bc1/bc3", true, PixelFormat::BC1, CompressQuality::Fast, 28.0 });
+    cases.push_back({ "bc4", false, PixelFormat::BC4, CompressQuality::Fast, 34.0 });
+    cases.push_back({ "bc5", false, PixelFormat::BC5, CompressQuality::Fast, 32.0 });
+    cases.push_back({ "bc1/bc3", true, PixelFormat::BC1, CompressQuality::Normal, 30.0 });
+    cases.push_back({ "bc4", false, PixelFormat::BC4, CompressQuality::Normal, 35.0 });
+    cases.push_back({ "bc5", false, PixelFormat::BC5, CompressQuality::Normal, 33.0 });
+    cases.push_back({ "bc1/bc3", true, PixelFormat::BC1, CompressQuality::High, 31.0 });
+    cases.push_back({ "bc4", false, PixelFormat::BC4, CompressQuality::High, 36.0 });
+    cases.push_back({ "bc5", false, PixelFormat::BC5, CompressQuality::High, 34.0 });
+
+    int num_failed = 0;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(input_dir))
+    {
+        std::string extension = entry.path().extension().string();
+        if (!entry.is_regular_file() || (extension != ".png" && extension != ".jpg" && extension != ".jpeg"))
+            continue;
+
+        ImageData image;
+        if (!decode_image(entry.path().string(), image))
+        {
+            error("Could not decode {}\n", entry.path().string());
+            ++num_failed;
+            continue;
+        }
+
+        // only the top level is encoded so every preset sees exactly the same pixels
+        TextureData source = texture_data_from_image(std::move(image), false);
+        uint64_t pixel_count = (uint64_t)source.width * source.height;
+        std::vector<unsigned char> decoded(pixel_count * 4);
+
+        info("{} ({}x{})\n", entry.path().lexically_relative(input_dir).generic_string(), source.width, source.height);
+
+        for (BenchCase& bench : cases)
+        {
+            PixelFormat format = bench.auto_format ? choose_compressed_format(source) : bench.format;
+
+            auto start = std::chrono::high_resolution_clock::now();
+            TextureData compressed;
+            bool encoded = compress_texture(source, format, bench.quality, compressed);
+            std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+
+            if (!encoded || !decompress_level(format, compressed.level_data(0, 0), source.width, source.height, decoded.data()))
+            {
+                error("    {:<4} {:<6} could not be encoded\n", pixel_format_to_str(format), compress_quality_to_str(bench.quality));
+                ++num_failed;
+                continue;
+            }
+
+            double psnr = compute_psnr(source.level_data(0, 0), decoded.data(), pixel_count, format_channel_mask(format));
+            double megapixels = (double)pixel_count / 1e6;
+
+            info("    {:<4} {:<6} {:6.2f} dB {:8.2f} MP/s\n", pixel_format_to_str(format), compress_quality_to_str(bench.quality), psnr, megapixels / seconds.count());
+
+            bench.total_psnr += psnr;
+            bench.total_megapixels += megapixels;
+            bench.total_seconds += seconds.count();
+            ++bench.num_images;
+        }
+    }
+
+    info("Summary on {} threads:\n", ThreadPool::get().get_num_threads());
+    for (const BenchCase& bench : cases)
+    {
+        if (bench.num_images == 0)
+            continue;
+
+        double average_psnr = bench.total_psnr / bench.num_images;
+        info("    {:<7} {:<6} avg {:6.2f} dB {:8.2f} MP/s\n", bench.name, compress_quality_to_str(bench.quality), average_psnr, bench.total_megapixels / bench.total_seconds);
+
+        if (average_psnr < bench.min_psnr)
+        {
+            error("    {:<7} {:<6} is below its {:.2f} dB floor\n", bench.name, compress_quality_to_str(bench.quality), bench.min_psnr);
+            ++num_failed;
+        }
+    }
+
+    return num_failed;
+}
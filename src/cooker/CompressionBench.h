@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// encodes every texture under input_dir with each format/preset pair and reports PSNR and throughput
+// returns the number of images that could not be decoded or encoded plus the presets whose average PSNR fell below their floor
+int run_compression_bench(const std::string& input_dir);
@@ -0,0 +1,123 @@
+#include "pch.h"
+#include "IOBench.h"
+#include "FileSystem.h"
+#include "Hash.h"
+#include "Log.h"
+
+#include <chrono>
+#include <filesystem>
+
+// every method goes over the whole set this many times, the first pass also warms the page cache
+static constexpr int IO_BENCH_PASSES = 5;
+
+struct IOBenchCase
+{
+    const char* name;
+    std::function<bool(const std::string&, uint64_t&)> read; // gives back a checksum so nothing gets optimized out
+};
+
+// what file_to_string and the shader loader used to do
+static bool read_lines(const std::string& path, uint64_t& checksum)
+{
+    std::ifstream stream(path);
+    if (!stream)
+        return false;
+
+    std::string line;
+    std::stringstream ss;
+    while (getline(stream, line))
+        ss << line << "\n";
+
+    std::string src = ss.str();
+    checksum = hash_bytes(src.data(), src.size());
+    return true;
+}
+
+static bool read_stream(const std::string& path, uint64_t& checksum)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    std::vector<char> contents((size_t)file.tellg());
+    file.seekg(0);
+    file.read(contents.data(), (std::streamsize)contents.size());
+
+    checksum = hash_bytes(contents.data(), contents.size());
+    return true;
+}
+
+static bool read_whole(const std::string& path, uint64_t& checksum)
+{
+    std::vector<unsigned char> bytes;
+    if (!FileSystem::read(path, bytes))
+        return false;
+
+    checksum = hash_bytes(bytes.data(), bytes.size());
+    return true;
+}
+
+static bool read_mapped(const std::string& path, uint64_t& checksum)
+{
+    FileView file = FileSystem::map(path);
+    if (!file)
+        return false;
+
+    checksum = hash_bytes(file.data(), file.size());
+    return true;
+}
+
+int run_io_bench(const std::string& input_dir)
+{
+    std::vector<std::string> files;
+    uint64_t total_bytes = 0;
+
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(input_dir))
+    {
+        if (!entry.is_regular_file())
+            continue;
+
+        files.push_back(entry.path().string());
+        total_bytes += entry.file_size();
+    }
+
+    info("{} files, {:.2f} MB\n", files.size(), (double)total_bytes / (1024.0 * 1024.0));
+
+    IOBenchCase cases[] = {
+        { "getline", read_lines },
+        { "ifstream", read_stream },
+        { "read", read_whole },
+        { "mmap", read_mapped }
+    };
+
+    int num_failed = 0;
+
+    for (const IOBenchCase& bench : cases)
+    {
+        double best_seconds = 0.0;
+
+        for (int pass = 0; pass < IO_BENCH_PASSES; ++pass)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            for (const std::string& path : files)
+            {
+                uint64_t checksum = 0;
+                if (!bench.read(path, checksum) && pass == 0)
+                {
+                    error("{} could not read {}\n", bench.name, path);
+                    ++num_failed;
+                }
+            }
+
+            std::chrono::duration<double> seconds = std::chrono::high_resolution_clock::now() - start;
+            if (pass == 0 || seconds.count() < best_seconds)
+                best_seconds = seconds.count();
+        }
+
+        double megabytes = (double)total_bytes / (1024.0 * 1024.0);
+        info("    {:<8} {:8.2f} ms {:10.2f} MB/s\n", bench.name, best_seconds * 1000.0, megabytes / best_seconds);
+    }
+
+    return num_failed;
+}
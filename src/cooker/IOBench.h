@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// reads every file under input_dir with each of the ways the engine has loaded files and reports throughput
+// returns the number of files that could not be read
+int run_io_bench(const std::string& input_dir);
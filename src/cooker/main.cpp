@@ -0,0 +1,300 @@
+#include "pch.h"
+#include "AssetCooker.h"
+#include "CompressionBench.h"
+#include "IOBench.h"
+#include "SceneData.h"
+#include "SceneGenerator.h"
+#include "Archive.h"
+#include "Log.h"
+
+#include <nlohmann/json.hpp>
+
+static void print_usage()
+{
+    printf("usage: toybox_cook [options] [input_dir] [output_dir]\n");
+    printf("  input_dir       directory of source assets (default ../resources)\n");
+    printf("  output_dir      where cooked assets and the manifest go (default ../cooked)\n");
+    printf("  -j <threads>    number of worker threads\n");
+    printf("  -f, --force     cook everything even if it is up to date\n");
+    printf("  -c, --compress <fast|normal|high>\n");
+    printf("                  block compress textures (BC1, or BC3 when there is alpha)\n");
+    printf("  --bench         report PSNR and encode speed for every format and preset, nothing is written\n");
+    printf("  --bench-io      report read throughput of every way files get loaded, nothing is written\n");
+    printf("  --pack <out>    packs input_dir into a single archive instead of cooking it\n");
+    printf("  --store         with --pack, store files without compressing them\n");
+    printf("  --convert-scene <in> <out>\n");
+    printf("                  turns a json scene into a binary one or the other way around\n");
+    printf("  --gen-scene <out>\n");
+    printf("                  writes a generated stress scene shaped by the options below instead of cooking\n");
+    printf("  --nodes <n>  --depth <levels>  --fan-out <children>  --instanced <share 0-1>\n");
+    printf("  --lights <point lights>  --shadow-casters <point lights>  --no-sun  --seed <n>\n");
+}
+
+// false for anything that isn't entirely a number in range, the std conversions throw on garbage and ignore trailing text
+static bool str_to_uint(const char* str, uint32_t& value)
+{
+    try
+    {
+        size_t end = 0;
+        unsigned long parsed = std::stoul(str, &end);
+        if (str[end] != '\0' || parsed > std::numeric_limits<uint32_t>::max())
+            return false;
+
+        value = (uint32_t)parsed;
+        return true;
+    }
+    catch (const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+static bool str_to_float(const char* str, float& value)
+{
+    try
+    {
+        size_t end = 0;
+        value = std::stof(str, &end);
+        return str[end] == '\0';
+    }
+    catch (const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+static int pack(const std::string& input_dir, const std::string& out_path, bool compress)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    ArchiveStats stats;
+    if (!write_archive(input_dir, out_path, compress, &stats))
+    {
+        error("Could not pack {} into {}\n", input_dir, out_path);
+        return 1;
+    }
+
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    info("Packed {} files, {} -> {} bytes in {} ms\n", stats.num_files, stats.source_bytes, stats.archive_bytes, elapsed.count());
+
+    // read everything back so a broken archive never gets shipped
+    Archive archive;
+    if (!archive.open(out_path))
+    {
+        error("{} did not validate\n", out_path);
+        return 1;
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < archive.header().entry_count; ++i)
+    {
+        if (!archive.read(archive.entry(i)))
+            return 1;
+    }
+
+    elapsed = std::chrono::high_resolution_clock::now() - start;
+    info("Read back every file in {} ms\n", elapsed.count());
+    return 0;
+}
+
+static int generate_scene(const std::string& out_path, const StressSceneSettings& settings)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    StressSceneStats stats;
+    if (!write_stress_scene(out_path, settings, &stats))
+        return 1;
+
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    info("Wrote {} nodes ({} top level, {} instanced) to {}, {} bytes in {} ms\n", stats.num_nodes, stats.num_top_level, stats.num_instanced, out_path, stats.file_size, elapsed.count());
+    return 0;
+}
+
+static int convert_scene(const std::string& in_path, const std::string& out_path)
+{
+    if (is_binary_scene(in_path))
+    {
+        SceneView view;
+        nlohmann::json scene;
+        if (!view.open(in_path) || !scene_binary_to_json(view, scene))
+        {
+            error("{} is not a valid binary scene\n", in_path);
+            return 1;
+        }
+
+        std::ofstream out(out_path, std::ios::trunc);
+        out << scene.dump();
+
+        info("Wrote json scene {} ({} nodes)\n", out_path, view.header().node_count);
+        return out.good() ? 0 : 1;
+    }
+
+    std::ifstream scene_file(in_path);
+    nlohmann::json scene = nlohmann::json::parse(scene_file, nullptr, false);
+
+    std::vector<unsigned char> bytes;
+    if (scene.is_discarded() || !scene_json_to_binary(scene, bytes) || !write_binary_scene(out_path, bytes))
+    {
+        error("Could not convert {}\n", in_path);
+        return 1;
+    }
+
+    info("Wrote binary scene {} ({} bytes)\n", out_path, bytes.size());
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    CookOptions options;
+    std::vector<std::string> positional;
+    bool bench = false;
+    bool bench_io = false;
+    std::string pack_path;
+    bool store = false;
+    std::string gen_scene_path;
+    StressSceneSettings gen_settings;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help")
+        {
+            print_usage();
+            return 0;
+        }
+        else if (arg == "-f" || arg == "--force")
+        {
+            options.force = true;
+        }
+        else if ((arg == "-c" || arg == "--compress") && i + 1 < argc)
+        {
+            if (!str_to_compress_quality(argv[++i], options.quality))
+            {
+                print_usage();
+                return 1;
+            }
+
+            options.compress_textures = true;
+        }
+        else if (arg == "--bench")
+        {
+            bench = true;
+        }
+        else if (arg == "--bench-io")
+        {
+            bench_io = true;
+        }
+        else if (arg == "--pack" && i + 1 < argc)
+        {
+            pack_path = argv[++i];
+        }
+        else if (arg == "--store")
+        {
+            store = true;
+        }
+        else if (arg == "--convert-scene" && i + 2 < argc)
+        {
+            return convert_scene(argv[i + 1], argv[i + 2]);
+        }
+        else if (arg == "--gen-scene" && i + 1 < argc)
+        {
+            gen_scene_path = argv[++i];
+        }
+        else if (arg == "--nodes" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], gen_settings.num_nodes))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--depth" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], gen_settings.depth))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--fan-out" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], gen_settings.fan_out))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--instanced" && i + 1 < argc)
+        {
+            if (!str_to_float(argv[++i], gen_settings.instanced_share))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--lights" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], gen_settings.num_point_lights))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--shadow-casters" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], gen_settings.num_shadow_casters))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "--no-sun")
+        {
+            gen_settings.directional_shadow = false;
+        }
+        else if (arg == "--seed" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], gen_settings.seed))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (arg == "-j" && i + 1 < argc)
+        {
+            if (!str_to_uint(argv[++i], options.num_threads))
+            {
+                print_usage();
+                return 1;
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            print_usage();
+            return 1;
+        }
+        else
+        {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() > 0) options.input_dir = positional[0];
+    if (positional.size() > 1) options.output_dir = positional[1];
+
+    if (!gen_scene_path.empty())
+        return generate_scene(gen_scene_path, gen_settings);
+
+    if (!pack_path.empty())
+        return pack(options.input_dir, pack_path, !store);
+
+    if (bench_io)
+        return (run_io_bench(options.input_dir) == 0) ? 0 : 1;
+
+    if (bench)
+        return (run_compression_bench(options.input_dir) == 0) ? 0 : 1;
+
+    AssetCooker cooker(options);
+    return (cooker.run() == 0) ? 0 : 1;
+}
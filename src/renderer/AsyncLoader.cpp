@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "AsyncLoader.h"
+#include "Texture.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "ModelLoader.h"
+#include "ThreadPool.h"
+#include "AssetCache.h"
+#include "MeshData.h"
+#include "TextureData.h"
+#include "Log.h"
+
+#include <chrono>
+
+bool AsyncLoader::m_enabled = false;
+std::mutex AsyncLoader::m_mutex;
+std::queue<std::function<void()>> AsyncLoader::m_uploads;
+std::atomic<size_t> AsyncLoader::m_num_pending = 0;
+std::atomic<uint64_t> AsyncLoader::m_generation = 0;
+
+std::shared_ptr<Texture2D> AsyncLoader::create_placeholder_texture()
+{
+    TextureData white;
+    white.width = 1;
+    white.height = 1;
+    white.num_levels = 1;
+    white.levels.push_back({ 1, 1, 0, 4 });
+    white.pixels = { 255, 255, 255, 255 };
+
+    return std::make_shared<Texture2D>(white);
+}
+
+void AsyncLoader::request_texture(const std::string& file_path, const std::shared_ptr<Texture2D>& texture, bool gamma_correct)
+{
+    uint64_t generation = m_generation;
+    std::weak_ptr<Texture2D> target = texture;
+    ++m_num_pending;
+
+    ThreadPool::get().submit([file_path, target, gamma_correct, generation]()
+    {
+        // read rather than mapped so the disk access happens here and not during the upload
+        auto texture_data = std::make_shared<TextureData>();
+        if(!load_texture_data(file_path, *texture_data, gamma_correct))
+        {
+            warn("Could not load image: {}\n", file_path);
+            --m_num_pending;
+            return;
+        }
+
+        push_upload(generation, [target, texture_data, gamma_correct]()
+        {
+            if(auto texture = target.lock())
+                texture->upload(*texture_data, gamma_correct);
+        });
+    });
+}
+
+void AsyncLoader::request_mesh(const std::string& file_path, const std::shared_ptr<Mesh>& mesh)
+{
+    uint64_t generation = m_generation;
+    std::weak_ptr<Mesh> target = mesh;
+    ++m_num_pending;
+
+    ThreadPool::get().submit([file_path, target, generation]()
+    {
+        auto mesh_data = std::make_shared<MeshData>();
+
+        std::string cooked_path = AssetCache::find(file_path);
+        if(cooked_path.empty() || !read_cooked_mesh(cooked_path, *mesh_data))
+        {
+            if(!import_mesh_data(file_path, *mesh_data))
+            {
+                warn("Could not load model: {}\n", file_path);
+                --m_num_pending;
+                return;
+            }
+        }
+
+        push_upload(generation, [target, mesh_data]()
+        {
+            if(auto mesh = target.lock())
+                mesh->load(mesh_data->vertices, mesh_data->indices);
+        });
+    });
+}
+
+void AsyncLoader::request_model_textures(const std::string& model_path, const std::shared_ptr<Material>& material)
+{
+    uint64_t generation = m_generation;
+    std::weak_ptr<Material> target = material;
+    ++m_num_pending;
+
+    ThreadPool::get().submit([model_path, target, generation]()
+    {
+        auto textures = std::make_shared<std::array<std::string, 4>>();
+
+        ModelLoader model_loader(model_path.c_str());
+        model_loader.get_texture_paths(textures->data());
+
+        // Material::load kicks off the texture requests itself
+        push_upload(generation, [target, textures]()
+        {
+            if(auto material = target.lock())
+                material->load(textures->data());
+        });
+    });
+}
+
+void AsyncLoader::process_uploads(float budget_ms)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    while(true)
+    {
+        std::function<void()> upload;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if(m_uploads.empty())
+                break;
+
+            upload = std::move(m_uploads.front());
+            m_uploads.pop();
+        }
+
+        // always make progress, even if a single upload blows the budget
+        upload();
+        --m_num_pending;
+
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        if(elapsed.count() >= budget_ms)
+            break;
+    }
+}
+
+void AsyncLoader::cancel_all()
+{
+    ++m_generation;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_num_pending -= m_uploads.size();
+    m_uploads = {};
+}
+
+void AsyncLoader::push_upload(uint64_t generation, std::function<void()>&& upload)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // the request was made before a cancel so nobody is waiting on it anymore
+    if(generation != m_generation)
+    {
+        --m_num_pending;
+        return;
+    }
+
+    m_uploads.push(std::move(upload));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "renderer/Fwd.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+
+// decodes meshes and textures on worker threads, the results get uploaded on the GL thread a few at a time
+class AsyncLoader
+{
+public:
+    static void set_enabled(bool enabled) { m_enabled = enabled; }
+    [[nodiscard]] static bool is_enabled() { return m_enabled; }
+
+    // 1x1 white texture that can be drawn with until the real data shows up
+    static std::shared_ptr<Texture2D> create_placeholder_texture();
+
+    static void request_texture(const std::string& file_path, const std::shared_ptr<Texture2D>& texture, bool gamma_correct = true);
+    static void request_mesh(const std::string& file_path, const std::shared_ptr<Mesh>& mesh);
+    static void request_model_textures(const std::string& model_path, const std::shared_ptr<Material>& material);
+
+    // must be called from the GL thread, stops once the budget is used up
+    static void process_uploads(float budget_ms = 2.f);
+
+    // drops anything still in flight, results for old requests are thrown away when they finish
+    static void cancel_all();
+
+    [[nodiscard]] static size_t get_num_pending() { return m_num_pending; }
+
+private:
+    static void push_upload(uint64_t generation, std::function<void()>&& upload);
+
+    static bool m_enabled;
+    static std::mutex m_mutex;
+    static std::queue<std::function<void()>> m_uploads;
+    static std::atomic<size_t> m_num_pending;
+    static std::atomic<uint64_t> m_generation;
+};
@@ -2,6 +2,7 @@
 #include "Buffer.h"
 #include "GLError.h"
 #include "Log.h"
+#include "GLState.h"
 
 #include <glad/glad.h>
 
@@ -20,13 +21,13 @@ GLenum convert_buffer_type(BufferType type)
 Buffer::Buffer(BufferType buffer_type)
 {
     m_buffer_type = buffer_type;
-    GL_CALL(glGenBuffers(1, &m_id));
+    GL_CALL(glCreateBuffers(1, &m_id));
 }
 
 Buffer::Buffer(uint64_t size, BufferType buffer_type)
 {
     m_buffer_type = buffer_type;
-    GL_CALL(glGenBuffers(1, &m_id));
+    GL_CALL(glCreateBuffers(1, &m_id));
     allocate_memory(size);
 }
 
@@ -39,36 +40,33 @@ Buffer::Buffer(Buffer&& buff) noexcept
 
 Buffer::~Buffer()
 {
+    GLState::forget_buffer(m_id);
     GL_CALL(glDeleteBuffers(1, &m_id));
 }
 
 void Buffer::allocate_memory(uint64_t size) const
 {
-    bind();
-    GL_CALL(glBufferData(convert_buffer_type(m_buffer_type), size, nullptr, GL_STATIC_DRAW));
-    unbind();
+    GL_CALL(glNamedBufferData(m_id, size, nullptr, GL_STATIC_DRAW));
 }
 
 void Buffer::link(unsigned int binding_point) const
 {
-    GL_CALL(glBindBufferBase(convert_buffer_type(m_buffer_type), binding_point, m_id));
+    GLState::bind_buffer_base(convert_buffer_type(m_buffer_type), binding_point, m_id);
 }
 
 void Buffer::bind() const
 {
-    GL_CALL(glBindBuffer(convert_buffer_type(m_buffer_type), m_id));
+    GLState::bind_buffer(convert_buffer_type(m_buffer_type), m_id);
 }
 
 void Buffer::unbind() const
 {
-    GL_CALL(glBindBuffer(convert_buffer_type(m_buffer_type), 0));
+    GLState::bind_buffer(convert_buffer_type(m_buffer_type), 0);
 }
 
 void Buffer::set_data(int offset, uint64_t size, const void* data) const
 {
-    bind();
-    GL_CALL(glNamedBufferSubData(m_id, offset, size, data))
-    unbind();
+    GL_CALL(glNamedBufferSubData(m_id, offset, size, data));
 }
 
 Buffer& Buffer::operator=(Buffer&& other_buffer) noexcept
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "FrameBuffer.h"
 #include "GLError.h"
+#include "GLState.h"
 #include "Log.h"
 
 #include <cassert>
@@ -35,13 +36,14 @@ FrameBuffer::FrameBuffer(FrameBuffer&& fbo) noexcept
 
 FrameBuffer::~FrameBuffer()
 {
+    GLState::forget_framebuffer(m_id);
     GL_CALL(glDeleteFramebuffers(1, &m_id));
 }
 
 void FrameBuffer::blit(unsigned int dest_buffer) const
 {
-    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_id));
-    GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dest_buffer));
+    GLState::bind_framebuffer(GL_READ_FRAMEBUFFER, m_id);
+    GLState::bind_framebuffer(GL_DRAW_FRAMEBUFFER, dest_buffer);
     GL_CALL(glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST));
 }
 
@@ -49,6 +51,7 @@ void FrameBuffer::attach_texture(unsigned char attachment)
 {
     auto create_and_attach = [&](unsigned int& attachment, unsigned int type, unsigned int component)
     {
+        GLState::forget_texture(attachment);
         GL_CALL(glDeleteTextures(1, &attachment));
         Texture2D texture(type, m_width, m_height, m_samples);
         texture.bind();
@@ -92,6 +95,7 @@ void FrameBuffer::attach_texture(unsigned char attachment, TextureBase&& texture
 
     auto attach = [&](unsigned int& attachment, unsigned int component)
     {
+        GLState::forget_texture(attachment);
         GL_CALL(glDeleteTextures(1, &attachment));
         GL_CALL(glFramebufferTexture(GL_FRAMEBUFFER, component, texture.m_id, 0));
         texture.unbind();
@@ -201,13 +205,13 @@ void FrameBuffer::attach_renderbuffer(unsigned char attachment)
 
 void FrameBuffer::bind() const
 {
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, m_id));
+    GLState::bind_framebuffer(GL_FRAMEBUFFER, m_id);
 }
 
 void FrameBuffer::unbind() const
 {
     // go back to using default frame buffer
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    GLState::bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 // fbo needs to be bound first
@@ -0,0 +1,137 @@
+#include "pch.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+#include "GLError.h"
+#include "Log.h"
+#include "ShaderReflection.h"
+
+#include <glad/glad.h>
+
+static uint64_t align_to(uint64_t offset, uint64_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+void FrameUniforms::register_layouts()
+{
+    ShaderReflection::register_layout({ "Frame", FRAME_BINDING, false, 0, {
+        { "u_view", offsetof(FrameData, view), GL_FLOAT_MAT4 },
+        { "u_projection", offsetof(FrameData, projection), GL_FLOAT_MAT4 },
+        { "u_light_space_view", offsetof(FrameData, light_space_view), GL_FLOAT_MAT4 },
+        { "u_light_space_projection", offsetof(FrameData, light_space_projection), GL_FLOAT_MAT4 },
+        { "u_cam_pos", offsetof(FrameData, cam_pos), GL_FLOAT_VEC3 },
+        { "u_time", offsetof(FrameData, time), GL_FLOAT },
+        { "u_delta_time", offsetof(FrameData, delta_time), GL_FLOAT }
+    }});
+
+    ShaderReflection::register_layout({ "ShadowView", SHADOW_VIEW_BINDING, false, 0, {
+        { "u_shadow_transforms[0]", offsetof(ShadowViewData, shadow_transforms), GL_FLOAT_MAT4 },
+        { "u_light_pos", offsetof(ShadowViewData, light_pos), GL_FLOAT_VEC3 },
+        { "u_far_plane", offsetof(ShadowViewData, far_plane), GL_FLOAT }
+    }});
+}
+
+FrameUniforms::FrameUniforms()
+{
+    create(8);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    release();
+}
+
+void FrameUniforms::create(uint32_t max_shadow_views)
+{
+    int alignment = 256;
+    GL_CALL(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+
+    m_max_shadow_views = max_shadow_views;
+    m_view_stride = align_to(sizeof(ShadowViewData), alignment);
+    m_frame_stride = align_to(sizeof(FrameData), alignment) + m_view_stride * max_shadow_views;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    uint64_t size = m_frame_stride * NUM_FRAMES;
+
+    GL_CALL(glCreateBuffers(1, &m_id));
+    GL_CALL(glNamedBufferStorage(m_id, (GLsizeiptr)size, nullptr, flags));
+    GL_CALL(m_mapping = (unsigned char*)glMapNamedBufferRange(m_id, 0, (GLsizeiptr)size, flags));
+
+    if (!m_mapping)
+        fatal("Could not map the frame uniform buffer\n");
+}
+
+void FrameUniforms::release()
+{
+    for (void*& fence : m_fences)
+    {
+        if (fence)
+        {
+            GL_CALL(glDeleteSync((GLsync)fence));
+            fence = nullptr;
+        }
+    }
+
+    if (m_id != 0)
+    {
+        GL_CALL(glUnmapNamedBuffer(m_id));
+        GLState::forget_buffer(m_id);
+        GL_CALL(glDeleteBuffers(1, &m_id));
+        m_id = 0;
+        m_mapping = nullptr;
+    }
+}
+
+void FrameUniforms::bind_range(uint32_t binding, uint64_t offset, uint64_t size) const
+{
+    GLState::bind_buffer_range(GL_UNIFORM_BUFFER, binding, m_id, offset, size);
+}
+
+FrameData& FrameUniforms::begin_frame()
+{
+    m_frame = (m_frame + 1) % NUM_FRAMES;
+    m_num_shadow_views = 0;
+
+    if (void* fence = m_fences[m_frame])
+    {
+        // only blocks when the cpu is a whole ring ahead of the gpu
+        GLenum result = GL_TIMEOUT_EXPIRED;
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            GL_CALL(result = glClientWaitSync((GLsync)fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000));
+        }
+
+        GL_CALL(glDeleteSync((GLsync)fence));
+        m_fences[m_frame] = nullptr;
+    }
+
+    uint64_t offset = m_frame * m_frame_stride;
+    bind_range(FRAME_BINDING, offset, sizeof(FrameData));
+    return *(FrameData*)(m_mapping + offset);
+}
+
+ShadowViewData& FrameUniforms::next_shadow_view()
+{
+    if (m_num_shadow_views == m_max_shadow_views)
+    {
+        // a bigger ring, the old buffer stays alive until the gpu is done with it
+        FrameData frame = *(const FrameData*)(m_mapping + m_frame * m_frame_stride);
+        release();
+        create(m_max_shadow_views * 2);
+        m_frame = 0;
+
+        *(FrameData*)m_mapping = frame;
+        bind_range(FRAME_BINDING, 0, sizeof(FrameData));
+    }
+
+    uint64_t offset = m_frame * m_frame_stride + (m_frame_stride - m_view_stride * m_max_shadow_views) + m_view_stride * m_num_shadow_views;
+    ++m_num_shadow_views;
+
+    bind_range(SHADOW_VIEW_BINDING, offset, sizeof(ShadowViewData));
+    return *(ShadowViewData*)(m_mapping + offset);
+}
+
+void FrameUniforms::end_frame()
+{
+    GL_CALL(m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
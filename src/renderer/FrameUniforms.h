@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/vec3.hpp>
+#include <glm/matrix.hpp>
+
+// laid out like the std140 Frame block in shaders/include/frame.glsl, bound at 0
+struct FrameData
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 light_space_view;
+    glm::mat4 light_space_projection;
+    glm::vec3 cam_pos;
+    float time;       // ms since the scene started
+    float delta_time; // ms
+};
+
+// laid out like the std140 ShadowView block in shaders/include/shadow_view.glsl, bound at 2
+struct ShadowViewData
+{
+    glm::mat4 shadow_transforms[6];
+    glm::vec3 light_pos;
+    float far_plane;
+};
+
+static_assert(offsetof(FrameData, cam_pos) == 256 && offsetof(FrameData, time) == 268 && offsetof(FrameData, delta_time) == 272);
+static_assert(offsetof(ShadowViewData, light_pos) == 384 && offsetof(ShadowViewData, far_plane) == 396);
+
+// one uniform buffer holding the per frame and per view data, mapped once for good
+// it is split into a region per frame in flight so the cpu never writes what the gpu could still be reading
+class FrameUniforms
+{
+public:
+    static constexpr uint32_t NUM_FRAMES = 3;
+    static constexpr uint32_t FRAME_BINDING = 0;
+    static constexpr uint32_t SHADOW_VIEW_BINDING = 2;
+
+    FrameUniforms();
+    ~FrameUniforms();
+
+    // so programs declaring Frame or ShadowView are checked against the structs above when they link
+    static void register_layouts();
+
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    // waits for the gpu to be done with the oldest region, the returned data is written straight into the mapping
+    // it has to be filled in before anything is drawn with it
+    FrameData& begin_frame();
+
+    // a view of its own for every point light shadow this frame, bound as soon as it's handed out
+    ShadowViewData& next_shadow_view();
+
+    // the region is reused once the commands issued this frame are done with it
+    void end_frame();
+
+private:
+    void create(uint32_t max_shadow_views);
+    void release();
+    void bind_range(uint32_t binding, uint64_t offset, uint64_t size) const;
+
+    unsigned int m_id = 0;
+    unsigned char* m_mapping = nullptr;
+    uint64_t m_frame_stride = 0;      // space for one frame in flight
+    uint64_t m_view_stride = 0;       // space for one shadow view, keeps the offsets aligned
+    uint32_t m_max_shadow_views = 0;
+    uint32_t m_num_shadow_views = 0;
+    uint32_t m_frame = 0;
+    void* m_fences[NUM_FRAMES] = {};
+};
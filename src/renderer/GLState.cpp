@@ -0,0 +1,409 @@
+#include "pch.h"
+#include "GLState.h"
+#include "GLError.h"
+
+#include <glad/glad.h>
+
+unsigned int GLState::m_program = GLState::UNKNOWN;
+unsigned int GLState::m_vertex_array = GLState::UNKNOWN;
+unsigned int GLState::m_buffers[NumBufferSlots];
+unsigned int GLState::m_indexed_buffers[NumBufferSlots][MAX_BUFFER_INDICES];
+unsigned int GLState::m_active_texture = GLState::UNKNOWN;
+unsigned int GLState::m_textures[MAX_TEXTURE_UNITS][NumTextureSlots];
+unsigned int GLState::m_read_framebuffer = GLState::UNKNOWN;
+unsigned int GLState::m_draw_framebuffer = GLState::UNKNOWN;
+
+std::unordered_map<unsigned int, bool> GLState::m_capabilities;
+unsigned int GLState::m_depth_mask = GLState::UNKNOWN;
+unsigned int GLState::m_depth_func = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_func = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_ref = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_func_mask = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_fail = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_depth_fail = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_depth_pass = GLState::UNKNOWN;
+unsigned int GLState::m_stencil_mask = GLState::UNKNOWN;
+unsigned int GLState::m_blend_source = GLState::UNKNOWN;
+unsigned int GLState::m_blend_destination = GLState::UNKNOWN;
+int GLState::m_viewport[4] = {};
+bool GLState::m_viewport_known = false;
+
+size_t GLState::m_num_issued = 0;
+size_t GLState::m_num_skipped = 0;
+size_t GLState::m_last_num_issued = 0;
+size_t GLState::m_last_num_skipped = 0;
+size_t GLState::m_num_program_switches = 0;
+size_t GLState::m_last_num_program_switches = 0;
+
+static int get_buffer_slot(unsigned int target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:           return 0;
+        case GL_ELEMENT_ARRAY_BUFFER:   return 1;
+        case GL_UNIFORM_BUFFER:         return 2;
+        case GL_SHADER_STORAGE_BUFFER:  return 3;
+        default:                        return -1;
+    }
+}
+
+static int get_texture_slot(unsigned int target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D:             return 0;
+        case GL_TEXTURE_2D_MULTISAMPLE: return 1;
+        case GL_TEXTURE_CUBE_MAP:       return 2;
+        default:                        return -1;
+    }
+}
+
+bool GLState::changes(unsigned int& cached, unsigned int value)
+{
+    if (cached == value)
+    {
+        ++m_num_skipped;
+        return false;
+    }
+
+    cached = value;
+    ++m_num_issued;
+    return true;
+}
+
+void GLState::use_program(unsigned int id)
+{
+    if (changes(m_program, id))
+    {
+        GL_CALL(glUseProgram(id));
+        ++m_num_program_switches;
+    }
+}
+
+void GLState::bind_vertex_array(unsigned int id)
+{
+    if (changes(m_vertex_array, id))
+    {
+        GL_CALL(glBindVertexArray(id));
+
+        // the index buffer binding belongs to the vertex array
+        m_buffers[ElementBuffer] = UNKNOWN;
+    }
+}
+
+void GLState::bind_buffer(unsigned int target, unsigned int id)
+{
+    int slot = get_buffer_slot(target);
+    if (slot == -1)
+    {
+        ++m_num_issued;
+        GL_CALL(glBindBuffer(target, id));
+        return;
+    }
+
+    if (changes(m_buffers[slot], id))
+    {
+        GL_CALL(glBindBuffer(target, id));
+    }
+}
+
+void GLState::bind_buffer_base(unsigned int target, unsigned int index, unsigned int id)
+{
+    int slot = get_buffer_slot(target);
+    if (slot == -1 || index >= MAX_BUFFER_INDICES)
+    {
+        ++m_num_issued;
+        GL_CALL(glBindBufferBase(target, index, id));
+        if (slot != -1)
+            m_buffers[slot] = id;
+
+        return;
+    }
+
+    if (changes(m_indexed_buffers[slot][index], id))
+    {
+        GL_CALL(glBindBufferBase(target, index, id));
+
+        // binding to an index binds the generic target as well
+        m_buffers[slot] = id;
+    }
+}
+
+void GLState::bind_buffer_range(unsigned int target, unsigned int index, unsigned int id, uint64_t offset, uint64_t size)
+{
+    ++m_num_issued;
+    GL_CALL(glBindBufferRange(target, index, id, (GLintptr)offset, (GLsizeiptr)size));
+
+    int slot = get_buffer_slot(target);
+    if (slot != -1)
+    {
+        m_buffers[slot] = id;
+        if (index < MAX_BUFFER_INDICES)
+            m_indexed_buffers[slot][index] = UNKNOWN;
+    }
+}
+
+void GLState::bind_texture(unsigned int target, unsigned int id)
+{
+    int slot = get_texture_slot(target);
+    if (slot == -1 || m_active_texture >= MAX_TEXTURE_UNITS)
+    {
+        ++m_num_issued;
+        GL_CALL(glBindTexture(target, id));
+        if (slot != -1 && m_active_texture != UNKNOWN)
+            m_textures[m_active_texture][slot] = id;
+
+        return;
+    }
+
+    if (changes(m_textures[m_active_texture][slot], id))
+    {
+        GL_CALL(glBindTexture(target, id));
+    }
+}
+
+void GLState::bind_texture(unsigned int unit, unsigned int target, unsigned int id)
+{
+    int slot = get_texture_slot(target);
+
+    // skips switching units as well when the texture is already there
+    if (slot != -1 && unit < MAX_TEXTURE_UNITS && m_textures[unit][slot] == id)
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    if (changes(m_active_texture, unit))
+    {
+        GL_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+
+    bind_texture(target, id);
+}
+
+void GLState::bind_framebuffer(unsigned int target, unsigned int id)
+{
+    bool read = (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER);
+    bool draw = (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER);
+
+    if ((!read || m_read_framebuffer == id) && (!draw || m_draw_framebuffer == id))
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    ++m_num_issued;
+    GL_CALL(glBindFramebuffer(target, id));
+
+    if (read) m_read_framebuffer = id;
+    if (draw) m_draw_framebuffer = id;
+}
+
+void GLState::set_enabled(unsigned int capability, bool enabled)
+{
+    auto it = m_capabilities.find(capability);
+    if (it != m_capabilities.end() && it->second == enabled)
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    ++m_num_issued;
+    m_capabilities[capability] = enabled;
+
+    if (enabled)
+    {
+        GL_CALL(glEnable(capability));
+    }
+    else
+    {
+        GL_CALL(glDisable(capability));
+    }
+}
+
+void GLState::set_depth_mask(bool write)
+{
+    if (changes(m_depth_mask, write))
+    {
+        GL_CALL(glDepthMask(write ? GL_TRUE : GL_FALSE));
+    }
+}
+
+void GLState::set_depth_func(unsigned int func)
+{
+    if (changes(m_depth_func, func))
+    {
+        GL_CALL(glDepthFunc(func));
+    }
+}
+
+void GLState::set_stencil_func(unsigned int func, int ref, unsigned int mask)
+{
+    if (m_stencil_func == func && m_stencil_ref == (unsigned int)ref && m_stencil_func_mask == mask)
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    ++m_num_issued;
+    m_stencil_func = func;
+    m_stencil_ref = (unsigned int)ref;
+    m_stencil_func_mask = mask;
+    GL_CALL(glStencilFunc(func, ref, mask));
+}
+
+void GLState::set_stencil_op(unsigned int stencil_fail, unsigned int depth_fail, unsigned int depth_pass)
+{
+    if (m_stencil_fail == stencil_fail && m_stencil_depth_fail == depth_fail && m_stencil_depth_pass == depth_pass)
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    ++m_num_issued;
+    m_stencil_fail = stencil_fail;
+    m_stencil_depth_fail = depth_fail;
+    m_stencil_depth_pass = depth_pass;
+    GL_CALL(glStencilOp(stencil_fail, depth_fail, depth_pass));
+}
+
+void GLState::set_stencil_mask(unsigned int mask)
+{
+    if (changes(m_stencil_mask, mask))
+    {
+        GL_CALL(glStencilMask(mask));
+    }
+}
+
+void GLState::set_blend_func(unsigned int source, unsigned int destination)
+{
+    if (m_blend_source == source && m_blend_destination == destination)
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    ++m_num_issued;
+    m_blend_source = source;
+    m_blend_destination = destination;
+    GL_CALL(glBlendFunc(source, destination));
+}
+
+void GLState::set_viewport(int x, int y, int width, int height)
+{
+    if (m_viewport_known && m_viewport[0] == x && m_viewport[1] == y && m_viewport[2] == width && m_viewport[3] == height)
+    {
+        ++m_num_skipped;
+        return;
+    }
+
+    ++m_num_issued;
+    m_viewport[0] = x;
+    m_viewport[1] = y;
+    m_viewport[2] = width;
+    m_viewport[3] = height;
+    m_viewport_known = true;
+    GL_CALL(glViewport(x, y, width, height));
+}
+
+void GLState::get_viewport(int viewport[4])
+{
+    if (!m_viewport_known)
+    {
+        GL_CALL(glGetIntegerv(GL_VIEWPORT, m_viewport));
+        m_viewport_known = true;
+    }
+
+    std::copy(m_viewport, m_viewport + 4, viewport);
+}
+
+void GLState::forget_program(unsigned int id)
+{
+    // a deleted program stays in use until another one is, so it can't be assumed to be gone
+    if (id != 0 && m_program == id)
+        m_program = UNKNOWN;
+}
+
+void GLState::forget_vertex_array(unsigned int id)
+{
+    if (id != 0 && m_vertex_array == id)
+    {
+        m_vertex_array = 0;
+        m_buffers[ElementBuffer] = UNKNOWN;
+    }
+}
+
+void GLState::forget_buffer(unsigned int id)
+{
+    if (id == 0)
+        return;
+
+    for (unsigned int slot = 0; slot < NumBufferSlots; ++slot)
+    {
+        if (m_buffers[slot] == id)
+            m_buffers[slot] = 0;
+
+        for (unsigned int& indexed : m_indexed_buffers[slot])
+        {
+            if (indexed == id)
+                indexed = 0;
+        }
+    }
+}
+
+void GLState::forget_texture(unsigned int id)
+{
+    if (id == 0)
+        return;
+
+    for (auto& unit : m_textures)
+    {
+        for (unsigned int& texture : unit)
+        {
+            if (texture == id)
+                texture = 0;
+        }
+    }
+}
+
+void GLState::forget_framebuffer(unsigned int id)
+{
+    if (id == 0)
+        return;
+
+    if (m_read_framebuffer == id)
+        m_read_framebuffer = 0;
+
+    if (m_draw_framebuffer == id)
+        m_draw_framebuffer = 0;
+}
+
+void GLState::invalidate()
+{
+    m_program = UNKNOWN;
+    m_vertex_array = UNKNOWN;
+    std::fill(&m_buffers[0], &m_buffers[0] + NumBufferSlots, UNKNOWN);
+    std::fill(&m_indexed_buffers[0][0], &m_indexed_buffers[0][0] + NumBufferSlots * MAX_BUFFER_INDICES, UNKNOWN);
+    m_active_texture = UNKNOWN;
+    std::fill(&m_textures[0][0], &m_textures[0][0] + MAX_TEXTURE_UNITS * NumTextureSlots, UNKNOWN);
+    m_read_framebuffer = UNKNOWN;
+    m_draw_framebuffer = UNKNOWN;
+
+    m_capabilities.clear();
+    m_depth_mask = m_depth_func = UNKNOWN;
+    m_stencil_func = m_stencil_ref = m_stencil_func_mask = UNKNOWN;
+    m_stencil_fail = m_stencil_depth_fail = m_stencil_depth_pass = UNKNOWN;
+    m_stencil_mask = UNKNOWN;
+    m_blend_source = m_blend_destination = UNKNOWN;
+    m_viewport_known = false;
+}
+
+void GLState::end_frame()
+{
+    m_last_num_issued = m_num_issued;
+    m_last_num_skipped = m_num_skipped;
+    m_last_num_program_switches = m_num_program_switches;
+    m_num_issued = 0;
+    m_num_skipped = 0;
+    m_num_program_switches = 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// mirrors the state last handed to GL so wrappers can bind freely, calls that wouldn't change anything are dropped
+// everything starts out unknown and goes back to unknown after invalidate(), so the next call always goes through
+class GLState
+{
+public:
+    static void use_program(unsigned int id);
+    static void bind_vertex_array(unsigned int id);
+
+    static void bind_buffer(unsigned int target, unsigned int id);
+    static void bind_buffer_base(unsigned int target, unsigned int index, unsigned int id);
+    // ranges aren't tracked, they always go through
+    static void bind_buffer_range(unsigned int target, unsigned int index, unsigned int id, uint64_t offset, uint64_t size);
+
+    // the first form binds on the active unit, which is how textures get bound for editing
+    static void bind_texture(unsigned int target, unsigned int id);
+    static void bind_texture(unsigned int unit, unsigned int target, unsigned int id);
+
+    // GL_FRAMEBUFFER sets both the read and draw bindings
+    static void bind_framebuffer(unsigned int target, unsigned int id);
+
+    static void set_enabled(unsigned int capability, bool enabled);
+    static void set_depth_mask(bool write);
+    static void set_depth_func(unsigned int func);
+    static void set_stencil_func(unsigned int func, int ref, unsigned int mask);
+    static void set_stencil_op(unsigned int stencil_fail, unsigned int depth_fail, unsigned int depth_pass);
+    static void set_stencil_mask(unsigned int mask);
+    static void set_blend_func(unsigned int source, unsigned int destination);
+    static void set_viewport(int x, int y, int width, int height);
+
+    // only asks GL when the viewport isn't known
+    static void get_viewport(int viewport[4]);
+
+    // GL drops the bindings of deleted objects and names get reused, so the cache has to let go of them too
+    static void forget_program(unsigned int id);
+    static void forget_vertex_array(unsigned int id);
+    static void forget_buffer(unsigned int id);
+    static void forget_texture(unsigned int id);
+    static void forget_framebuffer(unsigned int id);
+
+    // for code that changes state without going through here, like the imgui backend
+    static void invalidate();
+
+    // the counters below are for the frame that just ended
+    static void end_frame();
+    [[nodiscard]] static size_t get_num_issued() { return m_last_num_issued; }
+    [[nodiscard]] static size_t get_num_skipped() { return m_last_num_skipped; }
+    [[nodiscard]] static size_t get_num_program_switches() { return m_last_num_program_switches; }
+
+private:
+    static constexpr unsigned int UNKNOWN = UINT32_MAX;
+    static constexpr unsigned int MAX_TEXTURE_UNITS = 32;
+    static constexpr unsigned int MAX_BUFFER_INDICES = 16;
+
+    enum BufferSlot { ArrayBuffer = 0, ElementBuffer, UniformBuffer, StorageBuffer, NumBufferSlots };
+    enum TextureSlot { Texture2D = 0, Texture2DMultisample, TextureCubeMap, NumTextureSlots };
+
+    [[nodiscard]] static bool changes(unsigned int& cached, unsigned int value);
+
+    static unsigned int m_program;
+    static unsigned int m_vertex_array;
+    static unsigned int m_buffers[NumBufferSlots];
+    static unsigned int m_indexed_buffers[NumBufferSlots][MAX_BUFFER_INDICES];
+    static unsigned int m_active_texture;
+    static unsigned int m_textures[MAX_TEXTURE_UNITS][NumTextureSlots];
+    static unsigned int m_read_framebuffer, m_draw_framebuffer;
+
+    static std::unordered_map<unsigned int, bool> m_capabilities;
+    static unsigned int m_depth_mask, m_depth_func;
+    static unsigned int m_stencil_func, m_stencil_ref, m_stencil_func_mask;
+    static unsigned int m_stencil_fail, m_stencil_depth_fail, m_stencil_depth_pass;
+    static unsigned int m_stencil_mask;
+    static unsigned int m_blend_source, m_blend_destination;
+    static int m_viewport[4];
+    static bool m_viewport_known;
+
+    static size_t m_num_issued, m_num_skipped;
+    static size_t m_last_num_issued, m_last_num_skipped;
+    static size_t m_num_program_switches, m_last_num_program_switches;
+};
@@ -4,6 +4,11 @@
 #include "Shader.h"
 #include "Log.h"
 
+static const Uniform<int> u_using_textures("u_using_textures");
+static const Uniform<glm::vec4> u_base_colour("u_base_colour");
+static const Uniform<float> u_metallic("u_metallic");
+static const Uniform<float> u_roughness("u_roughness");
+
 void Material::load(const std::string* const textures)
 {
     m_texture_locations[0] = textures[0];
@@ -11,47 +16,99 @@ void Material::load(const std::string* const textures)
     m_texture_locations[2] = textures[2];
     m_texture_locations[3] = textures[3];
 
-    m_textures[0] = std::make_unique<Texture2D>(Texture2D(textures[0]));
-    m_textures[1] = (textures[1] != "none" && !textures[1].empty()) ? std::make_unique<Texture2D>(Texture2D(textures[1])) : nullptr;
-    m_textures[2] = (textures[2] != "none" && !textures[2].empty()) ? std::make_unique<Texture2D>(Texture2D(textures[2])) : nullptr;
-    m_textures[3] = (textures[3] != "none" && !textures[3].empty()) ? std::make_unique<Texture2D>(Texture2D(textures[3])) : nullptr;
+    m_textures[0] = TextureTable::get(textures[0]);
+    m_textures[1] = (textures[1] != "none" && !textures[1].empty()) ? TextureTable::get(textures[1]) : nullptr;
+    m_textures[2] = (textures[2] != "none" && !textures[2].empty()) ? TextureTable::get(textures[2]) : nullptr;
+    m_textures[3] = (textures[3] != "none" && !textures[3].empty()) ? TextureTable::get(textures[3]) : nullptr;
 }
 
 void Material::bind() const
 {
-    m_shader->set_uniform_1i("u_using_textures", m_using_textures);
+    m_shader->set_uniform(u_using_textures, (int)m_using_textures);
 
     if (!m_using_textures)
     {
-        m_shader->set_uniform_4f("u_base_colour", m_colour);
-        m_shader->set_uniform_1f("u_metallic", m_metallic);
-        m_shader->set_uniform_1f("u_roughness", m_roughness);
+        m_shader->set_uniform(u_base_colour, m_colour);
+        m_shader->set_uniform(u_metallic, m_metallic);
+        m_shader->set_uniform(u_roughness, m_roughness);
     }
     else
     {
-        for (unsigned int i = 0; i < 4; ++i)
-        {
-            if(m_textures[i])
-                m_textures[i]->bind(i);
-        }
+        bind_textures();
     }
 
     m_shader->bind();
 }
 
+void Material::bind_textures() const
+{
+    if (!m_using_textures)
+        return;
+
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        if(m_textures[i])
+            m_textures[i]->bind(i);
+    }
+}
+
 void Material::unbind() const
 {
     if (m_using_textures)
     {
         for (const auto& m_texture : m_textures)
         {
-            m_texture->unbind();
+            if (m_texture)
+                m_texture->unbind();
         }
     }
     
     m_shader->unbind();
 }
 
+static LightingModel lighting_model_of(const std::shared_ptr<ShaderProgram>& shader)
+{
+    // permutations share the lighting model of their base program
+    std::string name = ShaderTable::find(shader);
+    name = name.substr(0, name.find('['));
+
+    if (name == "default")
+        return LightingModel::Default;
+
+    if (name == "pbr_standard")
+        return LightingModel::PBR;
+
+    if (name == "blinn-phong")
+        return LightingModel::BlinnPhong;
+
+    return LightingModel::Other;
+}
+
+void Material::set_shader(const std::shared_ptr<ShaderProgram>& shader)
+{
+    m_shader = shader;
+
+    // looking the name up is a scan of the shader table, too slow to do for every material every frame
+    m_lighting_model = lighting_model_of(shader);
+}
+
+MaterialData Material::get_data(LightingModel lighting_model) const
+{
+    return { m_colour, m_metallic, m_roughness, lighting_model, (uint32_t)m_using_textures };
+}
+
+void Material::request_size(float screen_size) const
+{
+    if (!m_using_textures)
+        return;
+
+    for (const auto& texture : m_textures)
+    {
+        if (texture)
+            texture->request_size(screen_size);
+    }
+}
+
 std::unordered_map<std::string, std::shared_ptr<Material>> MaterialTable::m_materials;
 
 void MaterialTable::add(const std::string& name, Material&& m)
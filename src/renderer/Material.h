@@ -2,19 +2,51 @@
 
 #include "renderer/Fwd.h"
 
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <glm/vec4.hpp>
 
+// the lighting model the uber shader shades a material with, the values match materials.glsl
+// Other is for shaders it doesn't cover, those materials always draw with their own program
+enum class LightingModel : uint32_t
+{
+    Default = 0,
+    PBR,
+    BlinnPhong,
+    Other
+};
+
+// one entry of the uber shader's materials buffer, laid out like MaterialData in materials.glsl
+struct MaterialData
+{
+    glm::vec4 colour;
+    float metallic;
+    float roughness;
+    LightingModel lighting_model;
+    uint32_t using_textures;
+};
+
+static_assert(sizeof(MaterialData) == 32);
+
 class Material
 {
 public:
-	void set_shader(const std::shared_ptr<ShaderProgram>& shader) { m_shader = shader; }
+	void set_shader(const std::shared_ptr<ShaderProgram>& shader);
 	[[nodiscard]] const std::shared_ptr<ShaderProgram>& get_shader() const { return m_shader; }
 
 	void load(const std::string* textures);
 	void bind() const;
 	void unbind() const;
+	// only the textures, for programs that read the rest of the material from the materials buffer
+	void bind_textures() const;
+
+	// worked out from the shader's name whenever the shader is set
+	[[nodiscard]] LightingModel get_lighting_model() const { return m_lighting_model; }
+	[[nodiscard]] MaterialData get_data(LightingModel lighting_model) const;
+
+    // lets streamed textures know how many pixels across the material is drawn
+    void request_size(float screen_size) const;
 
 	void set_colour(const glm::vec4& colour) { m_colour = colour; }
 	void set_metallic_property(float new_val) { m_metallic = new_val; }
@@ -23,8 +55,9 @@ public:
 
 private:
 	std::shared_ptr<ShaderProgram> m_shader;
+	LightingModel m_lighting_model = LightingModel::Other;
 	bool m_using_textures = false;
-	std::unique_ptr<Texture2D> m_textures[4];
+	std::shared_ptr<Texture2D> m_textures[4];
     std::string m_texture_locations[4];
 
     // custom properties
@@ -11,12 +11,21 @@ Mesh::Mesh(Mesh&& mesh) noexcept
 {
     m_va = std::move(mesh.m_va);
     m_indices_count = mesh.m_indices_count;
+    m_bounding_radius = mesh.m_bounding_radius;
 }
 
 void Mesh::load(const std::vector<float>& verts, const std::vector<unsigned int>& indices)
 {
     m_indices_count = indices.size();
 
+    // position, normal, uv
+    constexpr size_t VERTEX_FLOATS = 8;
+    float max_length_sq = 0.f;
+    for (size_t i = 0; i + 2 < verts.size(); i += VERTEX_FLOATS)
+        max_length_sq = std::max(max_length_sq, verts[i] * verts[i] + verts[i + 1] * verts[i + 1] + verts[i + 2] * verts[i + 2]);
+
+    m_bounding_radius = std::sqrt(max_length_sq);
+
     m_va.bind();
 
     Buffer vertex_buffer{verts.size() * sizeof(float), BufferType::VERTEX};
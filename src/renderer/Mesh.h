@@ -31,10 +31,13 @@ public:
 
     [[nodiscard]] unsigned int get_index_count() const { return m_indices_count; }
     [[nodiscard]] bool is_instanced() const { return m_instanced; }
+    // distance from the origin to the furthest vertex
+    [[nodiscard]] float get_bounding_radius() const { return m_bounding_radius; }
 
 private:
     unsigned int m_indices_count = 0;
     bool m_instanced = false;
+    float m_bounding_radius = 0.f;
     VertexArray m_va;
     std::unique_ptr<Buffer> m_instance_buffer;
 };
@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "ProgramCache.h"
+#include "Shader.h"
+#include "FileSystem.h"
+#include "Hash.h"
+#include "GLError.h"
+#include "Log.h"
+
+#include <glad/glad.h>
+#include <cstring>
+
+struct ProgramBinaryHeader
+{
+    char magic[4] = { 'T', 'B', 'P', 'B' };
+    uint32_t version = 1;
+    uint32_t format = 0;
+    uint32_t size = 0;
+};
+
+std::string ProgramCache::m_dir;
+uint64_t ProgramCache::m_driver_hash = 0;
+int ProgramCache::m_supported = -1;
+size_t ProgramCache::m_num_hits = 0;
+size_t ProgramCache::m_num_misses = 0;
+
+void ProgramCache::set_directory(const std::string& dir)
+{
+    m_dir = dir;
+}
+
+bool ProgramCache::is_enabled()
+{
+    if (m_dir.empty())
+        return false;
+
+    // some drivers don't give out binaries at all
+    if (m_supported == -1)
+    {
+        int num_formats = 0;
+        GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats));
+        m_supported = (num_formats > 0) ? 1 : 0;
+
+        if (!m_supported)
+            info("Driver has no program binary formats, shaders will always be compiled\n");
+    }
+
+    return m_supported == 1;
+}
+
+std::string ProgramCache::get_path(uint64_t key)
+{
+    return (std::filesystem::path(m_dir) / (hash_to_string(key) + ".bin")).string();
+}
+
+uint64_t ProgramCache::make_key(const std::vector<Shader>& shaders, const std::vector<std::string>& sources)
+{
+    if (m_driver_hash == 0)
+    {
+        // a driver update can change what it accepts, so the version counts as well
+        for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            GL_CALL(const char* str = (const char*)glGetString(name));
+            m_driver_hash = hash_combine(m_driver_hash, hash_string(str ? str : ""));
+        }
+    }
+
+    uint64_t key = m_driver_hash;
+    for (size_t i = 0; i < shaders.size(); ++i)
+    {
+        key = hash_combine(key, (uint64_t)shaders[i].type);
+        key = hash_combine(key, hash_string(sources[i]));
+    }
+
+    return key;
+}
+
+bool ProgramCache::load(unsigned int program, uint64_t key)
+{
+    if (!is_enabled())
+        return false;
+
+    std::string path = get_path(key);
+
+    std::vector<unsigned char> bytes;
+    if (!FileSystem::read(path, bytes))
+    {
+        ++m_num_misses;
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    if (bytes.size() < sizeof(header) || std::memcmp(bytes.data(), header.magic, 4) != 0)
+    {
+        warn("Ignoring corrupt program binary {}\n", path);
+        ++m_num_misses;
+        return false;
+    }
+
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (header.version != ProgramBinaryHeader{}.version || header.size != bytes.size() - sizeof(header))
+    {
+        ++m_num_misses;
+        return false;
+    }
+
+    GL_CALL(glProgramBinary(program, header.format, bytes.data() + sizeof(header), (int)header.size));
+
+    // a binary the driver doesn't like just fails to link, it isn't a GL error
+    int linked = 0;
+    GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+    if (!linked)
+    {
+        info("Program binary {} was rejected by the driver, compiling instead\n", path);
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        ++m_num_misses;
+        return false;
+    }
+
+    ++m_num_hits;
+    return true;
+}
+
+void ProgramCache::store(unsigned int program, uint64_t key)
+{
+    if (!is_enabled())
+        return;
+
+    int length = 0;
+    GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+        return;
+
+    std::vector<unsigned char> bytes(sizeof(ProgramBinaryHeader) + length);
+
+    ProgramBinaryHeader header;
+    int written = 0;
+    GLenum format = 0;
+    GL_CALL(glGetProgramBinary(program, length, &written, &format, bytes.data() + sizeof(header)));
+
+    header.format = format;
+    header.size = (uint32_t)written;
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    bytes.resize(sizeof(header) + written);
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_dir, ec);
+
+    // written next to the real name first so a crash can't leave half a binary behind
+    std::string path = get_path(key);
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+        if (!out)
+        {
+            warn("Could not write program binary {}\n", temp_path);
+            return;
+        }
+    }
+
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+        warn("Could not write program binary {}\n", path);
+}
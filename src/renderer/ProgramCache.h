@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Shader;
+
+// linked programs saved with glGetProgramBinary so later launches can skip compiling and linking
+// binaries only work with the driver that made them, so the driver is part of the key along with the sources
+class ProgramCache
+{
+public:
+    // an empty directory turns the cache off
+    static void set_directory(const std::string& dir);
+
+    [[nodiscard]] static uint64_t make_key(const std::vector<Shader>& shaders, const std::vector<std::string>& sources);
+
+    // false if there's no binary for the key or the driver won't take it, the program then has to be built from source
+    static bool load(unsigned int program, uint64_t key);
+    static void store(unsigned int program, uint64_t key);
+
+    [[nodiscard]] static size_t get_num_hits() { return m_num_hits; }
+    [[nodiscard]] static size_t get_num_misses() { return m_num_misses; }
+
+private:
+    [[nodiscard]] static bool is_enabled();
+    [[nodiscard]] static std::string get_path(uint64_t key);
+
+    static std::string m_dir;
+    static uint64_t m_driver_hash;
+    static int m_supported; // -1 until it's been asked for
+
+    static size_t m_num_hits;
+    static size_t m_num_misses;
+};
@@ -1,34 +1,53 @@
 #include "pch.h"
 #include "Renderer.h"
 #include "GLError.h"
+#include "GLState.h"
 #include "Shader.h"
 #include "Mesh.h"
 #include "Material.h"
+#include "Buffer.h"
+#include "ShaderReflection.h"
 #include "components/Transform.h"
 
 #include <glad/glad.h>
 
+static const Uniform<glm::mat4> u_model("u_model");
+static const Uniform<glm::vec4> u_flat_colour("u_flat_colour");
+static const Uniform<glm::vec4> u_base_colour("u_base_colour");
+static const Uniform<float> u_outlining_factor("u_outlining_factor");
+static const Uniform<int> u_material_index("u_material_index");
+
+static const std::string inst_shadow_map_key = ShaderTable::make_key("shadow_map", { "INSTANCED" });
+static const std::string inst_uber_key = ShaderTable::make_key("uber", { "INSTANCED" });
+
+static constexpr unsigned int MATERIAL_BINDING = 4;
+
+bool Renderer::m_uber_shader = false;
+std::unique_ptr<Buffer> Renderer::m_material_buffer;
+uint64_t Renderer::m_material_buffer_size = 0;
+std::unordered_map<const Material*, int> Renderer::m_material_indices;
+
 void Renderer::init(int width, int height)
 {
 	set_viewport(width, height);
 
-    GL_CALL(glEnable(GL_MULTISAMPLE));
-    GL_CALL(glEnable(GL_CULL_FACE));
-    GL_CALL(glEnable(GL_BLEND));
-    GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
-	GL_CALL(glEnable(GL_STENCIL_TEST));
-	GL_CALL(glEnable(GL_DEPTH_TEST));
-	GL_CALL(glDepthFunc(GL_LEQUAL));
-    GL_CALL(glEnable(GL_FRAMEBUFFER_SRGB));
-
-    GL_CALL(glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP));
-    GL_CALL(glStencilFunc(GL_NOTEQUAL, 1, 0xFF));
-    GL_CALL(glStencilMask(0xFF));
+    GLState::set_enabled(GL_MULTISAMPLE, true);
+    GLState::set_enabled(GL_CULL_FACE, true);
+    GLState::set_enabled(GL_BLEND, true);
+    GLState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::set_enabled(GL_STENCIL_TEST, true);
+	GLState::set_enabled(GL_DEPTH_TEST, true);
+	GLState::set_depth_func(GL_LEQUAL);
+    GLState::set_enabled(GL_FRAMEBUFFER_SRGB, true);
+
+    GLState::set_stencil_op(GL_KEEP, GL_KEEP, GL_KEEP);
+    GLState::set_stencil_func(GL_NOTEQUAL, 1, 0xFF);
+    GLState::set_stencil_mask(0xFF);
 }
 
 void Renderer::set_viewport(int width, int height)
 {
-	GL_CALL(glViewport(0, 0, width, height));
+	GLState::set_viewport(0, 0, width, height);
 }
 
 void Renderer::set_clear_colour(glm::vec4 colour)
@@ -36,102 +55,199 @@ void Renderer::set_clear_colour(glm::vec4 colour)
 	GL_CALL(glClearColor(colour.x, colour.y, colour.z, colour.w));
 }
 
+void Renderer::register_layouts()
+{
+    ShaderReflection::register_layout({ "Materials", MATERIAL_BINDING, true, sizeof(MaterialData), {
+        { "materials[0].colour", offsetof(MaterialData, colour), GL_FLOAT_VEC4 },
+        { "materials[0].metallic", offsetof(MaterialData, metallic), GL_FLOAT },
+        { "materials[0].roughness", offsetof(MaterialData, roughness), GL_FLOAT },
+        { "materials[0].lighting_model", offsetof(MaterialData, lighting_model), GL_UNSIGNED_INT },
+        { "materials[0].using_textures", offsetof(MaterialData, using_textures), GL_BOOL }
+    }});
+}
+
+ShaderProgram& Renderer::get_program(const Material& material, bool instanced)
+{
+    auto it = m_material_indices.find(&material);
+    if (m_uber_shader && it != m_material_indices.end() && it->second >= 0)
+    {
+        std::shared_ptr<ShaderProgram> uber = ShaderTable::get(instanced ? inst_uber_key : "uber");
+        if (uber->is_ready())
+            return *uber;
+    }
+
+    return *material.get_shader();
+}
+
+void Renderer::bind_material(const Material& material, ShaderProgram& program)
+{
+    if (&program == material.get_shader().get())
+    {
+        material.bind();
+        return;
+    }
+
+    program.set_uniform(u_material_index, m_material_indices[&material]);
+    material.bind_textures();
+    program.bind();
+}
+
+void Renderer::upload_materials(const std::vector<RenderObject>& render_list)
+{
+    m_material_indices.clear();
+    if (!m_uber_shader)
+        return;
+
+    std::vector<MaterialData> materials;
+    for (const auto& render_obj : render_list)
+    {
+        const Material& material = render_obj.material.get();
+        if (m_material_indices.contains(&material))
+            continue;
+
+        LightingModel lighting_model = material.get_lighting_model();
+        if (lighting_model == LightingModel::Other)
+        {
+            m_material_indices[&material] = -1;
+            continue;
+        }
+
+        m_material_indices[&material] = (int)materials.size();
+        materials.push_back(material.get_data(lighting_model));
+    }
+
+    if (materials.empty())
+        return;
+
+    // only grows, entries past the ones in use are never read
+    uint64_t size = materials.size() * sizeof(MaterialData);
+    if (size > m_material_buffer_size)
+    {
+        m_material_buffer = std::make_unique<Buffer>(size, BufferType::SHADER_STORAGE);
+        m_material_buffer_size = size;
+    }
+
+    m_material_buffer->set_data(0, materials);
+    m_material_buffer->link(MATERIAL_BINDING);
+}
+
 void Renderer::draw_elements(const Transform& transform, const Mesh& mesh, const Material& material)
 {
-    material.get_shader()->set_uniform_mat4f("u_model", transform.get_transform());
-    material.get_shader()->set_uniform_4f("u_flat_colour", material.get_colour());
+    ShaderProgram& program = get_program(material, false);
+    if (!program.is_ready())
+        return;
 
-	material.bind();
-	mesh.bind();
+    program.set_uniform(u_model, transform.get_transform());
 
-	GL_CALL(glDrawElements(GL_TRIANGLES, mesh.get_index_count(), GL_UNSIGNED_INT, nullptr));
+    // the uber shader reads the colour out of the materials buffer and has no uniform for it
+    if (&program == material.get_shader().get())
+        program.set_uniform(u_flat_colour, material.get_colour());
+
+    bind_material(material, program);
+    mesh.bind();
+
+    GL_CALL(glDrawElements(GL_TRIANGLES, mesh.get_index_count(), GL_UNSIGNED_INT, nullptr));
 }
 
 void Renderer::draw_elements_instanced(unsigned int instances, const Mesh& mesh_obj, const Material& material)
 {
-    material.bind();
+    ShaderProgram& program = get_program(material, true);
+    if (!program.is_ready())
+        return;
+
+    bind_material(material, program);
     mesh_obj.bind();
     GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, mesh_obj.get_index_count(), GL_UNSIGNED_INT, nullptr, instances));
 }
 
 void Renderer::draw_skybox(const Skybox& skybox)
 {
-    GL_CALL(glDisable(GL_CULL_FACE));
-    GL_CALL(glDepthMask(GL_FALSE));
+    if (!skybox.is_ready())
+        return;
+
+    GLState::set_enabled(GL_CULL_FACE, false);
+    GLState::set_depth_mask(false);
     skybox.bind();
     GL_CALL(glDrawElements(GL_TRIANGLES, skybox.get_indices(), GL_UNSIGNED_INT, nullptr));
-    GL_CALL(glDepthMask(GL_TRUE));
+    GLState::set_depth_mask(true);
     skybox.unbind();
-    GL_CALL(glEnable(GL_CULL_FACE));
+    GLState::set_enabled(GL_CULL_FACE, true);
 }
 
 void Renderer::stencil(const Transform& stencil_transform, const Mesh& mesh, const Material& material)
 {
-    GL_CALL(glStencilOp(GL_KEEP, GL_REPLACE, GL_REPLACE));
-	GL_CALL(glStencilFunc(GL_ALWAYS, 2, 0xFF)); // make all the fragments of the object have a stencil of 1
+    const std::shared_ptr<ShaderProgram>& flat_colour = ShaderTable::get("flat_colour");
+    ShaderProgram& program = get_program(material, false);
+    if (!program.is_ready() || !flat_colour->is_ready())
+        return;
+
+    GLState::set_stencil_op(GL_KEEP, GL_REPLACE, GL_REPLACE);
+	GLState::set_stencil_func(GL_ALWAYS, 2, 0xFF); // make all the fragments of the object have a stencil of 1
 	
-	material.bind();
+	bind_material(material, program);
 	mesh.bind();
 	GL_CALL(glDrawElements(GL_TRIANGLES, mesh.get_index_count(), GL_UNSIGNED_INT, nullptr));
 
-    ShaderTable::get("flat_colour")->set_uniform_mat4f("u_model", stencil_transform.get_transform());
-    ShaderTable::get("flat_colour")->set_uniform_4f("u_flat_colour", {1.f, 1.f, 0.f, 1.f});
-	ShaderTable::get("flat_colour")->bind();
-    GL_CALL(glStencilOp(GL_KEEP, GL_KEEP, GL_INCR));
-	GL_CALL(glStencilFunc(GL_NOTEQUAL, 2, 0xFF)); // now all fragments not apart of the original object are written
+    flat_colour->set_uniform(u_model, stencil_transform.get_transform());
+    flat_colour->set_uniform(u_flat_colour, {1.f, 1.f, 0.f, 1.f});
+	flat_colour->bind();
+    GLState::set_stencil_op(GL_KEEP, GL_KEEP, GL_INCR);
+	GLState::set_stencil_func(GL_NOTEQUAL, 2, 0xFF); // now all fragments not apart of the original object are written
 
 	GL_CALL(glDrawElements(GL_TRIANGLES, mesh.get_index_count(), GL_UNSIGNED_INT, nullptr));
 	
 	// set back to normal for other objects
-    GL_CALL(glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP));
-	GL_CALL(glStencilFunc(GL_NOTEQUAL, 1, 0xFF));
+    GLState::set_stencil_op(GL_KEEP, GL_KEEP, GL_KEEP);
+	GLState::set_stencil_func(GL_NOTEQUAL, 1, 0xFF);
 
 }
 
 void Renderer::shadow_pass(const std::vector<RenderObject> &render_list, unsigned int shadow_width, unsigned int shadow_height, bool using_cubemap)
 {
     GL_CALL(glClear(GL_DEPTH_BUFFER_BIT));
-    GLint viewport_size[4];
-    glGetIntegerv( GL_VIEWPORT, viewport_size );
+    int viewport_size[4];
+    GLState::get_viewport(viewport_size);
 
     int original_width = viewport_size[2];
     int original_height = viewport_size[3];
 
-    glViewport(0, 0, (int)shadow_width, (int)shadow_height);
+    GLState::set_viewport(0, 0, (int)shadow_width, (int)shadow_height);
     for(const auto& render_obj : render_list)
     {
         const Mesh& mesh = render_obj.mesh.get_mesh().operator*();
 
         if(mesh.is_instanced())
         {
-            ShaderTable::get("inst_shadow_map")->bind();
+            const std::shared_ptr<ShaderProgram>& inst_shadow_map = ShaderTable::get(inst_shadow_map_key);
+            if (!inst_shadow_map->is_ready())
+                continue;
+
+            inst_shadow_map->bind();
             mesh.bind();
             GL_CALL(glDrawElementsInstanced(GL_TRIANGLES, mesh.get_index_count(), GL_UNSIGNED_INT, nullptr, render_obj.instances));
         }
         else
         {
-            if(using_cubemap)
-            {
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_model", render_obj.transform.get_transform());
-                ShaderTable::get("shadow_cubemap")->bind();
-            }
-            else
-            {
-                ShaderTable::get("shadow_map")->set_uniform_mat4f("u_model", render_obj.transform.get_transform());
-                ShaderTable::get("shadow_map")->bind();
-            }
+            const std::shared_ptr<ShaderProgram>& shadow_map = ShaderTable::get(using_cubemap ? "shadow_cubemap" : "shadow_map");
+            if (!shadow_map->is_ready())
+                continue;
+
+            shadow_map->set_uniform(u_model, render_obj.transform.get_transform());
+            shadow_map->bind();
 
             mesh.bind();
             GL_CALL(glDrawElements(GL_TRIANGLES, mesh.get_index_count(), GL_UNSIGNED_INT, nullptr));
         }
     }
-    glViewport(0, 0, original_width, original_height);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLState::set_viewport(0, 0, original_width, original_height);
+    GLState::bind_framebuffer(GL_FRAMEBUFFER, 0);
 
 }
 
 void Renderer::render_pass(const std::vector<RenderObject>& render_list)
 {
+   upload_materials(render_list);
+
    for(const auto& render_obj : render_list)
    {
         const Mesh& mesh = render_obj.mesh.get_mesh().operator*();
@@ -153,18 +269,20 @@ void Renderer::render_pass(const std::vector<RenderObject>& render_list)
 
             case RenderCommand::Stencil:
             {
-                material.get_shader()->set_uniform_mat4f("u_model", render_obj.transform.get_transform());
-                material.get_shader()->set_uniform_4f("u_base_colour", material.get_colour());
+                ShaderProgram& program = get_program(material, false);
+                program.set_uniform(u_model, render_obj.transform.get_transform());
+                if (&program == material.get_shader().get())
+                    program.set_uniform(u_base_colour, material.get_colour());
                 Transform stencil_transform = render_obj.transform;
 
                 if(render_obj.mesh.is_using_scale_outline())
                 {
-                    ShaderTable::get("flat_colour")->set_uniform_1f("u_outlining_factor", 0.f);
+                    ShaderTable::get("flat_colour")->set_uniform(u_outlining_factor, 0.f);
                     stencil_transform.scale(stencil_transform.get_uniform_scale() * (1.f + render_obj.mesh.get_scale_outline_factor())); // scale up a tiny bit to see outline
                     stencil_transform.recalculate_transform();
                 }
                 else
-                    ShaderTable::get("flat_colour")->set_uniform_1f("u_outlining_factor", render_obj.mesh.get_scale_outline_factor());
+                    ShaderTable::get("flat_colour")->set_uniform(u_outlining_factor, render_obj.mesh.get_scale_outline_factor());
 
                 stencil(stencil_transform, mesh, material);
                 break;
@@ -8,8 +8,12 @@
 #include "Material.h"
 
 #include <list>
+#include <memory>
+#include <unordered_map>
 #include <glm/vec4.hpp>
 
+class Buffer;
+
 enum class RenderCommand
 {
     ElementDraw = 0,
@@ -39,5 +43,25 @@ public:
     static void shadow_pass(const std::vector<RenderObject>& render_list, unsigned int shadow_width = 2048, unsigned int shadow_height = 2048, bool using_cubemap = false);
     static void render_pass(const std::vector<RenderObject>& render_list);
 	static void clear();
+
+    // draws every material the uber program covers with it instead of the material's own program
+    // the specialised programs still draw everything else, and stand in while the uber program compiles
+    static void set_uber_shader(bool enabled) { m_uber_shader = enabled; }
+    [[nodiscard]] static bool is_using_uber_shader() { return m_uber_shader; }
+
+    // the layout of the materials buffer, checked against every program that links after this
+    static void register_layouts();
+
+private:
+    static ShaderProgram& get_program(const Material& material, bool instanced);
+    static void bind_material(const Material& material, ShaderProgram& program);
+    // gives each material in the list its entry in the materials buffer
+    static void upload_materials(const std::vector<RenderObject>& render_list);
+
+    static bool m_uber_shader;
+    static std::unique_ptr<Buffer> m_material_buffer;
+    static uint64_t m_material_buffer_size;
+    // -1 for materials the uber program doesn't cover
+    static std::unordered_map<const Material*, int> m_material_indices;
 };
 
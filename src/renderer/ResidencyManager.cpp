@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "ResidencyManager.h"
+#include "Texture.h"
+#include "AsyncLoader.h"
+#include "TextureData.h"
+#include "Log.h"
+
+#include <algorithm>
+
+// a texture has to go this many frames without being bound before it can lose anything
+static constexpr uint64_t KEEP_FRAMES = 60;
+
+// evicted textures keep their small mips so they can still be drawn while the rest loads back in
+static constexpr uint32_t EVICTED_SIZE = 64;
+
+std::vector<ResidencyManager::Entry> ResidencyManager::m_entries;
+uint64_t ResidencyManager::m_budget = 512ull * 1024 * 1024;
+uint64_t ResidencyManager::m_usage = 0;
+size_t ResidencyManager::m_num_evictions = 0;
+size_t ResidencyManager::m_num_reloads = 0;
+uint64_t ResidencyManager::m_frame = 0;
+
+void ResidencyManager::update()
+{
+    ++m_frame;
+
+    std::erase_if(m_entries, [](const Entry& entry) { return entry.texture.expired(); });
+
+    m_usage = 0;
+    std::vector<std::pair<uint64_t, size_t>> idle; // last used and index, oldest gets evicted first
+
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        Entry& entry = m_entries[i];
+        std::shared_ptr<Texture2D> texture = entry.texture.lock();
+
+        // materials bind their textures to units rather than by handle, so only dropping mips frees anything
+        if (m_frame - texture->get_last_used() <= KEEP_FRAMES)
+        {
+            if (entry.evicted)
+                reload(entry, texture);
+        }
+        else if (!entry.evicted)
+        {
+            idle.emplace_back(texture->get_last_used(), i);
+        }
+
+        m_usage += texture->get_num_bytes();
+    }
+
+    if (m_usage <= m_budget)
+        return;
+
+    std::sort(idle.begin(), idle.end());
+
+    for (const auto& [last_used, index] : idle)
+    {
+        Entry& entry = m_entries[index];
+        std::shared_ptr<Texture2D> texture = entry.texture.lock();
+
+        uint64_t bytes = texture->get_num_bytes();
+        if (texture->drop_mips(EVICTED_SIZE))
+        {
+            m_usage -= bytes - texture->get_num_bytes();
+            entry.evicted = true;
+            ++m_num_evictions;
+        }
+
+        if (m_usage <= m_budget)
+            break;
+    }
+}
+
+void ResidencyManager::track(const std::shared_ptr<Texture2D>& texture, const std::string& file_path, bool gamma_correct)
+{
+    m_entries.push_back({ texture, file_path, gamma_correct });
+}
+
+void ResidencyManager::release()
+{
+    m_entries.clear();
+    m_usage = 0;
+}
+
+// the evicted texture keeps drawing with its small mips until the full chain is back
+void ResidencyManager::reload(Entry& entry, const std::shared_ptr<Texture2D>& texture)
+{
+    entry.evicted = false;
+
+    // the streamer brings the levels back as draws ask for them
+    if (texture->is_streamed())
+        return;
+
+    ++m_num_reloads;
+
+    if (AsyncLoader::is_enabled())
+    {
+        AsyncLoader::request_texture(entry.file_path, texture, entry.gamma_correct);
+        return;
+    }
+
+    TextureData texture_data;
+    if (!load_texture_data(entry.file_path, texture_data, entry.gamma_correct, true))
+    {
+        warn("Could not reload image: {}\n", entry.file_path);
+        return;
+    }
+
+    texture->upload(texture_data, entry.gamma_correct);
+}
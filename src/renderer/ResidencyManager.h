@@ -0,0 +1,45 @@
+#pragma once
+
+#include "renderer/Fwd.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// keeps the textures loaded through the texture table within a memory budget
+// anything bound in the last few frames keeps its full mip chain, under pressure the rest loses its big mips
+class ResidencyManager
+{
+public:
+    // called once a frame from the GL thread, before anything gets drawn
+    static void update();
+
+    static void track(const std::shared_ptr<Texture2D>& texture, const std::string& file_path, bool gamma_correct);
+    static void release();
+
+    static void set_budget(uint64_t bytes) { m_budget = bytes; }
+    [[nodiscard]] static uint64_t get_budget() { return m_budget; }
+    [[nodiscard]] static uint64_t get_usage() { return m_usage; }
+    [[nodiscard]] static size_t get_num_tracked() { return m_entries.size(); }
+    [[nodiscard]] static size_t get_num_evictions() { return m_num_evictions; }
+    [[nodiscard]] static size_t get_num_reloads() { return m_num_reloads; }
+    [[nodiscard]] static uint64_t get_frame() { return m_frame; }
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<Texture2D> texture;
+        std::string file_path;
+        bool gamma_correct;
+        bool evicted = false;
+    };
+
+    static void reload(Entry& entry, const std::shared_ptr<Texture2D>& texture);
+
+    static std::vector<Entry> m_entries;
+    static uint64_t m_budget;
+    static uint64_t m_usage;
+    static size_t m_num_evictions;
+    static size_t m_num_reloads;
+    static uint64_t m_frame;
+};
@@ -2,8 +2,19 @@
 #include "Shader.h"
 #include "Log.h"
 #include "GLError.h"
+#include "GLState.h"
+#include "ProgramCache.h"
+#include "FileWatcher.h"
+#include "ShaderPreprocessor.h"
 
 #include <glad/glad.h>
+#include <chrono>
+#include <cstring>
+
+// GL_KHR_parallel_shader_compile isn't in the generated loader
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 GLenum get_gl_shader_type(ShaderType type)
 {
@@ -24,51 +35,183 @@ GLenum get_gl_shader_type(ShaderType type)
 	return GL_FALSE;
 }
 
-ShaderProgram::ShaderProgram(ShaderProgram&& sp) noexcept
+struct UniformRegistry
 {
-	m_program_id = sp.m_program_id;
-	sp.m_program_id = 0;
+	std::unordered_map<std::string, uint32_t> ids;
+	std::vector<std::string> names;
+};
 
-    m_shaders = sp.m_shaders;
+// handles are made during static initialisation so this can't be a plain static
+static UniformRegistry& get_uniform_registry()
+{
+	static UniformRegistry registry;
+	return registry;
 }
 
-ShaderProgram::~ShaderProgram()
+uint32_t get_uniform_id(const std::string& name)
 {
-    delete_shaders();
-	GL_CALL(glDeleteProgram(m_program_id));	
+	UniformRegistry& registry = get_uniform_registry();
+
+	auto it = registry.ids.find(name);
+	if (it != registry.ids.end())
+		return it->second;
+
+	auto id = (uint32_t)registry.names.size();
+	registry.ids.emplace(name, id);
+	registry.names.push_back(name);
+	return id;
 }
 
-void ShaderProgram::bind() const
+const std::string& get_uniform_name(uint32_t id)
 {
-	GL_CALL(glUseProgram(m_program_id));
+	return get_uniform_registry().names[id];
 }
 
-void ShaderProgram::unbind() const
+enum UniformType : uint8_t
 {
-	GL_CALL(glUseProgram(0));
+	UNIFORM_INT,
+	UNIFORM_FLOAT,
+	UNIFORM_VEC2,
+	UNIFORM_VEC3,
+	UNIFORM_VEC4,
+	UNIFORM_MAT4
+};
+
+template<typename T>
+static constexpr uint8_t uniform_type()
+{
+	if constexpr (std::is_same_v<T, int>) return UNIFORM_INT;
+	else if constexpr (std::is_same_v<T, float>) return UNIFORM_FLOAT;
+	else if constexpr (std::is_same_v<T, glm::vec2>) return UNIFORM_VEC2;
+	else if constexpr (std::is_same_v<T, glm::vec3>) return UNIFORM_VEC3;
+	else if constexpr (std::is_same_v<T, glm::vec4>) return UNIFORM_VEC4;
+	else return UNIFORM_MAT4;
 }
 
-void ShaderProgram::create_program()
+static void send_uniform(unsigned int program, int location, uint8_t type, const void* value)
 {
-	GL_CALL(m_program_id = glCreateProgram());
+	const auto* v = (const float*)value;
+
+	switch (type)
+	{
+	case UNIFORM_INT:
+		GL_CALL(glProgramUniform1i(program, location, *(const int*)value));
+		break;
+	case UNIFORM_FLOAT:
+		GL_CALL(glProgramUniform1f(program, location, v[0]));
+		break;
+	case UNIFORM_VEC2:
+		GL_CALL(glProgramUniform2f(program, location, v[0], v[1]));
+		break;
+	case UNIFORM_VEC3:
+		GL_CALL(glProgramUniform3f(program, location, v[0], v[1], v[2]));
+		break;
+	case UNIFORM_VEC4:
+		GL_CALL(glProgramUniform4f(program, location, v[0], v[1], v[2], v[3]));
+		break;
+	case UNIFORM_MAT4:
+		GL_CALL(glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, v));
+		break;
+	default:
+		break;
+	}
 }
 
-// TODO: Add const back in
-std::string ShaderProgram::load_shader(const Shader& s) 
+// checked once, the driver compiles on its own threads and can be asked if it is done
+static bool has_parallel_compile()
 {
-	std::string line;
-	std::ifstream stream(s.file_path);
-
-	std::stringstream ss;
+	static int supported = -1;
 
-	while (getline(stream, line))
+	if (supported == -1)
 	{
-		ss << line << "\n";
+		supported = 0;
+
+		int num_extensions = 0;
+		GL_CALL(glGetIntegerv(GL_NUM_EXTENSIONS, &num_extensions));
+		for (int i = 0; i < num_extensions; ++i)
+		{
+			GL_CALL(const auto* name = (const char*)glGetStringi(GL_EXTENSIONS, i));
+			if (std::strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(name, "GL_ARB_parallel_shader_compile") == 0)
+			{
+				supported = 1;
+				break;
+			}
+		}
+
+		info("Parallel shader compilation {}\n", supported ? "supported" : "not supported, programs finish on first use");
 	}
 
-	stream.close();
-	
-	return ss.str();
+	return supported;
+}
+
+// without the extension asking would block anyway so the work is treated as done
+static bool shader_complete(unsigned int id)
+{
+	if (!has_parallel_compile())
+		return true;
+
+	int complete = 0;
+	GL_CALL(glGetShaderiv(id, GL_COMPLETION_STATUS_KHR, &complete));
+	return complete;
+}
+
+static bool program_complete(unsigned int id)
+{
+	if (!has_parallel_compile())
+		return true;
+
+	int complete = 0;
+	GL_CALL(glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &complete));
+	return complete;
+}
+
+size_t ShaderProgram::m_num_uniform_sets = 0;
+size_t ShaderProgram::m_num_uniform_skips = 0;
+
+ShaderProgram::ShaderProgram(ShaderProgram&& sp) noexcept
+{
+	m_program_id = sp.m_program_id;
+	sp.m_program_id = 0;
+
+	m_building_id = sp.m_building_id;
+	sp.m_building_id = 0;
+
+	m_status = sp.m_status;
+	m_cache_key = sp.m_cache_key;
+    m_shaders = sp.m_shaders;
+	m_defines = std::move(sp.m_defines);
+	m_dependencies = std::move(sp.m_dependencies);
+	m_reflection = std::move(sp.m_reflection);
+	m_uniforms = std::move(sp.m_uniforms);
+	m_pending_uniforms = std::move(sp.m_pending_uniforms);
+	m_missing_uniforms = std::move(sp.m_missing_uniforms);
+}
+
+ShaderProgram::ShaderProgram(std::vector<Shader> shaders, std::vector<std::string> defines)
+	: m_shaders(std::move(shaders)), m_defines(std::move(defines))
+{
+	// the shader objects belong to the program the list came from
+	for (Shader& s : m_shaders)
+		s.id = 0;
+
+	build();
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    discard_build();
+	GLState::forget_program(m_program_id);
+	GL_CALL(glDeleteProgram(m_program_id));
+}
+
+void ShaderProgram::bind() const
+{
+	GLState::use_program(m_program_id);
+}
+
+void ShaderProgram::unbind() const
+{
+	GLState::use_program(0);
 }
 
 void ShaderProgram::create_shader(Shader& s, const std::string& src) const
@@ -79,170 +222,473 @@ void ShaderProgram::create_shader(Shader& s, const std::string& src) const
 	GL_CALL(glShaderSource(s.id, 1, &shader_src, nullptr));
 }
 
-void ShaderProgram::compile_shader(unsigned int id) const
+bool ShaderProgram::check_compile(const Shader& s) const
 {
-	GL_CALL(glCompileShader(id));
-
 	int success = 0;
-	GL_CALL(glGetShaderiv(id, GL_COMPILE_STATUS, &success));
+	GL_CALL(glGetShaderiv(s.id, GL_COMPILE_STATUS, &success));
 
 	if (!success)
 	{
 		int log_sz;
-		GL_CALL(glGetShaderiv(id, GL_INFO_LOG_LENGTH, &log_sz));
+		GL_CALL(glGetShaderiv(s.id, GL_INFO_LOG_LENGTH, &log_sz));
 
 		char* info_log = new char[log_sz * sizeof(char)];
-		GL_CALL(glGetShaderInfoLog(id, log_sz, nullptr, info_log));
+		GL_CALL(glGetShaderInfoLog(s.id, log_sz, nullptr, info_log));
 		
-		error("{}\n", info_log);
+		error("{}\n{}\n", s.file_path, info_log);
 		delete[] info_log;
-		GL_CALL(glDeleteShader(id));
-        fatal("program shutdown");
-	}
-	else
-	{
-		info("Shader compilation successful! [id:{}]\n", id);
+
+		// line numbers in the log are prefixed with these
+		if (s.source_files.size() > 1)
+		{
+			for (size_t i = 0; i < s.source_files.size(); ++i)
+				error("source {}: {}\n", i, s.source_files[i]);
+		}
+
+		return false;
 	}
+
+	info("Shader compilation successful! [id:{}]\n", s.id);
+	return true;
 }
 
 void ShaderProgram::attach_shader(unsigned int id) const
 {
-	GL_CALL(glAttachShader(m_program_id, id));
+	GL_CALL(glAttachShader(m_building_id, id));
 }
 
-void ShaderProgram::link()
+void ShaderProgram::submit_link()
 {
-	GL_CALL(glLinkProgram(m_program_id));
+	GL_CALL(glProgramParameteri(m_building_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+	GL_CALL(glLinkProgram(m_building_id));
+	m_status = ProgramStatus::Linking;
+}
 
+bool ShaderProgram::check_link() const
+{
 	int linked = 0;
-	GL_CALL(glGetProgramiv(m_program_id, GL_LINK_STATUS, (int*)&linked));
+	GL_CALL(glGetProgramiv(m_building_id, GL_LINK_STATUS, (int*)&linked));
 	if (!linked)
 	{
 		int log_sz = 0;
-		GL_CALL(glGetProgramiv(m_program_id, GL_INFO_LOG_LENGTH, &log_sz));
+		GL_CALL(glGetProgramiv(m_building_id, GL_INFO_LOG_LENGTH, &log_sz));
 
 		char* info_log = new char[log_sz * sizeof(char)];
-		GL_CALL(glGetProgramInfoLog(m_program_id, log_sz, nullptr, info_log));
+		GL_CALL(glGetProgramInfoLog(m_building_id, log_sz, nullptr, info_log));
 
-		fatal("{}\n", info_log);
+		error("{}\n", info_log);
 		delete[] info_log;
-		delete_shaders();
-		GL_CALL(glDeleteProgram(m_program_id));
+		return false;
 	}
+
+	return true;
 }
 
 void ShaderProgram::delete_shaders() 
 {
-	if (!m_shaders.empty())
+	// attached shaders are only flagged and go away with the program
+	for (Shader& s : m_shaders)
 	{
-		for (const auto& s : m_shaders)
+		if (s.id != 0)
 		{
 			GL_CALL(glDeleteShader(s.id));
 		}
 
-		m_shaders.clear();
-	}	
+		s.id = 0;
+	}
 }
 
-void ShaderProgram::recompile()
+void ShaderProgram::build()
 {
+    // a rebuild still in flight is dropped for the newer sources
+    discard_build();
+
+    std::vector<std::string> sources;
+    bool preprocessed = true;
+    m_dependencies.clear();
+
     for (Shader& shader : m_shaders)
     {
-        std::string src = load_shader(shader);
-        const char* shader_src = src.c_str();
+        PreprocessedShader stage;
+        preprocessed = preprocess_shader(shader.file_path, m_defines, stage) && preprocessed;
+        sources.push_back(std::move(stage.source));
+        shader.source_files = std::move(stage.files);
+
+        for (const std::string& file : shader.source_files)
+        {
+            if (!depends_on(file))
+                m_dependencies.push_back(file);
+        }
+    }
 
-        GL_CALL(glShaderSource(shader.id, 1, &shader_src, nullptr));
+    if (!preprocessed)
+    {
+        fail();
+        return;
+    }
 
-        compile_shader(shader.id);
+    m_cache_key = ProgramCache::make_key(m_shaders, sources);
+    GL_CALL(m_building_id = glCreateProgram());
+
+    if (ProgramCache::load(m_building_id, m_cache_key))
+    {
+        if (reflect_build())
+            swap_in();
+        else
+            fail();
+
+        return;
     }
 
-    link();
+    submit_compile(sources);
 }
 
-void ShaderProgram::get_active_uniforms() const
+void ShaderProgram::submit_compile(const std::vector<std::string>& sources)
 {
-	int num_uniforms;
-	glGetProgramiv(m_program_id, GL_ACTIVE_UNIFORMS, &num_uniforms);
-	char uniform_name[25];
-	int length;
-	int size;
-	unsigned int type;
+    for (size_t i = 0; i < m_shaders.size(); ++i)
+    {
+        Shader& shader = m_shaders[i];
+        create_shader(shader, sources[i]);
+        attach_shader(shader.id);
+
+        // nothing is asked about the shader here so the driver is free to compile it in the background
+        GL_CALL(glCompileShader(shader.id));
+    }
+
+    m_status = ProgramStatus::Compiling;
+}
+
+bool ShaderProgram::advance(bool block)
+{
+    if (m_status == ProgramStatus::Compiling)
+    {
+        for (const Shader& shader : m_shaders)
+        {
+            if (!block && !shader_complete(shader.id))
+                return false;
+        }
+
+        bool compiled = true;
+        for (const Shader& shader : m_shaders)
+            compiled = check_compile(shader) && compiled;
+
+        if (!compiled)
+        {
+            fail();
+            return true;
+        }
+
+        submit_link();
+    }
+
+    if (m_status == ProgramStatus::Linking)
+    {
+        if (!block && !program_complete(m_building_id))
+            return false;
+
+        if (!check_link() || !reflect_build())
+        {
+            fail();
+            return true;
+        }
+
+        ProgramCache::store(m_building_id, m_cache_key);
+        swap_in();
+    }
+
+    return true;
+}
+
+bool ShaderProgram::poll()
+{
+    return advance(false);
+}
+
+void ShaderProgram::wait()
+{
+    advance(true);
+}
+
+bool ShaderProgram::reflect_build()
+{
+    ShaderReflection reflection;
+    reflection.reflect(m_building_id);
+
+    if (!reflection.check_registered_layouts(m_shaders.front().file_path))
+        return false;
+
+    m_reflection = std::move(reflection);
+    return true;
+}
+
+void ShaderProgram::swap_in()
+{
+    // values the old program had are sent to the new one once its uniforms are known
+    defer_current_uniforms();
+
+    if (m_program_id != 0)
+    {
+        GLState::forget_program(m_program_id);
+        GL_CALL(glDeleteProgram(m_program_id));
+    }
+
+    m_program_id = m_building_id;
+    m_building_id = 0;
+    delete_shaders();
+    resolve_uniforms();
 
-	for (int i = 0; i < num_uniforms; ++i)
+    m_status = ProgramStatus::Ready;
+    apply_pending_uniforms();
+}
+
+void ShaderProgram::fail()
+{
+    discard_build();
+
+    // with nothing to fall back on there is no way to carry on
+    if (m_program_id == 0)
+    {
+        fatal("program shutdown");
+    }
+    else
+    {
+        warn("Keeping the previous version of the program\n");
+    }
+}
+
+void ShaderProgram::discard_build()
+{
+    if (m_building_id != 0)
+    {
+        delete_shaders();
+        GL_CALL(glDeleteProgram(m_building_id));
+        m_building_id = 0;
+    }
+
+    m_status = ProgramStatus::Ready;
+}
+
+void ShaderProgram::recompile()
+{
+    build();
+}
+
+bool ShaderProgram::depends_on(const std::string& file) const
+{
+    return std::find(m_dependencies.begin(), m_dependencies.end(), file) != m_dependencies.end();
+}
+
+void ShaderProgram::defer_current_uniforms()
+{
+	if (m_program_id == 0)
+		return;
+
+	for (uint32_t id = 0; id < (uint32_t)m_uniforms.size(); ++id)
 	{
-		glGetActiveUniform(m_program_id, i, sizeof(uniform_name), &length, &size, &type, uniform_name);
+		const UniformSlot& slot = m_uniforms[id];
+		if (!slot.has_value)
+			continue;
+
+		PendingUniform& pending = m_pending_uniforms.emplace_back();
+		pending.id = id;
+		pending.type = slot.type;
+		std::memcpy(pending.value, slot.value, sizeof(pending.value));
 	}
 }
 
-int ShaderProgram::get_uniform_location(const std::string& name)
+void ShaderProgram::apply_pending_uniforms()
 {
-	if (m_uniform_location_cache.find(name) != m_uniform_location_cache.end())
-		return m_uniform_location_cache[name];
+	for (const PendingUniform& pending : m_pending_uniforms)
+	{
+		switch (pending.type)
+		{
+		case UNIFORM_INT:
+			set_uniform_value(pending.id, *(const int*)pending.value);
+			break;
+		case UNIFORM_FLOAT:
+			set_uniform_value(pending.id, *(const float*)pending.value);
+			break;
+		case UNIFORM_VEC2:
+			set_uniform_value(pending.id, *(const glm::vec2*)pending.value);
+			break;
+		case UNIFORM_VEC3:
+			set_uniform_value(pending.id, *(const glm::vec3*)pending.value);
+			break;
+		case UNIFORM_VEC4:
+			set_uniform_value(pending.id, *(const glm::vec4*)pending.value);
+			break;
+		case UNIFORM_MAT4:
+			set_uniform_value(pending.id, *(const glm::mat4*)pending.value);
+			break;
+		default:
+			break;
+		}
+	}
 
-	GL_CALL(int location = glGetUniformLocation(m_program_id, name.c_str()));
+	m_pending_uniforms.clear();
+}
 
-	if (location == -1)
+// relinking puts every uniform back to its default so the old values are forgotten too
+void ShaderProgram::resolve_uniforms()
+{
+	m_uniforms.clear();
+	m_missing_uniforms.clear();
+
+	auto add_uniform = [this](const std::string& name, int location)
+	{
+		uint32_t id = get_uniform_id(name);
+		if (id >= m_uniforms.size())
+			m_uniforms.resize(id + 1);
+
+		m_uniforms[id].location = location;
+	};
+
+	// block members aren't in the list, they don't have locations
+	for (const ReflectedUniform& uniform : m_reflection.get_uniforms())
+	{
+		if (uniform.location == -1)
+			continue;
+
+		// arrays are reported by their first element, every element can be set on its own
+		if (uniform.name.ends_with("[0]"))
+		{
+			std::string base = uniform.name.substr(0, uniform.name.size() - 3);
+			add_uniform(base, uniform.location);
+
+			for (uint32_t element = 0; element < uniform.array_size; ++element)
+			{
+				std::string element_name = base + "[" + std::to_string(element) + "]";
+				GL_CALL(int location = glGetUniformLocation(m_program_id, element_name.c_str()));
+				add_uniform(element_name, location);
+			}
+		}
+		else
+		{
+			add_uniform(uniform.name, uniform.location);
+		}
+	}
+}
+
+template<typename T>
+int ShaderProgram::update_uniform(uint32_t id, const T& value)
+{
+	if (id >= m_uniforms.size() || m_uniforms[id].location == -1)
 	{
-		warn("{} uniform not found!\n", name);
+		if (m_missing_uniforms.insert(id).second)
+			warn("{} uniform not found!\n", get_uniform_name(id));
+
+		return -1;
+	}
+
+	UniformSlot& slot = m_uniforms[id];
+	if (slot.has_value && std::memcmp(slot.value, &value, sizeof(T)) == 0)
+	{
+		++m_num_uniform_skips;
+		return -1;
 	}
 
-	m_uniform_location_cache[name] = location;
+	std::memcpy(slot.value, &value, sizeof(T));
+	slot.has_value = true;
+	slot.type = uniform_type<T>();
+	++m_num_uniform_sets;
 
-	return location;
+	return slot.location;
+}
+
+template<typename T>
+bool ShaderProgram::defer_uniform(uint32_t id, const T& value)
+{
+	if (m_program_id != 0)
+		return false;
+
+	// only the latest value matters
+	auto it = std::find_if(m_pending_uniforms.begin(), m_pending_uniforms.end(), [id](const PendingUniform& p) { return p.id == id; });
+	PendingUniform& pending = (it != m_pending_uniforms.end()) ? *it : m_pending_uniforms.emplace_back();
+
+	pending.id = id;
+	pending.type = uniform_type<T>();
+	std::memcpy(pending.value, &value, sizeof(T));
+	return true;
+}
+
+template<typename T>
+void ShaderProgram::set_uniform_value(uint32_t id, const T& value)
+{
+	if (defer_uniform(id, value))
+		return;
+
+	int location = update_uniform(id, value);
+	if (location != -1)
+		send_uniform(m_program_id, location, uniform_type<T>(), &value);
+}
+
+void ShaderProgram::set_uniform(Uniform<int> uniform, int i)
+{
+	set_uniform_value(uniform.id, i);
+}
+
+void ShaderProgram::set_uniform(Uniform<float> uniform, float x)
+{
+	set_uniform_value(uniform.id, x);
+}
+
+void ShaderProgram::set_uniform(Uniform<glm::vec2> uniform, const glm::vec2& vec)
+{
+	set_uniform_value(uniform.id, vec);
+}
+
+void ShaderProgram::set_uniform(Uniform<glm::vec3> uniform, const glm::vec3& vec)
+{
+	set_uniform_value(uniform.id, vec);
+}
+
+void ShaderProgram::set_uniform(Uniform<glm::vec4> uniform, const glm::vec4& vec)
+{
+	set_uniform_value(uniform.id, vec);
+}
+
+void ShaderProgram::set_uniform(Uniform<glm::mat4> uniform, const glm::mat4& mat)
+{
+	set_uniform_value(uniform.id, mat);
 }
 
 void ShaderProgram::set_uniform_1i(const std::string& name, int i)
 {
-	bind();
-	GL_CALL(glUniform1i(get_uniform_location(name), i));
-	unbind();
+	set_uniform(Uniform<int>(name), i);
 }
 
 void ShaderProgram::set_uniform_1f(const std::string& name, float x)
 {
-	bind();
-	GL_CALL(glUniform1f(get_uniform_location(name), x));
-	unbind();
+	set_uniform(Uniform<float>(name), x);
 }
 
 void ShaderProgram::set_uniform_2f(const std::string& name, float x, float y)
 {
-	bind();
-	GL_CALL(glUniform2f(get_uniform_location(name), x, y));
-	unbind();
+	set_uniform(Uniform<glm::vec2>(name), { x, y });
 }
 
 void ShaderProgram::set_uniform_3f(const std::string& name, const glm::vec3& vec)
 {
-	bind();
-	GL_CALL(glUniform3f(get_uniform_location(name), vec.x, vec.y, vec.z));
-	unbind();
+	set_uniform(Uniform<glm::vec3>(name), vec);
 }
 
 void ShaderProgram::set_uniform_4f(const std::string& name, const glm::vec4& vec)
 {
-	bind();
-	GL_CALL(glUniform4f(get_uniform_location(name), vec.x, vec.y, vec.z, vec.w));
-	unbind();
-}
-
-void ShaderProgram::set_uniform_sampler(const std::string& name, const std::vector<int>& elements)
-{
-    bind();
-    GL_CALL(glUniform1iv(get_uniform_location(name), elements.size(), &elements[0]));
-    unbind();
+	set_uniform(Uniform<glm::vec4>(name), vec);
 }
 
-
 void ShaderProgram::set_uniform_mat4f(const std::string& name, const glm::mat4& mat)
 {
-	bind();
-	GL_CALL(glUniformMatrix4fv(get_uniform_location(name), 1, GL_FALSE, &mat[0][0]));
-	unbind();
+	set_uniform(Uniform<glm::mat4>(name), mat);
 }
 
 std::unordered_map<std::string, std::shared_ptr<ShaderProgram>> ShaderTable::m_shaders;
 std::vector<std::string> ShaderTable::m_material_shaders;
+size_t ShaderTable::m_num_pending = 0;
+FileWatcher ShaderTable::m_watcher;
+
+// when the oldest unfinished program was submitted
+static std::chrono::high_resolution_clock::time_point pending_since;
 
 void ShaderTable::add(const std::string& name, ShaderProgram&& sp, bool is_material)
 {
@@ -250,6 +696,10 @@ void ShaderTable::add(const std::string& name, ShaderProgram&& sp, bool is_mater
     {
         m_shaders[name] = std::make_shared<ShaderProgram>(std::move(sp));
         if (is_material) m_material_shaders.push_back(name);
+
+        watch(*m_shaders[name]);
+        if (m_shaders[name]->get_status() != ProgramStatus::Ready)
+            add_pending();
     }
 }
 
@@ -260,10 +710,55 @@ std::shared_ptr<ShaderProgram> ShaderTable::get(const std::string& name)
 		return m_shaders[name];
 	}
 
+	// permutation keys come back from saved scenes before anything asked for them
+	size_t open = name.find('[');
+	if (open != std::string::npos && name.back() == ']')
+	{
+		std::vector<std::string> defines;
+		std::istringstream keys(name.substr(open + 1, name.size() - open - 2));
+		for (std::string key; std::getline(keys, key, ',');)
+			defines.push_back(key);
+
+		return get(name.substr(0, open), std::move(defines));
+	}
+
 	fatal("Shader {} does not exist in library!\n", name);
 	return nullptr;
 }
 
+std::shared_ptr<ShaderProgram> ShaderTable::get(const std::string& name, std::vector<std::string> defines)
+{
+	std::string key = make_key(name, defines);
+	if (exists(key))
+		return m_shaders[key];
+
+	std::shared_ptr<ShaderProgram> base = get(name);
+	if (!base)
+		return nullptr;
+
+	std::sort(defines.begin(), defines.end());
+	defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+	info("Building permutation {}\n", key);
+	add(key, ShaderProgram(base->get_shaders(), std::move(defines)));
+	return m_shaders[key];
+}
+
+std::string ShaderTable::make_key(const std::string& name, std::vector<std::string> defines)
+{
+	if (defines.empty())
+		return name;
+
+	std::sort(defines.begin(), defines.end());
+	defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+	std::string key = name + "[";
+	for (size_t i = 0; i < defines.size(); ++i)
+		key += (i == 0 ? "" : ",") + defines[i];
+
+	return key + "]";
+}
+
 bool ShaderTable::exists(const std::string& name)
 {
 	return (m_shaders.find(name) != m_shaders.end());
@@ -282,16 +777,73 @@ std::string ShaderTable::find(const std::shared_ptr<ShaderProgram>& s)
 	return "";
 }
 
-void ShaderTable::recompile()
+void ShaderTable::update()
+{
+    // only the programs built from a file that was written are rebuilt
+    for (const std::string& file : m_watcher.poll())
+    {
+        for (const auto& [name, shader_ptr] : m_shaders)
+        {
+            if (!shader_ptr->depends_on(file))
+                continue;
+
+            info("{} changed, rebuilding {}\n", file, name);
+            shader_ptr->recompile();
+            watch(*shader_ptr);
+
+            if (shader_ptr->get_status() != ProgramStatus::Ready)
+                add_pending();
+        }
+    }
+
+    if (m_num_pending == 0)
+        return;
+
+    size_t pending = 0;
+    for (const auto& [name, shader_ptr] : m_shaders)
+    {
+        if (!shader_ptr->poll())
+            ++pending;
+    }
+
+    if (pending == 0)
+    {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - pending_since;
+        info("Shader programs finished {} ms after they were submitted\n", elapsed.count());
+    }
+
+    m_num_pending = pending;
+}
+
+void ShaderTable::wait_all()
 {
     for (const auto& [name, shader_ptr] : m_shaders)
     {
-        shader_ptr->recompile();
+        shader_ptr->wait();
     }
+
+    m_num_pending = 0;
 }
 
 void ShaderTable::release()
 {
 	m_shaders.clear();
     m_material_shaders.clear();
+    m_num_pending = 0;
+    m_watcher.clear();
+}
+
+void ShaderTable::add_pending()
+{
+    if (m_num_pending == 0)
+        pending_since = std::chrono::high_resolution_clock::now();
+
+    // an upper bound until the next update counts them again
+    ++m_num_pending;
+}
+
+void ShaderTable::watch(const ShaderProgram& program)
+{
+    for (const std::string& file : program.get_dependencies())
+        m_watcher.watch(file);
 }
@@ -2,9 +2,13 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/matrix.hpp>
+#include "FileWatcher.h"
+#include "ShaderReflection.h"
 
 
 enum class ShaderType
@@ -23,82 +27,183 @@ struct Shader
 	unsigned int id = 0;
 	std::string file_path;
 	ShaderType type;
+	// every file the last build read, in the order #line numbers them
+	std::vector<std::string> source_files;
 };
 
 template<typename T>
 concept is_shader = std::convertible_to<T, Shader>;
 
+// every uniform name gets an id the first time it is seen, programs keep their locations under those ids
+[[nodiscard]] uint32_t get_uniform_id(const std::string& name);
+[[nodiscard]] const std::string& get_uniform_name(uint32_t id);
+
+// resolved once so setting it skips the name lookup, works with any program that has the uniform
+template<typename T>
+struct Uniform
+{
+	explicit Uniform(const std::string& name) : id(get_uniform_id(name)) {}
+
+	uint32_t id;
+};
+
+// where a program's build is, compiling and linking happen without waiting on the driver
+enum class ProgramStatus
+{
+	Compiling,
+	Linking,
+	Ready
+};
+
 class ShaderProgram
 {
 public:
 	template<is_shader ... Shaders>
 	explicit ShaderProgram(const Shaders& ... s)
 	{
-		create_program();
-
 		m_shaders = { s ... };
 
-		for (Shader& shader : m_shaders)
-		{
-			std::string src = load_shader(shader);
-
-			create_shader(shader, src);
-
-			compile_shader(shader.id);
-
-			attach_shader(shader.id);
-		}
-
-		link();
-		get_active_uniforms();
+		build();
 	}
 
+	// a permutation with every feature key defined in each stage
+	ShaderProgram(std::vector<Shader> shaders, std::vector<std::string> defines);
+
 	ShaderProgram(ShaderProgram&& sp) noexcept;
 	~ShaderProgram();
 
+	// set straight on the program without binding it, values it already has are skipped
+	void set_uniform(Uniform<int> uniform, int i);
+	void set_uniform(Uniform<float> uniform, float x);
+	void set_uniform(Uniform<glm::vec2> uniform, const glm::vec2& vec);
+	void set_uniform(Uniform<glm::vec3> uniform, const glm::vec3& vec);
+	void set_uniform(Uniform<glm::vec4> uniform, const glm::vec4& vec);
+	void set_uniform(Uniform<glm::mat4> uniform, const glm::mat4& mat);
+
 	void set_uniform_1i(const std::string& name, int i);
 	void set_uniform_1f(const std::string& name, float x);
 	void set_uniform_2f(const std::string& name, float x, float y);
 	void set_uniform_3f(const std::string& name, const glm::vec3& vec);
 	void set_uniform_4f(const std::string& name, const glm::vec4& vec);
-    void set_uniform_sampler(const std::string& name, const std::vector<int>& elements);
 	void set_uniform_mat4f(const std::string& name, const glm::mat4& mat);
 
-	[[nodiscard]] int get_uniform_location(const std::string& name);
-
 	void bind() const;
 	void unbind() const;
+	[[nodiscard]] unsigned int get_id() const { return m_program_id; }
 
+	[[nodiscard]] ProgramStatus get_status() const { return m_status; }
+	// there is a linked program to draw with, rebuilds keep the old one until the new one links
+	[[nodiscard]] bool is_ready() const { return m_program_id != 0; }
+	// moves a build along as far as the driver allows without blocking, true once nothing is in flight
+	bool poll();
+	// blocks until nothing is in flight
+	void wait();
+
+	// builds the program again from its files, a build that fails leaves the current program in place
     void recompile();
+	[[nodiscard]] const std::vector<Shader>& get_shaders() const { return m_shaders; }
+	// what the current program declares, taken when it was linked
+	[[nodiscard]] const ShaderReflection& get_reflection() const { return m_reflection; }
+	[[nodiscard]] const std::vector<std::string>& get_defines() const { return m_defines; }
+	// normalised paths of every file the program was built from, includes too
+	[[nodiscard]] const std::vector<std::string>& get_dependencies() const { return m_dependencies; }
+	[[nodiscard]] bool depends_on(const std::string& file) const;
+
+	[[nodiscard]] static size_t get_num_uniform_sets() { return m_num_uniform_sets; }
+	[[nodiscard]] static size_t get_num_uniform_skips() { return m_num_uniform_skips; }
 
 private:
-	void create_program();
-	std::string load_shader(const Shader& s);
+	// location and last value of a uniform, indexed by uniform id
+	struct UniformSlot
+	{
+		int location = -1;
+		bool has_value = false;
+		uint8_t type = 0;
+		alignas(16) unsigned char value[sizeof(glm::mat4)];
+	};
+
+	// a value set before the program was linked, sent once its uniforms are resolved
+	struct PendingUniform
+	{
+		uint32_t id;
+		uint8_t type;
+		alignas(16) unsigned char value[sizeof(glm::mat4)];
+	};
+
+	// builds into a new program, taken from the program cache when it can and submitted from source otherwise
+	void build();
+	void submit_compile(const std::vector<std::string>& sources);
 	void create_shader(Shader& s, const std::string& src) const;
-	void compile_shader(unsigned int id) const;
+	[[nodiscard]] bool check_compile(const Shader& s) const;
 	void attach_shader(unsigned int id) const;
-	void link();
+	void submit_link();
+	[[nodiscard]] bool check_link() const;
+	bool advance(bool block);
+	// reflects the new program and checks it against the layouts the C++ side writes
+	[[nodiscard]] bool reflect_build();
+	// the new program replaces the current one
+	void swap_in();
+	void fail();
+	void discard_build();
 	void delete_shaders(); 
-	void get_active_uniforms() const;
+	void resolve_uniforms();
+
+	// the location to set or -1 if the uniform isn't there or already has this value
+	template<typename T>
+	int update_uniform(uint32_t id, const T& value);
+	// keeps the value for later if the program isn't linked yet, true if it was kept
+	template<typename T>
+	bool defer_uniform(uint32_t id, const T& value);
+	template<typename T>
+	void set_uniform_value(uint32_t id, const T& value);
+	// keeps the values the program had so relinking doesn't lose them
+	void defer_current_uniforms();
+	void apply_pending_uniforms();
 
 	unsigned int m_program_id = 0;
+	// the program being built, 0 when nothing is in flight
+	unsigned int m_building_id = 0;
+	ProgramStatus m_status = ProgramStatus::Ready;
+	uint64_t m_cache_key = 0;
 	std::vector<Shader> m_shaders;
-	std::unordered_map<std::string, int> m_uniform_location_cache;
+	std::vector<std::string> m_defines;
+	std::vector<std::string> m_dependencies;
+	ShaderReflection m_reflection;
+	std::vector<UniformSlot> m_uniforms;
+	std::vector<PendingUniform> m_pending_uniforms;
+	std::unordered_set<uint32_t> m_missing_uniforms;
+
+	static size_t m_num_uniform_sets;
+	static size_t m_num_uniform_skips;
 };
 
 class ShaderTable
 {
 public:
 	static void add(const std::string& name, ShaderProgram&& sp, bool is_material = false);
+	// keys made by make_key are built on first use like the overload below
 	static std::shared_ptr<ShaderProgram> get(const std::string& name);
+	// the program with the feature keys defined, built from its sources the first time and kept under its key
+	static std::shared_ptr<ShaderProgram> get(const std::string& name, std::vector<std::string> defines);
+	// "name[KEY_A,KEY_B]" with the keys sorted, just the name when there are none
+	[[nodiscard]] static std::string make_key(const std::string& name, std::vector<std::string> defines);
 	static size_t get_num() { return m_shaders.size(); }
     static std::vector<std::string> get_material_shaders() { return m_material_shaders; }
 	static bool exists(const std::string& name);
 	static std::string find(const std::shared_ptr<ShaderProgram>& s);
-    static void recompile();
+	// rebuilds programs whose files changed and polls every unfinished one, called once a frame
+	static void update();
+	// blocks until every program is ready
+	static void wait_all();
+	[[nodiscard]] static size_t get_num_pending() { return m_num_pending; }
 	static void release();
 
 private:
+	static void add_pending();
+	static void watch(const ShaderProgram& program);
+
 	static std::unordered_map<std::string, std::shared_ptr<ShaderProgram>> m_shaders;
     static std::vector<std::string> m_material_shaders;
+    static size_t m_num_pending;
+	static FileWatcher m_watcher;
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "ShaderPreprocessor.h"
+#include "FileSystem.h"
+#include "FileWatcher.h"
+#include "Log.h"
+
+// the path inside #include "..." or an empty string if the line isn't an include
+static std::string parse_include(const std::string& line)
+{
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        return {};
+
+    size_t open = line.find('"', start + 8);
+    size_t close = (open == std::string::npos) ? std::string::npos : line.find('"', open + 1);
+    if (close == std::string::npos)
+        return {};
+
+    return line.substr(open + 1, close - open - 1);
+}
+
+static bool is_version(const std::string& line)
+{
+    size_t start = line.find_first_not_of(" \t");
+    return start != std::string::npos && line.compare(start, 8, "#version") == 0;
+}
+
+static bool expand_file(const std::string& file_path, const std::vector<std::string>& defines, PreprocessedShader& out)
+{
+    // listed before it is read so a missing file is still watched
+    auto index = (uint32_t)out.files.size();
+    out.files.push_back(FileWatcher::normalise(file_path));
+
+    std::string text;
+    if (!FileSystem::read(file_path, text))
+    {
+        error("Could not read shader {}\n", file_path);
+        return false;
+    }
+
+    std::istringstream lines(text);
+    std::string line;
+    uint32_t line_number = 0;
+
+    while (std::getline(lines, line))
+    {
+        ++line_number;
+
+        if (is_version(line))
+        {
+            if (index != 0)
+            {
+                error("{}:{} included files can't have a #version\n", file_path, line_number);
+                return false;
+            }
+
+            out.source += line + "\n";
+            for (const std::string& define : defines)
+                out.source += "#define " + define + "\n";
+
+            out.source += "#line " + std::to_string(line_number + 1) + " " + std::to_string(index) + "\n";
+            continue;
+        }
+
+        std::string include = parse_include(line);
+        if (include.empty())
+        {
+            out.source += line + "\n";
+            continue;
+        }
+
+        std::string include_path = (std::filesystem::path(file_path).parent_path() / include).lexically_normal().generic_string();
+
+        // included once per stage so shared blocks can include what they need without guards
+        if (std::find(out.files.begin(), out.files.end(), FileWatcher::normalise(include_path)) == out.files.end())
+        {
+            out.source += "#line 1 " + std::to_string(out.files.size()) + "\n";
+            if (!expand_file(include_path, defines, out))
+                return false;
+        }
+
+        out.source += "#line " + std::to_string(line_number + 1) + " " + std::to_string(index) + "\n";
+    }
+
+    return true;
+}
+
+bool preprocess_shader(const std::string& file_path, const std::vector<std::string>& defines, PreprocessedShader& out)
+{
+    out.source.clear();
+    out.files.clear();
+
+    return expand_file(file_path, defines, out);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// expands #include "file" (relative to the including file, each file only once) and puts a #define for every
+// feature key after #version, so permutations are chosen by the glsl compiler instead of branching at runtime
+// #line directives keep errors pointing at the right file, the source string number is the index into files
+struct PreprocessedShader
+{
+    std::string source;
+    std::vector<std::string> files;
+};
+
+bool preprocess_shader(const std::string& file_path, const std::vector<std::string>& defines, PreprocessedShader& out);
@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "ShaderReflection.h"
+#include "GLError.h"
+#include "Log.h"
+
+#include <glad/glad.h>
+
+std::vector<BlockLayout> ShaderReflection::m_layouts;
+
+static std::string get_resource_name(unsigned int program, GLenum interface, unsigned int index)
+{
+    const GLenum property = GL_NAME_LENGTH;
+    int length = 0;
+    GL_CALL(glGetProgramResourceiv(program, interface, index, 1, &property, 1, nullptr, &length));
+
+    // the length counts the terminator
+    std::string name(std::max(length, 1), '\0');
+    GL_CALL(glGetProgramResourceName(program, interface, index, (int)name.size(), nullptr, name.data()));
+    name.pop_back();
+
+    return name;
+}
+
+const ReflectedMember* ReflectedBlock::find(const std::string& member) const
+{
+    auto it = std::find_if(members.begin(), members.end(), [&](const ReflectedMember& m) { return m.name == member; });
+    return (it != members.end()) ? &*it : nullptr;
+}
+
+void ShaderReflection::reflect(unsigned int program)
+{
+    m_uniforms.clear();
+    m_blocks.clear();
+
+    int num_uniforms = 0;
+    GL_CALL(glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &num_uniforms));
+
+    for (int i = 0; i < num_uniforms; ++i)
+    {
+        const GLenum properties[] = { GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE };
+        int values[4] = {};
+        GL_CALL(glGetProgramResourceiv(program, GL_UNIFORM, i, 4, properties, 4, nullptr, values));
+
+        // block members are listed with their block
+        if (values[0] != -1)
+            continue;
+
+        m_uniforms.push_back({ get_resource_name(program, GL_UNIFORM, i), values[1], (uint32_t)values[2], (uint32_t)values[3] });
+    }
+
+    reflect_blocks(program, GL_UNIFORM_BLOCK, GL_UNIFORM);
+    reflect_blocks(program, GL_SHADER_STORAGE_BLOCK, GL_BUFFER_VARIABLE);
+}
+
+void ShaderReflection::reflect_blocks(unsigned int program, unsigned int block_interface, unsigned int member_interface)
+{
+    bool storage = (block_interface == GL_SHADER_STORAGE_BLOCK);
+
+    int num_blocks = 0;
+    GL_CALL(glGetProgramInterfaceiv(program, block_interface, GL_ACTIVE_RESOURCES, &num_blocks));
+
+    for (int b = 0; b < num_blocks; ++b)
+    {
+        const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+        int values[3] = {};
+        GL_CALL(glGetProgramResourceiv(program, block_interface, b, 3, properties, 3, nullptr, values));
+
+        ReflectedBlock& block = m_blocks.emplace_back();
+        block.name = get_resource_name(program, block_interface, b);
+        block.binding = (uint32_t)values[0];
+        block.size = (uint32_t)values[1];
+        block.storage = storage;
+
+        std::vector<int> indices(values[2]);
+        const GLenum active_variables = GL_ACTIVE_VARIABLES;
+        GL_CALL(glGetProgramResourceiv(program, block_interface, b, 1, &active_variables, (int)indices.size(), nullptr, indices.data()));
+
+        for (int index : indices)
+        {
+            // only buffer variables have a top level stride
+            const GLenum member_properties[] = { GL_OFFSET, GL_TYPE, GL_ARRAY_SIZE, GL_ARRAY_STRIDE, GL_TOP_LEVEL_ARRAY_STRIDE };
+            int num_properties = storage ? 5 : 4;
+            int member[5] = {};
+            GL_CALL(glGetProgramResourceiv(program, member_interface, index, num_properties, member_properties, num_properties, nullptr, member));
+
+            block.members.push_back({ get_resource_name(program, member_interface, index),
+                                      (uint32_t)member[0], (uint32_t)member[1], (uint32_t)member[2], (uint32_t)member[3], (uint32_t)member[4] });
+        }
+    }
+}
+
+const ReflectedBlock* ShaderReflection::find_block(const std::string& name) const
+{
+    auto it = std::find_if(m_blocks.begin(), m_blocks.end(), [&](const ReflectedBlock& b) { return b.name == name; });
+    return (it != m_blocks.end()) ? &*it : nullptr;
+}
+
+bool ShaderReflection::check(const BlockLayout& layout, const std::string& program_name) const
+{
+    const ReflectedBlock* block = find_block(layout.block);
+    if (!block)
+        return true;
+
+    bool matches = true;
+
+    if (block->storage != layout.storage || block->binding != layout.binding)
+    {
+        error("{}: {} is a {} block at binding {} but the C++ side binds a {} block at {}\n", program_name, layout.block,
+              block->storage ? "storage" : "uniform", block->binding, layout.storage ? "storage" : "uniform", layout.binding);
+        matches = false;
+    }
+
+    for (const BlockLayoutMember& expected : layout.members)
+    {
+        const ReflectedMember* member = block->find(expected.name);
+        if (!member)
+        {
+            error("{}: {} has no member {}\n", program_name, layout.block, expected.name);
+            matches = false;
+            continue;
+        }
+
+        if (member->offset != expected.offset || member->type != expected.type)
+        {
+            error("{}: {} {} is at offset {} with type {:#x} but the C++ side writes it at {} with type {:#x}\n", program_name,
+                  layout.block, expected.name, member->offset, member->type, expected.offset, expected.type);
+            matches = false;
+        }
+
+        if (layout.array_stride != 0 && member->top_level_array_stride != layout.array_stride)
+        {
+            error("{}: {} {} has a stride of {} but the C++ side uses {}\n", program_name, layout.block, expected.name,
+                  member->top_level_array_stride, layout.array_stride);
+            matches = false;
+        }
+    }
+
+    return matches;
+}
+
+bool ShaderReflection::check_registered_layouts(const std::string& program_name) const
+{
+    bool matches = true;
+    for (const BlockLayout& layout : m_layouts)
+        matches = check(layout, program_name) && matches;
+
+    return matches;
+}
+
+void ShaderReflection::register_layout(BlockLayout layout)
+{
+    auto it = std::find_if(m_layouts.begin(), m_layouts.end(), [&](const BlockLayout& l) { return l.block == layout.block; });
+    if (it != m_layouts.end())
+        *it = std::move(layout);
+    else
+        m_layouts.push_back(std::move(layout));
+}
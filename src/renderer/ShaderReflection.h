@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// what a linked program says about its interface, types are the GL enums (GL_FLOAT_VEC4, ...)
+struct ReflectedUniform
+{
+    std::string name; // arrays are reported as name[0]
+    int location;
+    uint32_t type;
+    uint32_t array_size;
+};
+
+struct ReflectedMember
+{
+    std::string name; // block.member, array[0].member, ...
+    uint32_t offset;
+    uint32_t type;
+    uint32_t array_size;
+    uint32_t array_stride;
+    uint32_t top_level_array_stride; // storage blocks only
+};
+
+struct ReflectedBlock
+{
+    std::string name;
+    uint32_t binding;
+    uint32_t size;
+    bool storage;
+    std::vector<ReflectedMember> members;
+
+    [[nodiscard]] const ReflectedMember* find(const std::string& member) const;
+};
+
+// the layout the C++ side writes into a block, every program declaring a block by this name is checked against it
+struct BlockLayoutMember
+{
+    std::string name;
+    uint32_t offset;
+    uint32_t type;
+};
+
+struct BlockLayout
+{
+    std::string block;
+    uint32_t binding;
+    bool storage;
+    uint32_t array_stride; // the element size for blocks holding a runtime sized array, 0 otherwise
+    std::vector<BlockLayoutMember> members;
+};
+
+class ShaderReflection
+{
+public:
+    void reflect(unsigned int program);
+
+    [[nodiscard]] const std::vector<ReflectedUniform>& get_uniforms() const { return m_uniforms; }
+    [[nodiscard]] const std::vector<ReflectedBlock>& get_blocks() const { return m_blocks; }
+    [[nodiscard]] const ReflectedBlock* find_block(const std::string& name) const;
+
+    // logs every difference, true if there were none or the program doesn't have the block
+    bool check(const BlockLayout& layout, const std::string& program_name) const;
+    bool check_registered_layouts(const std::string& program_name) const;
+
+    // a layout registered again under the same block name replaces the old one
+    static void register_layout(BlockLayout layout);
+
+private:
+    void reflect_blocks(unsigned int program, unsigned int block_interface, unsigned int member_interface);
+
+    std::vector<ReflectedUniform> m_uniforms;
+    std::vector<ReflectedBlock> m_blocks;
+
+    static std::vector<BlockLayout> m_layouts;
+};
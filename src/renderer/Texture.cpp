@@ -1,10 +1,30 @@
 #include "pch.h"
 #include "Texture.h"
 #include "GLError.h"
+#include "GLState.h"
 #include "Log.h"
+#include "AssetCache.h"
+#include "AsyncLoader.h"
+#include "ResidencyManager.h"
+#include "TextureStreamer.h"
+#include "Hash.h"
+#include "TextureData.h"
+#include "FileSystem.h"
+#include "ThreadPool.h"
 
 #include <glad/glad.h>
-#include <stb_image.h>
+#include <unordered_set>
+
+// glad is only generated with the core profile, S3TC comes from EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
 
 const char* image_extension(ImageFormat fmt)
 {
@@ -20,58 +40,81 @@ const char* image_extension(ImageFormat fmt)
     return "";
 }
 
+static unsigned int gl_internal_format(PixelFormat format, bool gamma_correct)
+{
+    switch (format)
+    {
+        case PixelFormat::RGBA8: return gamma_correct ? GL_SRGB8_ALPHA8 : GL_RGBA8; // sized so mips can be copied into immutable storage
+        case PixelFormat::BC1:   return gamma_correct ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case PixelFormat::BC3:   return gamma_correct ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case PixelFormat::BC4:   return GL_COMPRESSED_RED_RGTC1; // no srgb versions, only used for data textures
+        case PixelFormat::BC5:   return GL_COMPRESSED_RG_RGTC2;
+        case PixelFormat::BC7:   return gamma_correct ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+
+    return GL_RGBA;
+}
+
 uint64_t TextureBase::get_handle() const
 {
     return glGetTextureHandleARB(m_id);
 }
 
+// making a handle resident twice, or non-resident twice, is an error so the state is tracked here
 void TextureBase::make_resident() const
 {
+    if(m_resident)
+        return;
+
     glMakeTextureHandleResidentARB(get_handle());
+    m_resident = true;
 }
 
-Texture2D::Texture2D(const std::string& file_name, bool gamma_correct)
+void TextureBase::make_non_resident() const
 {
-	stbi_set_flip_vertically_on_load(1);
-	m_data = stbi_load(file_name.c_str(), &m_width, &m_height, &m_colour_channels, 0);
+    if(!m_resident)
+        return;
 
-	GL_CALL(glGenTextures(1, &m_id));
-	GL_CALL(glBindTexture(GL_TEXTURE_2D, m_id));
-
-	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
-	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
-	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
-	GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
-
-	unsigned int pixel_format;
-
-	switch (m_colour_channels)
-	{
-	case 4:
-		pixel_format = GL_RGBA;
-		break;
-	case 3:
-		pixel_format = GL_RGB;
-		break;
-	default:
-		pixel_format = GL_RGBA;
-		break;
-	}
+    glMakeTextureHandleNonResidentARB(get_handle());
+    m_resident = false;
+}
 
-    if(gamma_correct)
-    {
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB_ALPHA, m_width, m_height, 0, pixel_format, GL_UNSIGNED_BYTE, m_data));
-    }
-	else
+Texture2D::Texture2D(const std::string& file_name, bool gamma_correct)
+{
+    TextureData texture;
+    if(!load_texture_data(file_name, texture, gamma_correct, true))
     {
-        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height, 0, pixel_format, GL_UNSIGNED_BYTE, m_data));
+        warn("Could not load image: {}\n", file_name);
+        texture = texture_data_from_image({ 1, 1, 4, { 255, 255, 255, 255 } }, false);
     }
 
-	GL_CALL(glGenerateMipmap(GL_TEXTURE_2D));
+    create_from_data(texture, gamma_correct);
+}
 
-	stbi_image_free(m_data);
+Texture2D::Texture2D(const TextureData& texture, bool gamma_correct)
+{
+    create_from_data(texture, gamma_correct);
+}
 
-    make_resident();
+Texture2D::Texture2D(std::shared_ptr<const TextureData> source, uint32_t start_size, bool gamma_correct)
+    : m_source(std::move(source))
+{
+    m_last_used = ResidencyManager::get_frame();
+    m_id = 0;
+    m_colour_channels = 4;
+    m_data = nullptr;
+    m_format = m_source->format;
+    m_internal_format = gl_internal_format(m_source->format, gamma_correct);
+
+    uint32_t level = 0;
+    while(level + 1 < m_source->num_levels && std::max(m_source->level(0, level).width, m_source->level(0, level).height) > start_size)
+        ++level;
+
+    // nothing has data yet, the start levels are uploaded coarsest first like any other streamed level
+    m_storage_level = m_source->num_levels;
+    m_first_level = m_source->num_levels;
+    stream_to(level);
+    while(stream_next_level());
 }
 
 Texture2D::Texture2D(unsigned component_type, unsigned width, unsigned int height, int samples)
@@ -102,38 +145,227 @@ Texture2D::Texture2D(Texture2D&& t) noexcept
 
 Texture2D::~Texture2D()
 {
+	GLState::forget_texture(m_id);
 	GL_CALL(glDeleteTextures(1, &m_id));
 }
 
 void Texture2D::bind(unsigned slot /* = 0 */) const
 {
-	GL_CALL(glActiveTexture(GL_TEXTURE0 + slot));
+    m_last_used = ResidencyManager::get_frame();
+
+    GLState::bind_texture(slot, m_multisample ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D, m_id);
+}
+
+void Texture2D::unbind() const
+{
+    GLState::bind_texture(m_multisample ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D, 0);
+}
+
+void Texture2D::operator=(Texture2D&& t) noexcept
+{
+	move_members(std::move(t));
+}
+
+void Texture2D::upload(const TextureData& texture, bool gamma_correct)
+{
+    make_non_resident();
+    GLState::forget_texture(m_id);
+    GL_CALL(glDeleteTextures(1, &m_id));
+    create_from_data(texture, gamma_correct);
+}
 
+bool Texture2D::drop_mips(uint32_t max_size)
+{
     if(m_multisample)
+        return false;
+
+    uint32_t dropped = 0;
+    while(dropped + 1 < m_num_levels && (uint32_t)std::max(m_width >> dropped, m_height >> dropped) > max_size)
+        ++dropped;
+
+    if(dropped == 0)
+        return false;
+
+    create_storage(m_storage_level + dropped, m_num_levels - dropped, std::max(m_width >> dropped, 1), std::max(m_height >> dropped, 1));
+    return true;
+}
+
+void Texture2D::request_size(float screen_size) const
+{
+    if(!m_source)
+        return;
+
+    // one texel per pixel is enough, anything finer would only be minified away
+    float full_size = (float)std::max(m_source->width, m_source->height);
+    uint32_t level = 0;
+    if(screen_size < full_size)
+        level = (uint32_t)std::log2(full_size / std::max(screen_size, 1.f));
+
+    m_wanted_level = std::min({ m_wanted_level, level, m_source->num_levels - 1 });
+}
+
+uint32_t Texture2D::take_wanted_level() const
+{
+    uint32_t level = m_wanted_level;
+    m_wanted_level = UINT32_MAX;
+    return level;
+}
+
+void Texture2D::stream_to(uint32_t level)
+{
+    if(!m_source || level >= m_storage_level)
+        return;
+
+    const MipLevel& top = m_source->level(0, level);
+    create_storage(level, m_source->num_levels - level, (int)top.width, (int)top.height);
+
+    // the levels are read straight out of the mapping, faulting them in on a worker keeps the page-ins out of the frame
+    uint64_t begin = UINT64_MAX, end = 0;
+    for (uint32_t i = level; i < m_first_level; ++i)
     {
-        GL_CALL(glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, m_id));
+        begin = std::min(begin, m_source->level(0, i).offset);
+        end = std::max(end, m_source->level(0, i).offset + m_source->level(0, i).size);
     }
-    else
+
+    if (begin < end)
     {
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, m_id));
+        std::shared_ptr<const TextureData> source = m_source;
+        ThreadPool::get().submit([source, begin, end]() { FileSystem::prefetch(source->data() + begin, end - begin); });
     }
 }
 
-void Texture2D::unbind() const
+bool Texture2D::stream_next_level()
 {
-    if(m_multisample)
+    if(!m_source || m_first_level <= m_storage_level)
+        return false;
+
+    --m_first_level;
+    upload_level(m_first_level);
+    set_level_range();
+    return true;
+}
+
+// moves the texture into new immutable storage, every level that has data and still fits is copied over on the GPU
+void Texture2D::create_storage(uint32_t storage_level, uint32_t num_levels, int width, int height)
+{
+    unsigned int id;
+    GL_CALL(glGenTextures(1, &id));
+    GLState::bind_texture(GL_TEXTURE_2D, id);
+    GL_CALL(glTexStorage2D(GL_TEXTURE_2D, (int)num_levels, m_internal_format, width, height));
+
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, num_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+    m_bytes = 0;
+    for(uint32_t i = 0; i < num_levels; ++i)
+    {
+        int level_width = std::max(width >> i, 1);
+        int level_height = std::max(height >> i, 1);
+        uint32_t level = storage_level + i;
+
+        if(m_id != 0 && level >= m_first_level && level >= m_storage_level && level < m_storage_level + m_num_levels)
+        {
+            GL_CALL(glCopyImageSubData(m_id, GL_TEXTURE_2D, (int)(level - m_storage_level), 0, 0, 0, id, GL_TEXTURE_2D, (int)i, 0, 0, 0, level_width, level_height, 1));
+        }
+
+        m_bytes += level_size(m_format, level_width, level_height);
+    }
+
+    if(m_id != 0)
+    {
+        make_non_resident();
+        GLState::forget_texture(m_id);
+        GL_CALL(glDeleteTextures(1, &m_id));
+    }
+
+    m_id = id;
+    m_width = width;
+    m_height = height;
+    m_num_levels = num_levels;
+    m_storage_level = storage_level;
+    m_first_level = std::max(m_first_level, storage_level);
+
+    set_level_range();
+}
+
+// levels above the base level have no data yet so sampling is clamped to the ones that do
+void Texture2D::set_level_range() const
+{
+    // the sampling state of a resident texture can't be changed
+    make_non_resident();
+
+    int base_level = (int)std::min(m_first_level - m_storage_level, m_num_levels - 1);
+    GLState::bind_texture(GL_TEXTURE_2D, m_id);
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base_level));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)m_num_levels - 1));
+}
+
+void Texture2D::upload_level(uint32_t level) const
+{
+    const MipLevel& source_level = m_source->level(0, level);
+    int storage_level = (int)(level - m_storage_level);
+
+    GLState::bind_texture(GL_TEXTURE_2D, m_id);
+    if(is_block_compressed(m_format))
     {
-        GL_CALL(glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0));
+        GL_CALL(glCompressedTexSubImage2D(GL_TEXTURE_2D, storage_level, 0, 0, (int)source_level.width, (int)source_level.height, m_internal_format, (int)source_level.size, m_source->level_data(0, level)));
     }
     else
     {
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+        GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, storage_level, 0, 0, (int)source_level.width, (int)source_level.height, GL_RGBA, GL_UNSIGNED_BYTE, m_source->level_data(0, level)));
     }
 }
 
-void Texture2D::operator=(Texture2D&& t) noexcept
+// data is expected to already be flipped and to carry every mip it should be sampled with
+void Texture2D::create_from_data(const TextureData& texture, bool gamma_correct)
 {
-	move_members(std::move(t));
+    // counts as used so nothing gets evicted before its first draw
+    m_last_used = ResidencyManager::get_frame();
+    m_width = (int)texture.width;
+    m_height = (int)texture.height;
+    m_colour_channels = 4;
+    m_data = nullptr;
+
+    GL_CALL(glGenTextures(1, &m_id));
+    GLState::bind_texture(GL_TEXTURE_2D, m_id);
+
+    // the precomputed mips are only ever sampled with a mipmapped filter
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.num_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
+
+    unsigned int internal_format = gl_internal_format(texture.format, gamma_correct);
+    bool compressed = is_block_compressed(texture.format);
+
+    m_format = texture.format;
+    m_internal_format = internal_format;
+    m_num_levels = texture.num_levels;
+    m_bytes = 0;
+    m_source.reset();
+    m_storage_level = 0;
+    m_first_level = 0;
+
+    for(uint32_t i = 0; i < texture.num_levels; ++i)
+    {
+        const MipLevel& level = texture.level(0, i);
+        m_bytes += level.size;
+
+        if(compressed)
+        {
+            GL_CALL(glCompressedTexImage2D(GL_TEXTURE_2D, (int)i, internal_format, (int)level.width, (int)level.height, 0, (int)level.size, texture.level_data(0, i)));
+        }
+        else
+        {
+            GL_CALL(glTexImage2D(GL_TEXTURE_2D, (int)i, internal_format, (int)level.width, (int)level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, texture.level_data(0, i)));
+        }
+    }
+
+    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)texture.num_levels - 1));
+
+    make_resident();
 }
 
 void Texture2D::move_members(Texture2D&& t) noexcept
@@ -145,54 +377,46 @@ void Texture2D::move_members(Texture2D&& t) noexcept
 	m_colour_channels = t.m_colour_channels;
 	m_data = t.m_data;
 	t.m_data = nullptr;
+    m_multisample = t.m_multisample;
+    m_resident = t.m_resident;
+    t.m_resident = false;
+    m_format = t.m_format;
+    m_internal_format = t.m_internal_format;
+    m_num_levels = t.m_num_levels;
+    m_bytes = t.m_bytes;
+    m_last_used = t.m_last_used;
+    m_source = std::move(t.m_source);
+    m_storage_level = t.m_storage_level;
+    m_first_level = t.m_first_level;
+    m_wanted_level = t.m_wanted_level;
 }
 
 CubeMap::CubeMap(const std::string& dir, ImageFormat fmt)
 {
     const char* img_ext = image_extension(fmt);
 
-    m_faces[0] = dir + "right" + img_ext;
-    m_faces[1] = dir + "left" + img_ext;
-    m_faces[2] = dir + "top" + img_ext;
-    m_faces[3] = dir + "bottom" + img_ext;
-    m_faces[4] = dir + "front" + img_ext;
-    m_faces[5] = dir + "back" + img_ext;
+    for (int i = 0; i < 6; ++i)
+        m_faces[i] = dir + CUBE_FACE_NAMES[i] + img_ext;
 
+    // the cooked version is a single file with every face and its mips
+    TextureData texture;
+    std::string cooked_path = AssetCache::find(dir);
+    if(cooked_path.empty() || !map_cooked_texture(cooked_path, texture) || texture.faces != 6)
+    {
+        if(!cooked_path.empty())
+            warn("Could not read cooked cube map {}, falling back to {}\n", cooked_path, dir);
 
-	GL_CALL(glGenTextures(1, &m_id));
-	GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, m_id));
-	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	
-	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE));
-
-	GL_CALL(glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS));
-
-	stbi_set_flip_vertically_on_load(1);
-
-	for (int i = 0; i < 6; ++i)
-	{
-		int width, height, num_channels;
-		unsigned char* data = stbi_load(m_faces[i].c_str(), &width, &height, &num_channels, 4);
-		stbi_set_flip_vertically_on_load(0);
-
-		if (!data)
-			fatal("Could not load image: %s! No data!", m_faces[i]);
-
-		GL_CALL(glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
-
-		stbi_image_free(data);
-	}
+        if(!decode_cube_faces(m_faces, texture, false))
+            fatal("Could not load cube map: {}\n", dir);
+    }
 
-    make_resident();
+    create_from_data(texture);
 }
 
 CubeMap::CubeMap(int component_type, unsigned int width, unsigned int height)
 {
     GL_CALL(glGenTextures(1, &m_id));
-    glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
+    GLState::bind_texture(GL_TEXTURE_CUBE_MAP, m_id);
     for (unsigned int i = 0; i < 6; ++i)
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, component_type, width, height, 0, component_type, GL_FLOAT, NULL);
 
@@ -213,18 +437,18 @@ CubeMap::CubeMap(CubeMap&& cb) noexcept
 
 CubeMap::~CubeMap()
 {
+	GLState::forget_texture(m_id);
 	GL_CALL(glDeleteTextures(1, &m_id));
 }
 
 void CubeMap::bind(unsigned int slot) const
 {
-	GL_CALL(glActiveTexture(GL_TEXTURE0 + slot));
-	GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, m_id));
+	GLState::bind_texture(slot, GL_TEXTURE_CUBE_MAP, m_id);
 }
 
 void CubeMap::unbind() const
 {
-	GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, 0));
+	GLState::bind_texture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void CubeMap::operator=(CubeMap&& cb) noexcept
@@ -233,5 +457,126 @@ void CubeMap::operator=(CubeMap&& cb) noexcept
 	cb.m_id = 0;
 }
 
+// all faces go into immutable storage in one go, skyboxes are sampled without gamma correction
+void CubeMap::create_from_data(const TextureData& texture)
+{
+    unsigned int internal_format = gl_internal_format(texture.format, false);
+    bool compressed = is_block_compressed(texture.format);
+
+	GL_CALL(glGenTextures(1, &m_id));
+	GLState::bind_texture(GL_TEXTURE_CUBE_MAP, m_id);
+    GL_CALL(glTexStorage2D(GL_TEXTURE_CUBE_MAP, (int)texture.num_levels, internal_format, (int)texture.width, (int)texture.height));
+
+    for(uint32_t face = 0; face < 6; ++face)
+    {
+        for(uint32_t i = 0; i < texture.num_levels; ++i)
+        {
+            const MipLevel& level = texture.level(face, i);
+
+            if(compressed)
+            {
+                GL_CALL(glCompressedTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, (int)i, 0, 0, (int)level.width, (int)level.height, internal_format, (int)level.size, texture.level_data(face, i)));
+            }
+            else
+            {
+                GL_CALL(glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, (int)i, 0, 0, (int)level.width, (int)level.height, GL_RGBA, GL_UNSIGNED_BYTE, texture.level_data(face, i)));
+            }
+        }
+    }
+
+	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, texture.num_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, (int)texture.num_levels - 1));
+
+	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	GL_CALL(glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE));
+
+	GLState::set_enabled(GL_TEXTURE_CUBE_MAP_SEAMLESS, true);
+
+    make_resident();
+}
+
+std::unordered_map<std::string, std::weak_ptr<Texture2D>> TextureTable::m_by_path;
+std::unordered_map<uint64_t, std::weak_ptr<Texture2D>> TextureTable::m_by_hash;
+
+std::shared_ptr<Texture2D> TextureTable::get(const std::string& file_path, bool gamma_correct)
+{
+    // the same file is a different texture depending on whether it gets sampled as sRGB
+    std::string key = std::filesystem::weakly_canonical(file_path).generic_string() + (gamma_correct ? "" : "#linear");
+
+    auto path_it = m_by_path.find(key);
+    if (path_it != m_by_path.end())
+    {
+        if (auto texture = path_it->second.lock())
+            return texture;
+    }
+
+    // models often ship their own copy of the same image so also check the contents
+    // the cooker has already hashed them, uncooked files are only matched by path since hashing would read them twice
+    uint64_t content_hash = AssetCache::find_hash(file_path);
+
+    if (content_hash != 0)
+    {
+        content_hash = hash_combine(content_hash, gamma_correct);
+
+        auto hash_it = m_by_hash.find(content_hash);
+        if (hash_it != m_by_hash.end())
+        {
+            if (auto texture = hash_it->second.lock())
+            {
+                m_by_path[key] = texture;
+                return texture;
+            }
+        }
+    }
+
+    remove_expired();
 
+    std::shared_ptr<Texture2D> texture = load(file_path, gamma_correct);
+    ResidencyManager::track(texture, file_path, gamma_correct);
+    m_by_path[key] = texture;
 
+    if (content_hash != 0)
+        m_by_hash[content_hash] = texture;
+
+    return texture;
+}
+
+size_t TextureTable::get_num_loaded()
+{
+    remove_expired();
+
+    // several paths can share a texture so count the textures themselves
+    std::unordered_set<Texture2D*> loaded;
+    for (const auto& [key, texture] : m_by_path)
+        loaded.insert(texture.lock().get());
+
+    return loaded.size();
+}
+
+void TextureTable::release()
+{
+    m_by_path.clear();
+    m_by_hash.clear();
+}
+
+// cooked textures start out with their coarse mips, otherwise the texture is white until the real one has been decoded
+std::shared_ptr<Texture2D> TextureTable::load(const std::string& file_path, bool gamma_correct)
+{
+    if (auto texture = TextureStreamer::load(file_path, gamma_correct))
+        return texture;
+
+    if (!AsyncLoader::is_enabled())
+        return std::make_shared<Texture2D>(file_path, gamma_correct);
+
+    std::shared_ptr<Texture2D> texture = AsyncLoader::create_placeholder_texture();
+    AsyncLoader::request_texture(file_path, texture, gamma_correct);
+    return texture;
+}
+
+void TextureTable::remove_expired()
+{
+    std::erase_if(m_by_path, [](const auto& entry) { return entry.second.expired(); });
+    std::erase_if(m_by_hash, [](const auto& entry) { return entry.second.expired(); });
+}
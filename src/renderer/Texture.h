@@ -1,6 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+
+struct TextureData;
+enum class PixelFormat : uint32_t;
 
 enum class ImageFormat
 {
@@ -16,10 +21,13 @@ public:
 	virtual void unbind() const = 0;
 
     void make_resident() const;
+    void make_non_resident() const;
+    [[nodiscard]] bool is_resident() const { return m_resident; }
     [[nodiscard]] uint64_t get_handle() const;
 
 protected:
     unsigned int m_id;
+    mutable bool m_resident = false;
 
     friend class FrameBuffer;
 };
@@ -28,6 +36,9 @@ class Texture2D : public TextureBase
 {
 public:
 	explicit Texture2D(const std::string& file_name, bool gamma_correct = true);
+    explicit Texture2D(const TextureData& texture, bool gamma_correct = true);
+    // only the levels up to start_size are uploaded, the finer ones are streamed in from the source later
+    Texture2D(std::shared_ptr<const TextureData> source, uint32_t start_size, bool gamma_correct = true);
     Texture2D(unsigned int component_type, unsigned int width, unsigned int height, int samples = 1);
 	Texture2D(Texture2D&& t) noexcept;
 	~Texture2D();
@@ -35,19 +46,57 @@ public:
 	void bind(unsigned int slot = 0) const override;
 	void unbind() const override;
 
+    // replaces the contents with new data, the texture gets a new GL object since resident textures are immutable
+    void upload(const TextureData& texture, bool gamma_correct = true);
+
+    // throws away every level bigger than max_size, returns false if there was nothing to drop
+    bool drop_mips(uint32_t max_size);
+
+    // streamed textures track the finest level any draw asked for this frame
+    // levels are counted from the top of the source, no matter how many are uploaded
+    void request_size(float screen_size) const;
+    [[nodiscard]] uint32_t take_wanted_level() const;
+    // grows the storage so it can hold level, the new levels stay hidden behind the base level until streamed in
+    void stream_to(uint32_t level);
+    // uploads the next finer level, returns false if everything allocated is already filled
+    bool stream_next_level();
+
+    [[nodiscard]] bool is_streamed() const { return m_source != nullptr; }
+    [[nodiscard]] bool is_stream_pending() const { return m_first_level > m_storage_level; }
+    [[nodiscard]] uint32_t get_first_level() const { return m_first_level; }
+    [[nodiscard]] uint32_t get_storage_level() const { return m_storage_level; }
 
 	[[nodiscard]] int get_width() const { return m_width; }
 	[[nodiscard]] int get_height() const { return m_height; }
+    [[nodiscard]] uint32_t get_num_levels() const { return m_num_levels; }
+    [[nodiscard]] uint64_t get_num_bytes() const { return m_bytes; }
+    [[nodiscard]] uint64_t get_last_used() const { return m_last_used; }
 
 	void operator= (Texture2D&& t) noexcept;
 
 private:
 	void move_members(Texture2D&& t) noexcept;
+	void create_from_data(const TextureData& texture, bool gamma_correct);
+	void create_storage(uint32_t first_level, uint32_t num_levels, int width, int height);
+	void set_level_range() const;
+	void upload_level(uint32_t level) const;
 
 	int m_width, m_height;
 	int m_colour_channels;
     bool m_multisample = false;
 	unsigned char* m_data;
+
+    PixelFormat m_format;
+    unsigned int m_internal_format = 0;
+    uint32_t m_num_levels = 1;
+    uint64_t m_bytes = 0;
+    mutable uint64_t m_last_used = 0; // frame of the last bind
+
+    // level 0 of the GL texture is level m_storage_level of the source, only m_first_level and down hold data
+    std::shared_ptr<const TextureData> m_source;
+    uint32_t m_storage_level = 0;
+    uint32_t m_first_level = 0;
+    mutable uint32_t m_wanted_level = UINT32_MAX;
 };
 
 class CubeMap : public TextureBase
@@ -64,5 +113,24 @@ public:
 	void operator= (CubeMap&& cb) noexcept;
 
 private:
+	void create_from_data(const TextureData& texture);
+
 	std::string m_faces[6];
+};
+
+// hands out one texture per image no matter how many materials use it
+// entries are weak so a texture goes away as soon as nothing references it anymore
+class TextureTable
+{
+public:
+    static std::shared_ptr<Texture2D> get(const std::string& file_path, bool gamma_correct = true);
+    [[nodiscard]] static size_t get_num_loaded();
+    static void release();
+
+private:
+    static std::shared_ptr<Texture2D> load(const std::string& file_path, bool gamma_correct);
+    static void remove_expired();
+
+    static std::unordered_map<std::string, std::weak_ptr<Texture2D>> m_by_path;
+    static std::unordered_map<uint64_t, std::weak_ptr<Texture2D>> m_by_hash;
 };
\ No newline at end of file
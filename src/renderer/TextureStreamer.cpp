@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "TextureStreamer.h"
+#include "Texture.h"
+#include "ResidencyManager.h"
+#include "AssetCache.h"
+#include "TextureData.h"
+
+#include <chrono>
+
+// levels up to this size are uploaded as soon as the texture is loaded
+static constexpr uint32_t STREAM_START_SIZE = 128;
+
+bool TextureStreamer::m_enabled = false;
+std::vector<std::weak_ptr<Texture2D>> TextureStreamer::m_textures;
+size_t TextureStreamer::m_num_levels_streamed = 0;
+size_t TextureStreamer::m_num_trimmed = 0;
+
+std::shared_ptr<Texture2D> TextureStreamer::load(const std::string& file_path, bool gamma_correct)
+{
+    if (!m_enabled)
+        return nullptr;
+
+    std::string cooked_path = AssetCache::find(file_path);
+    if (cooked_path.empty())
+        return nullptr;
+
+    auto source = std::make_shared<TextureData>();
+    if (!map_cooked_texture(cooked_path, *source))
+        return nullptr;
+
+    // small enough that streaming would only add overhead
+    if (source->faces != 1 || source->num_levels == 1 || std::max(source->width, source->height) <= STREAM_START_SIZE)
+        return std::make_shared<Texture2D>(*source, gamma_correct);
+
+    auto texture = std::make_shared<Texture2D>(std::shared_ptr<const TextureData>(source), STREAM_START_SIZE, gamma_correct);
+    m_textures.push_back(texture);
+    return texture;
+}
+
+void TextureStreamer::update(float budget_ms)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::erase_if(m_textures, [](const auto& texture) { return texture.expired(); });
+
+    // once over budget, textures that were streamed finer than they are now drawn give the difference back
+    bool over_budget = ResidencyManager::get_usage() > ResidencyManager::get_budget();
+
+    std::vector<std::shared_ptr<Texture2D>> pending;
+    for (const auto& weak_texture : m_textures)
+    {
+        std::shared_ptr<Texture2D> texture = weak_texture.lock();
+
+        // nothing drew it last frame, the residency manager decides what happens to it
+        uint32_t wanted = texture->take_wanted_level();
+        if (wanted == UINT32_MAX)
+            continue;
+
+        if (wanted < texture->get_storage_level())
+        {
+            texture->stream_to(wanted);
+        }
+        else if (over_budget && wanted > texture->get_storage_level())
+        {
+            uint32_t dropped = wanted - texture->get_storage_level();
+            if (texture->drop_mips((uint32_t)std::max(texture->get_width() >> dropped, texture->get_height() >> dropped)))
+                ++m_num_trimmed;
+        }
+
+        if (texture->is_stream_pending())
+            pending.push_back(texture);
+    }
+
+    // one level per texture at a time so everything on screen sharpens at the same rate
+    // a single level can be large, so the budget is checked after every upload rather than every round
+    auto out_of_time = [&]()
+    {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        return elapsed.count() >= budget_ms;
+    };
+
+    while (!pending.empty() && !out_of_time())
+    {
+        for (const auto& texture : pending)
+        {
+            texture->stream_next_level();
+            ++m_num_levels_streamed;
+
+            if (out_of_time())
+                break;
+        }
+
+        std::erase_if(pending, [](const auto& texture) { return !texture->is_stream_pending(); });
+    }
+}
+
+void TextureStreamer::release()
+{
+    m_textures.clear();
+}
+
+size_t TextureStreamer::get_num_streaming()
+{
+    size_t num_streaming = 0;
+    for (const auto& weak_texture : m_textures)
+    {
+        if (auto texture = weak_texture.lock(); texture && texture->is_stream_pending())
+            ++num_streaming;
+    }
+
+    return num_streaming;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "renderer/Fwd.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// cooked textures get their coarse mips uploaded straight away, the finer ones follow as draws need them
+// the cooked file stays mapped so a level is only read from disk once it gets streamed in
+class TextureStreamer
+{
+public:
+    static void set_enabled(bool enabled) { m_enabled = enabled; }
+    [[nodiscard]] static bool is_enabled() { return m_enabled; }
+
+    // nullptr if there is no cooked version to stream from
+    static std::shared_ptr<Texture2D> load(const std::string& file_path, bool gamma_correct);
+
+    // must be called from the GL thread, acts on the sizes requested by the last frame's draws
+    static void update(float budget_ms = 2.f);
+    static void release();
+
+    [[nodiscard]] static size_t get_num_streaming();
+    [[nodiscard]] static size_t get_num_levels_streamed() { return m_num_levels_streamed; }
+    [[nodiscard]] static size_t get_num_trimmed() { return m_num_trimmed; }
+
+private:
+    static bool m_enabled;
+    static std::vector<std::weak_ptr<Texture2D>> m_textures;
+    static size_t m_num_levels_streamed;
+    static size_t m_num_trimmed;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "VertexArray.h"
 #include "GLError.h"
+#include "GLState.h"
 
 #include <glad/glad.h>
 
@@ -32,6 +33,7 @@ VertexArray::VertexArray(VertexArray&& va) noexcept
 
 VertexArray::~VertexArray()
 {
+	GLState::forget_vertex_array(m_id);
 	GL_CALL(glDeleteVertexArrays(1, &m_id));
 }
 
@@ -48,12 +50,12 @@ void VertexArray::set_layout(const BufferLayout& layout) const
 
 void VertexArray::bind() const
 {
-	GL_CALL(glBindVertexArray(m_id));
+	GLState::bind_vertex_array(m_id);
 }
 
 void VertexArray::unbind() const
 {
-	GL_CALL(glBindVertexArray(0));
+	GLState::bind_vertex_array(0);
 }
 
 void VertexArray::operator= (VertexArray&& va) noexcept
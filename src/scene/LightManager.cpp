@@ -4,34 +4,76 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "Buffer.h"
+#include "FrameUniforms.h"
+#include "ShaderReflection.h"
 #include "components/Transform.h"
 #include "components/Light.h"
 
 // TODO: remove later
 #include <glad/glad.h>
 
-enum class PointLightBufferOffsets : int
+// laid out like the std430 PointLights and DirectLight blocks in shaders/include/lights.glsl
+// register_layouts has the shaders checked against these when they link, glsl bools are 4 bytes
+struct PointLightData
 {
-    colour = 0,
-    position = 16,
-    range = 28,
-    brightness = 32,
-    shadow_casting = 36,
-    shadow_far_plane = 40,
-    shadow_bias = 44,
-    total_offset = 48
+    glm::vec4 colour;
+    glm::vec3 position;
+    float range;
+    float brightness;
+    uint32_t shadow_casting;
+    float shadow_far_plane;
+    float shadow_bias;
 };
 
-enum class DirectLightBufferOffsets
+struct DirectLightData
 {
-    active = 0,
-    colour = 16,
-    direction = 32,
-    brightness = 44,
-    shadow_map = 48,
-    total_offset = 64
+    uint32_t active;
+    uint32_t padding[3];
+    glm::vec4 colour;
+    glm::vec3 direction;
+    float brightness;
+    uint64_t shadow_map; // bindless handle
+    uint64_t padding_end;
 };
 
+static_assert(sizeof(PointLightData) == 48 && sizeof(DirectLightData) == 64);
+
+static constexpr unsigned int POINT_LIGHT_BINDING = 1;
+static constexpr unsigned int DIRECT_LIGHT_BINDING = 2;
+static constexpr unsigned int POINT_SHADOW_MAP_BINDING = 3;
+
+// every program that loops over the point lights with the count rather than the buffer's length
+static void set_num_point_lights(int num_point_lights)
+{
+    for (const char* name : { "default", "default[INSTANCED]", "uber", "uber[INSTANCED]" })
+        ShaderTable::get(name)->set_uniform_1i("u_num_point_lights", num_point_lights);
+}
+
+void LightManager::register_layouts()
+{
+    ShaderReflection::register_layout({ "PointLights", POINT_LIGHT_BINDING, true, sizeof(PointLightData), {
+        { "point_lights[0].colour", offsetof(PointLightData, colour), GL_FLOAT_VEC4 },
+        { "point_lights[0].position", offsetof(PointLightData, position), GL_FLOAT_VEC3 },
+        { "point_lights[0].range", offsetof(PointLightData, range), GL_FLOAT },
+        { "point_lights[0].brightness", offsetof(PointLightData, brightness), GL_FLOAT },
+        { "point_lights[0].shadow_casting", offsetof(PointLightData, shadow_casting), GL_BOOL },
+        { "point_lights[0].shadow_far_plane", offsetof(PointLightData, shadow_far_plane), GL_FLOAT },
+        { "point_lights[0].shadow_bias", offsetof(PointLightData, shadow_bias), GL_FLOAT }
+    }});
+
+    ShaderReflection::register_layout({ "DirectLight", DIRECT_LIGHT_BINDING, true, 0, {
+        { "directional_light._active", offsetof(DirectLightData, active), GL_BOOL },
+        { "directional_light.colour", offsetof(DirectLightData, colour), GL_FLOAT_VEC4 },
+        { "directional_light.direction", offsetof(DirectLightData, direction), GL_FLOAT_VEC3 },
+        { "directional_light.brightness", offsetof(DirectLightData, brightness), GL_FLOAT },
+        { "shadow_map", offsetof(DirectLightData, shadow_map), GL_SAMPLER_2D }
+    }});
+
+    ShaderReflection::register_layout({ "PointShadowMaps", POINT_SHADOW_MAP_BINDING, true, sizeof(uint64_t), {
+        { "shadow_cubemaps[0]", 0, GL_SAMPLER_CUBE }
+    }});
+}
+
 void LightManager::get_lights(const SceneNodePtr& node)
 {
 	if (node->entity()->has_component<PointLight>())
@@ -54,18 +96,37 @@ void LightManager::init_lights()
     if(!m_point_lights.empty())
         adjust_point_lights_buff();
     else
-        ShaderTable::get("default")->set_uniform_1i("u_num_point_lights", 0);
+        set_num_point_lights(0);
 
     if(m_direct_light)
     {
-        m_direct_light_buffer = std::make_unique<Buffer>((int)DirectLightBufferOffsets::total_offset, BufferType::SHADER_STORAGE);
-        m_direct_light_buffer->link(2);
+        m_direct_light_buffer = std::make_unique<Buffer>(sizeof(DirectLightData), BufferType::SHADER_STORAGE);
+        m_direct_light_buffer->link(DIRECT_LIGHT_BINDING);
 
-        m_direct_light_buffer->set_data((int)DirectLightBufferOffsets::active, true);
+        m_direct_light_buffer->set_data((int)offsetof(DirectLightData, active), (uint32_t)1);
     }
 }
 
-void LightManager::update_lights(const std::vector<RenderObject>& render_list, const std::shared_ptr<Camera>& camera)
+void LightManager::write_frame_data(FrameData& frame)
+{
+    frame.light_space_view = glm::mat4(1.f);
+    frame.light_space_projection = glm::mat4(1.f);
+
+    if (!m_direct_light)
+        return;
+
+    auto& direct_light = m_direct_light->get_component<DirectionalLight>();
+    if (!direct_light.is_casting_shadow())
+        return;
+
+    if (!direct_light.get_shadow_buffer())
+        direct_light.shadow_init(m_direct_light->get_component<Transform>().get_position());
+
+    frame.light_space_view = direct_light.get_light_view();
+    frame.light_space_projection = direct_light.get_light_projection();
+}
+
+void LightManager::update_lights(const std::vector<RenderObject>& render_list, FrameUniforms& frame_uniforms)
 {
     int index = 0;
 	for (auto& m_point_light : m_point_lights)
@@ -76,17 +137,16 @@ void LightManager::update_lights(const std::vector<RenderObject>& render_list, c
 			auto& point_light = m_point_light->get_component<PointLight>();
 			glm::vec3 pos = transform.get_position();
 
-            m_point_light_buffer->set_data((int)PointLightBufferOffsets::colour + ((int)PointLightBufferOffsets::total_offset * index), point_light.get_colour());
-            m_point_light_buffer->set_data((int)PointLightBufferOffsets::position + ((int)PointLightBufferOffsets::total_offset * index), pos);
-            m_point_light_buffer->set_data((int)PointLightBufferOffsets::range + ((int)PointLightBufferOffsets::total_offset * index), point_light.get_range());
-            m_point_light_buffer->set_data((int)PointLightBufferOffsets::brightness + ((int)PointLightBufferOffsets::total_offset * index), point_light.get_brightness());
-            m_point_light_buffer->set_data((int)PointLightBufferOffsets::shadow_casting + ((int)PointLightBufferOffsets::total_offset * index), point_light.is_casting_shadow());
-
-            // TODO: consolidate into uniform buffer
-            ShaderTable::get("default")->set_uniform_3f("u_cam_pos", camera->get_pos());
-            ShaderTable::get("inst_default")->set_uniform_3f("u_cam_pos", camera->get_pos());
-            ShaderTable::get("pbr_standard")->set_uniform_3f("u_cam_pos", camera->get_pos());
-            ShaderTable::get("blinn-phong")->set_uniform_3f("u_cam_pos", camera->get_pos());
+            // packed here and written in one go
+            PointLightData data{};
+            data.colour = point_light.get_colour();
+            data.position = pos;
+            data.range = point_light.get_range();
+            data.brightness = point_light.get_brightness();
+            data.shadow_casting = point_light.is_casting_shadow();
+            data.shadow_far_plane = point_light.get_far_plane();
+            data.shadow_bias = point_light.get_shadow_bias();
+            m_point_light_buffer->set_data((int)(sizeof(PointLightData) * index), data);
 
             if(point_light.is_casting_shadow())
             {
@@ -98,19 +158,15 @@ void LightManager::update_lights(const std::vector<RenderObject>& render_list, c
 
                 point_light.shadow_update_transforms(pos);
 
-                std::vector<glm::mat4> shadow_transforms = point_light.get_shadow_transforms();
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_shadow_transforms[0]", shadow_transforms[0]);
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_shadow_transforms[1]", shadow_transforms[1]);
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_shadow_transforms[2]", shadow_transforms[2]);
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_shadow_transforms[3]", shadow_transforms[3]);
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_shadow_transforms[4]", shadow_transforms[4]);
-                ShaderTable::get("shadow_cubemap")->set_uniform_mat4f("u_shadow_transforms[5]", shadow_transforms[5]);
+                // each shadow gets its own view so the ones drawn earlier this frame keep theirs
+                ShadowViewData& shadow_view = frame_uniforms.next_shadow_view();
+                const std::vector<glm::mat4>& shadow_transforms = point_light.get_shadow_transforms();
+                for (int face = 0; face < 6; ++face)
+                    shadow_view.shadow_transforms[face] = shadow_transforms[face];
 
-                ShaderTable::get("shadow_cubemap")->set_uniform_3f("u_light_pos", pos);
-                ShaderTable::get("shadow_cubemap")->set_uniform_1f("u_far_plane", point_light.get_far_plane());
+                shadow_view.light_pos = pos;
+                shadow_view.far_plane = point_light.get_far_plane();
 
-                m_point_light_buffer->set_data((int)PointLightBufferOffsets::shadow_far_plane + ((int)PointLightBufferOffsets::total_offset * index), point_light.get_far_plane());
-                m_point_light_buffer->set_data((int)PointLightBufferOffsets::shadow_bias + ((int)PointLightBufferOffsets::total_offset * index), point_light.get_shadow_bias());
                 m_point_shadow_maps->set_data((int)(index * sizeof(uint64_t)), glGetTextureHandleARB(point_light.get_shadow_cubemap()));
 
                 point_light.bind_shadow_map();
@@ -125,42 +181,24 @@ void LightManager::update_lights(const std::vector<RenderObject>& render_list, c
 	if (m_direct_light)
 	{
         auto& direct_light = m_direct_light->get_component<DirectionalLight>();
-        auto& dl_transform = m_direct_light->get_component<Transform>();
-
-        m_direct_light_buffer->set_data((int)DirectLightBufferOffsets::colour, direct_light.get_colour());
-        m_direct_light_buffer->set_data((int)DirectLightBufferOffsets::direction, direct_light.get_direction());
-        m_direct_light_buffer->set_data((int)DirectLightBufferOffsets::brightness, direct_light.get_brightness());
 
-        // TODO: consolidate into uniform buffer
-        ShaderTable::get("default")->set_uniform_3f("u_cam_pos", camera->get_pos());
-        ShaderTable::get("inst_default")->set_uniform_3f("u_cam_pos", camera->get_pos());
-        ShaderTable::get("pbr_standard")->set_uniform_3f("u_cam_pos", camera->get_pos());
-        ShaderTable::get("blinn-phong")->set_uniform_3f("u_cam_pos", camera->get_pos());
+        m_direct_light_buffer->set_data((int)offsetof(DirectLightData, colour), direct_light.get_colour());
+        m_direct_light_buffer->set_data((int)offsetof(DirectLightData, direction), direct_light.get_direction());
+        m_direct_light_buffer->set_data((int)offsetof(DirectLightData, brightness), direct_light.get_brightness());
 
+        // the light space matrices went into the frame data in write_frame_data
         if(direct_light.is_casting_shadow())
         {
-            if(!(direct_light.get_shadow_buffer()))
-            {
-                direct_light.shadow_init(dl_transform.get_position());
-            }
-
-            ShaderTable::get("shadow_map")->set_uniform_mat4f("u_light_space_view", direct_light.get_light_view());
-            ShaderTable::get("shadow_map")->set_uniform_mat4f("u_light_space_projection", direct_light.get_light_projection());
-            ShaderTable::get("inst_shadow_map")->set_uniform_mat4f("u_light_space_view", direct_light.get_light_view());
-            ShaderTable::get("inst_shadow_map")->set_uniform_mat4f("u_light_space_projection", direct_light.get_light_projection());
-            // TODO: uniform buffer
-            ShaderTable::get("default")->set_uniform_mat4f("u_light_proj", direct_light.get_light_projection() * direct_light.get_light_view());
-            ShaderTable::get("inst_default")->set_uniform_mat4f("u_light_proj", direct_light.get_light_projection() * direct_light.get_light_view());
             direct_light.bind_shadow_map();
             Renderer::shadow_pass(render_list);
-            m_direct_light_buffer->set_data((int)DirectLightBufferOffsets::shadow_map, glGetTextureHandleARB(direct_light.get_shadow_map()));
+            m_direct_light_buffer->set_data((int)offsetof(DirectLightData, shadow_map), glGetTextureHandleARB(direct_light.get_shadow_map()));
         }
     }
 }
 
 void LightManager::remove_directional_light()
 {
-    m_direct_light_buffer->set_data((int)DirectLightBufferOffsets::active, false);
+    m_direct_light_buffer->set_data((int)offsetof(DirectLightData, active), (uint32_t)0);
     m_direct_light = nullptr;
 }
 
@@ -187,11 +225,10 @@ void LightManager::remove_point_light(const SceneNodePtr& node)
 void LightManager::adjust_point_lights_buff()
 {
     int num_point_lights = (int)m_point_lights.size();
-    int buffer_size = (int)PointLightBufferOffsets::total_offset * num_point_lights;
-    m_point_light_buffer = std::make_unique<Buffer>(buffer_size, BufferType::SHADER_STORAGE);
-    m_point_light_buffer->link(1);
-    ShaderTable::get("default")->set_uniform_1i("u_num_point_lights", num_point_lights);
+    m_point_light_buffer = std::make_unique<Buffer>(sizeof(PointLightData) * num_point_lights, BufferType::SHADER_STORAGE);
+    m_point_light_buffer->link(POINT_LIGHT_BINDING);
+    set_num_point_lights(num_point_lights);
 
     m_point_shadow_maps = std::make_unique<Buffer>(sizeof(uint64_t) * num_point_lights, BufferType::SHADER_STORAGE);
-    m_point_shadow_maps->link(3);
+    m_point_shadow_maps->link(POINT_SHADOW_MAP_BINDING);
 }
\ No newline at end of file
@@ -10,14 +10,21 @@ class SceneNode;
 class Entity;
 class Camera;
 class Buffer;
+class FrameUniforms;
+struct FrameData;
 struct RenderObject;
 
 class LightManager
 {
 public:
+    // the layouts of the light buffers, checked against every program that links after this
+    static void register_layouts();
+
 	void get_lights(const SceneNodePtr& node);
     void init_lights();
-	void update_lights(const std::vector<RenderObject>& render_list, const std::shared_ptr<Camera>& camera);
+	// the light space matrices of the directional light's shadow
+	void write_frame_data(FrameData& frame);
+	void update_lights(const std::vector<RenderObject>& render_list, FrameUniforms& frame_uniforms);
 
     // directional light
     void remove_directional_light();
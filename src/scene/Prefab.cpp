@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "Prefab.h"
+#include "Entity.h"
+#include "SceneData.h"
+#include "Log.h"
+
+using namespace nlohmann;
+
+std::map<std::string, std::shared_ptr<Prefab>> PrefabTable::m_prefabs;
+
+// components store floats, so the template is brought down to the same precision
+// otherwise every instance would look like it overrides whatever it saves
+static void round_to_floats(json& value)
+{
+    if (value.is_number_float())
+    {
+        value = (double)(float)value.get<double>();
+    }
+    else if (value.is_structured())
+    {
+        for (auto& element : value)
+            round_to_floats(element);
+    }
+}
+
+void PrefabTable::add(const std::string& name, json nodes)
+{
+    if (exists(name) || !nodes.is_array() || nodes.empty())
+        return;
+
+    auto prefab = std::make_shared<Prefab>();
+    prefab->parents.resize(nodes.size(), SCENE_NONE);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        round_to_floats(nodes[i]);
+
+        int child_count = nodes[i].value("child_count", 0);
+        const json children = nodes[i].value("children", json::array());
+
+        for (int c = 0; c < child_count && c < (int)children.size(); ++c)
+        {
+            auto child = children[c].get<size_t>();
+            if (child <= i || child >= nodes.size())
+            {
+                error("Prefab {} has a node out of order\n", name);
+                return;
+            }
+
+            prefab->parents[child] = (uint32_t)i;
+        }
+    }
+
+    // everything but the top node has to hang off something inside the prefab
+    for (size_t i = 1; i < nodes.size(); ++i)
+    {
+        if (prefab->parents[i] == SCENE_NONE)
+        {
+            error("Prefab {} has more than one top node\n", name);
+            return;
+        }
+    }
+
+    prefab->nodes = std::move(nodes);
+    m_prefabs[name] = std::move(prefab);
+}
+
+std::shared_ptr<Prefab> PrefabTable::get(const std::string& name)
+{
+    auto it = m_prefabs.find(name);
+    return (it != m_prefabs.end()) ? it->second : nullptr;
+}
+
+bool PrefabTable::exists(const std::string& name)
+{
+    return m_prefabs.find(name) != m_prefabs.end();
+}
+
+void PrefabTable::release()
+{
+    m_prefabs.clear();
+}
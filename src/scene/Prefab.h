@@ -0,0 +1,33 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class Entity;
+
+// a subtree that is loaded once and placed by reference, nodes are laid out like a scene's models
+// (depth first, children by index) with node 0 at the top
+struct Prefab
+{
+    nlohmann::json nodes = nlohmann::json::array();
+    std::vector<uint32_t> parents; // node 0 has none
+
+    // built by the first instance, whatever an instance doesn't override is shared with these
+    std::vector<std::shared_ptr<Entity>> templates;
+};
+
+class PrefabTable
+{
+public:
+    static void add(const std::string& name, nlohmann::json nodes);
+    static std::shared_ptr<Prefab> get(const std::string& name);
+    static bool exists(const std::string& name);
+    [[nodiscard]] static const std::map<std::string, std::shared_ptr<Prefab>>& get_prefabs() { return m_prefabs; }
+    static void release();
+
+private:
+    static std::map<std::string, std::shared_ptr<Prefab>> m_prefabs;
+};
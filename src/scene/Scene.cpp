@@ -2,15 +2,23 @@
 #include "Entity.h"
 #include "Renderer.h"
 #include "SceneSerializer.h"
+#include "Prefab.h"
 #include "Mesh.h"
 #include "Log.h"
 #include "components/Transform.h"
 #include "components/Light.h"
 #include "components/MeshComponent.h"
 #include "renderer/Material.h"
+#include "renderer/FrameUniforms.h"
+#include "renderer/ProgramCache.h"
+#include "renderer/Texture.h"
+#include "renderer/ResidencyManager.h"
+#include "renderer/TextureStreamer.h"
 #include "events/EventList.h"
 #include "ModelLoader.h"
 
+#include <unordered_set>
+#include <glm/geometric.hpp>
 #include <imgui_internal.h>
 #include <spdlog/fmt/bundled/format.h>
 
@@ -22,9 +30,13 @@ Scene::Scene(Window* window)
 
 Scene::~Scene()
 {
+    PrefabTable::release();
     ShaderTable::release();
     MeshTable::release();
     MaterialTable::release();
+    TextureTable::release();
+    ResidencyManager::release();
+    TextureStreamer::release();
 }
 
 void Scene::load(const char* scene)
@@ -40,7 +52,22 @@ void Scene::load(const char* scene)
 
 void Scene::save(const std::string& path)
 {
+    m_journal.set_scene_path(path);
 	SceneSerializer::save(path.c_str(), *this, m_camera, m_skybox, root);
+    m_journal.discard();
+}
+
+void Scene::save_incremental()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    if (SceneSerializer::save_incremental(*this))
+    {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+        m_journal.set_last_save_time(elapsed.count());
+    }
+
+    m_time_since_save = 0.f;
 }
 
 void Scene::init()
@@ -49,10 +76,7 @@ void Scene::init()
 
     auto [width, height] = m_window_handle->get_dimensions();
 	m_camera->resize(width, height);
-    m_transforms_buffer = std::make_unique<Buffer>(128, BufferType::UNIFORM);
-    m_transforms_buffer->link(0);
-    m_transforms_buffer->set_data(0, m_camera->camera_look_at());
-    m_transforms_buffer->set_data(64, m_camera->get_perspective());
+    m_frame_uniforms = std::make_unique<FrameUniforms>();
 
 	for (const auto& node : *root)
 	{
@@ -77,9 +101,21 @@ void Scene::update(float elapsed_time)
         m_nodes_to_remove.pop();
     }
 
-    // if the camera moved at all we need to adjust the view uniform
-	if(m_camera->update(elapsed_time))
-        m_transforms_buffer->set_data(0, m_camera->camera_look_at());
+    m_time_since_save += elapsed_time;
+    if (m_autosave && m_journal.is_enabled() && m_time_since_save >= AUTOSAVE_INTERVAL)
+        save_incremental();
+
+    m_camera->update(elapsed_time);
+    m_time += elapsed_time;
+
+    // everything drawn this frame reads from here, so it is all filled in before the first draw
+    FrameData& frame = m_frame_uniforms->begin_frame();
+    frame.view = m_camera->camera_look_at();
+    frame.projection = m_camera->get_perspective();
+    frame.cam_pos = m_camera->get_pos();
+    frame.time = m_time;
+    frame.delta_time = elapsed_time;
+    m_light_manager.write_frame_data(frame);
 
 	if (m_skybox)
 	{
@@ -96,11 +132,14 @@ void Scene::update(float elapsed_time)
 		update_node(scene_node, Transform{});
 	}
 
-    m_light_manager.update_lights(m_render_list, m_camera);
+    request_texture_sizes();
+    m_light_manager.update_lights(m_render_list, *m_frame_uniforms);
 
     m_window_handle->bind_viewport();
     Renderer::render_pass(m_render_list);
 
+    m_frame_uniforms->end_frame();
+
 }
 
 void Scene::add_primitive(const char* name)
@@ -117,6 +156,7 @@ void Scene::add_primitive(const char* name)
 
 	Entity entity;
     entity.set_name(lookup);
+    entity.set_id(m_next_entity_id++);
 
     Transform transform;
 
@@ -150,7 +190,7 @@ void Scene::add_primitive(const char* name)
     if(MeshTable::get(name)->is_instanced())
     {
         instanced_meshes[name].push_back(transform.get_transform());
-        material.set_shader(ShaderTable::get("inst_default"));
+        material.set_shader(ShaderTable::get("default", { "INSTANCED" }));
         MeshTable::get(name)->make_instanced((int)instanced_meshes[name].size(), instanced_meshes[name]);
         mesh_component.m_instance_id = (int)instanced_meshes[name].size() - 1;
     }
@@ -189,6 +229,7 @@ void Scene::add_model(const char* name)
 
     Entity entity;
     entity.set_name(lookup);
+    entity.set_id(m_next_entity_id++);
 
     Transform transform;
 
@@ -214,7 +255,7 @@ void Scene::add_model(const char* name)
     if(MeshTable::get(name)->is_instanced())
     {
         instanced_meshes[name].push_back(transform.get_transform());
-        material.set_shader(ShaderTable::get("inst_default"));
+        material.set_shader(ShaderTable::get("default", { "INSTANCED" }));
         MeshTable::get(name)->make_instanced((int)instanced_meshes[name].size(), instanced_meshes[name]);
         meshComponent.m_instance_id = (int)instanced_meshes[name].size() - 1;
     }
@@ -239,12 +280,84 @@ void Scene::add_model(const char* name)
     root->add_child(SceneNode{std::make_shared<Entity>(std::move(entity))});
 }
 
+void Scene::make_prefab(const SceneNodePtr& node)
+{
+    std::string name = node->entity()->get_name();
+    for (int i = 1; PrefabTable::exists(name); ++i)
+        name = node->entity()->get_name() + fmt::format(" ({})", i);
+
+    if (SceneSerializer::make_prefab(name, node, *this))
+        info("Made prefab {}\n", name);
+}
+
+void Scene::place_prefab(const std::string& prefab)
+{
+    std::string lookup{ prefab };
+    for (int i = 1; root->exists(lookup); ++i)
+        lookup = prefab + fmt::format(" ({})", i);
+
+    SceneNodePtr top = SceneSerializer::place_prefab(prefab, lookup, *this);
+    if (!top)
+        return;
+
+    std::unordered_set<std::string> instanced;
+    std::function<void(const SceneNodePtr&)> register_node = [&](const SceneNodePtr& node)
+    {
+        if (node->entity()->has_component<PointLight>())
+            m_light_manager.add_point_light(*node);
+
+        if (node->entity()->has_component<MeshComponent>() && node->entity()->get_component<MeshComponent>().m_instance_id >= 0)
+            instanced.insert(MeshTable::find(node->entity()->get_component<MeshComponent>().get_mesh()));
+
+        for (const auto& child : *node)
+            register_node(child);
+    };
+    register_node(top);
+
+    for (const std::string& mesh_name : instanced)
+        MeshTable::get(mesh_name)->make_instanced((int)instanced_meshes[mesh_name].size(), instanced_meshes[mesh_name]);
+}
+
+SceneNodePtr Scene::find_node(const SceneNodePtr& parent, uint32_t id) const
+{
+    for (const auto& child : *parent)
+    {
+        if (child->entity()->get_id() == id)
+            return child;
+
+        if (SceneNodePtr node = find_node(child, id))
+            return node;
+    }
+
+    return nullptr;
+}
+
+void Scene::unpack_prefab(const SceneNodePtr& node)
+{
+    if (!node || !node->entity() || !node->entity()->is_prefab())
+        return;
+
+    uint32_t instance_id = node->entity()->get_prefab_instance();
+    SceneNodePtr top = find_node(root, instance_id);
+    if (!top)
+        return;
+
+    // the nodes keep the ids they were given when the instance was loaded, they just get saved in full from now on
+    std::function<void(const SceneNodePtr&)> unlink = [&](const SceneNodePtr& current)
+    {
+        if (current->entity()->is_prefab() && current->entity()->get_prefab_instance() == instance_id)
+            current->entity()->unlink_prefab();
+
+        for (const auto& child : *current)
+            unlink(child);
+    };
+    unlink(top);
+}
+
 void Scene::window_resize(int width, int height)
 {
 	m_camera->resize(width, height);
 	Renderer::set_viewport(width, height);
-    m_transforms_buffer->set_data(0, m_camera->camera_look_at());
-    m_transforms_buffer->set_data(64, m_camera->get_perspective());
 }
 
 void Scene::remove_node(SceneNodePtr& node)
@@ -258,6 +371,10 @@ void Scene::remove_node(SceneNodePtr& node)
         m_light_manager.remove_directional_light();
     }
 
+	// a prefab node on its own can't go without the rest of its instance changing shape
+	if (node->entity()->is_prefab() && node->entity()->get_prefab_node() != 0)
+		unpack_prefab(node);
+
 	if (!root->remove(node))
 	{
 		fatal("Node not apart of current scene tree!");
@@ -265,6 +382,7 @@ void Scene::remove_node(SceneNodePtr& node)
 	else
 	{
         selectedNode = nullptr;
+        m_journal.record_removal(node->entity()->get_id());
 	}
 }
 
@@ -316,6 +434,34 @@ void Scene::update_node(SceneNodePtr& scene_node, const Transform& parent_transf
 	}
 }
 
+static float screen_size(const Camera& camera, const glm::mat4& transform, float radius)
+{
+    float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+    return camera.get_screen_size(glm::vec3(transform[3]), radius * scale);
+}
+
+// streamed textures only get the mips that the closest draw using them can actually show
+void Scene::request_texture_sizes()
+{
+    for (const RenderObject& object : m_render_list)
+    {
+        const Mesh& mesh = *object.mesh.get_mesh();
+        float size = 0.f;
+
+        if (object.render_command == RenderCommand::InstancedElementDraw)
+        {
+            for (const glm::mat4& instance : instanced_meshes[MeshTable::find(object.mesh.get_mesh())])
+                size = std::max(size, screen_size(*m_camera, instance, mesh.get_bounding_radius()));
+        }
+        else
+        {
+            size = screen_size(*m_camera, object.transform.get_transform(), mesh.get_bounding_radius());
+        }
+
+        object.material.get().request_size(size);
+    }
+}
+
 void Scene::set_background_colour(glm::vec4 colour)
 {
 	m_clear_colour = colour;
@@ -325,17 +471,19 @@ void Scene::set_background_colour(glm::vec4 colour)
 // load the standard shaders
 void Scene::compile_shaders()
 {
+    auto start = std::chrono::high_resolution_clock::now();
+    size_t cache_hits = ProgramCache::get_num_hits();
+
+    FrameUniforms::register_layouts();
+    LightManager::register_layouts();
+    Renderer::register_layouts();
+
     ShaderTable::add("default", ShaderProgram(
             Shader("../resources/shaders/default/default_vertex.shader", ShaderType::Vertex),
             //Shader("../resources/shaders/default/default_geometry.shader", ShaderType::Geometry),
             Shader("../resources/shaders/default/default_fragment.shader", ShaderType::Fragment)
     ), true);
 
-    ShaderTable::add("inst_default", ShaderProgram(
-            Shader("../resources/shaders/default/instanced_vertex.shader", ShaderType::Vertex),
-            Shader("../resources/shaders/default/default_fragment.shader", ShaderType::Fragment)
-    ));
-
     ShaderTable::add("flat_colour", ShaderProgram(
             Shader("../resources/shaders/flat_colour/flat_colour_vertex.shader", ShaderType::Vertex),
             Shader("../resources/shaders/flat_colour/flat_colour_fragment.shader", ShaderType::Fragment)
@@ -361,21 +509,25 @@ void Scene::compile_shaders()
             Shader("../resources/shaders/shadow_map/shadow_map_fragment.shader", ShaderType::Fragment)
     ));
 
-    ShaderTable::add("inst_shadow_map", ShaderProgram(
-            Shader("../resources/shaders/shadow_map/instanced_sm_vertex.shader", ShaderType::Vertex),
-            Shader("../resources/shaders/shadow_map/shadow_map_fragment.shader", ShaderType::Fragment)
+    // draws the default, pbr and blinn-phong materials in one program when the renderer is switched over to it
+    ShaderTable::add("uber", ShaderProgram(
+            Shader("../resources/shaders/default/default_vertex.shader", ShaderType::Vertex),
+            Shader("../resources/shaders/uber/uber_fragment.shader", ShaderType::Fragment)
     ));
 
+    // instanced meshes use these, built now so they are ready with the rest
+    ShaderTable::get("default", { "INSTANCED" });
+    ShaderTable::get("shadow_map", { "INSTANCED" });
+    ShaderTable::get("uber", { "INSTANCED" });
+
     ShaderTable::add("shadow_cubemap", ShaderProgram(
             Shader("../resources/shaders/shadow_map/shadow_cubemap_vertex.shader", ShaderType::Vertex),
             Shader("../resources/shaders/shadow_map/shadow_cubemap_geometry.shader", ShaderType::Geometry),
             Shader("../resources/shaders/shadow_map/shadow_cubemap_fragment.shader", ShaderType::Fragment)
     ));
-}
 
-void Scene::recompile_shaders()
-{
-    ShaderTable::recompile();
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+    info("{} shader programs submitted in {} ms, {} from the program cache\n", ShaderTable::get_num(), elapsed.count(), ProgramCache::get_num_hits() - cache_hits);
 }
 
 
@@ -5,6 +5,7 @@
 #include "Skybox.h"
 #include "SceneNode.h"
 #include "LightManager.h"
+#include "SceneJournal.h"
 #include "components/Fwd.h"
 
 #include <map>
@@ -13,7 +14,7 @@
 #include <glm/vec4.hpp>
 
 class Entity;
-class Buffer;
+class FrameUniforms;
 struct RenderObject;
 
 class Scene
@@ -24,12 +25,21 @@ public:
 
 	void load(const char* scene);
 	void save(const std::string& path);
+
+	// journals whatever changed since the last save, runs on its own every AUTOSAVE_INTERVAL while autosave is on
+	void save_incremental();
+	void set_autosave(bool autosave) { m_autosave = autosave; }
+	[[nodiscard]] bool is_autosave_enabled() const { return m_autosave; }
+	[[nodiscard]] const SceneJournal& get_journal() const { return m_journal; }
 	void init();
 	void update(float elapsed_time);
 	void add_primitive(const char* name);
     void add_model(const char* name);
+
+	// the node and everything under it becomes a prefab named after it, later placements share its data
+	void make_prefab(const SceneNodePtr& node);
+	void place_prefab(const std::string& prefab);
 	void window_resize(int width, int height);
-    static void recompile_shaders();
 
 	void set_background_colour(glm::vec4 colour);
 	[[nodiscard]] const glm::vec4& get_background_colour() const { return m_clear_colour; }
@@ -40,11 +50,16 @@ private:
 	// scene management
 	void update_node(SceneNodePtr& node, const Transform& parent_transform);
 	void remove_node(SceneNodePtr& node);
+	[[nodiscard]] SceneNodePtr find_node(const SceneNodePtr& parent, uint32_t id) const;
+
+	// turns the prefab instance the node belongs to back into ordinary nodes, needed before its structure changes
+	void unpack_prefab(const SceneNodePtr& node);
+    void request_texture_sizes();
 
     Window* m_window_handle;
 	std::shared_ptr<Camera> m_camera;
 	std::unique_ptr<Skybox> m_skybox;
-    std::unique_ptr<Buffer> m_transforms_buffer;
+    std::unique_ptr<FrameUniforms> m_frame_uniforms;
 	SceneNodePtr root;
 	std::queue<SceneNodePtr> m_nodes_to_remove;
 	LightManager m_light_manager;
@@ -57,6 +72,14 @@ private:
     SceneNodePtr selectedNode = nullptr;
     glm::vec4 m_clear_colour = { 0.f, 0.f, 0.f, 1.f};
 
+    SceneJournal m_journal;
+    uint32_t m_next_entity_id = 1;
+    bool m_autosave = false;
+    float m_time_since_save = 0.f;
+    float m_time = 0.f;
+
+    static constexpr float AUTOSAVE_INTERVAL = 5000.f; // ms
+
     friend class Inspector;
     friend class SceneSerializer;
 };
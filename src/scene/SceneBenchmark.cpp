@@ -0,0 +1,236 @@
+#include "pch.h"
+#include "SceneBenchmark.h"
+#include "Scene.h"
+#include "Shader.h"
+#include "Renderer.h"
+#include "GLState.h"
+#include "GLError.h"
+#include "Log.h"
+
+#include <glad/glad.h>
+
+#ifdef PLATFORM_LINUX
+#include <unistd.h>
+#endif
+
+static constexpr int BENCHMARK_FRAMES = 10;
+
+// what the process has resident right now, 0 where that can't be read
+static uint64_t get_resident_bytes()
+{
+#ifdef PLATFORM_LINUX
+    std::ifstream statm("/proc/self/statm");
+    uint64_t total_pages = 0, resident_pages = 0;
+    if (statm >> total_pages >> resident_pages)
+        return resident_pages * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+std::vector<ScaleBenchmarkResult> run_scale_benchmark(Window* window, const std::vector<uint32_t>& sizes, StressSceneSettings settings)
+{
+    using clock = std::chrono::high_resolution_clock;
+    std::vector<ScaleBenchmarkResult> results;
+
+    std::string path = (std::filesystem::temp_directory_path() / "toybox_stress.scene").string();
+
+    for (uint32_t size : sizes)
+    {
+        ScaleBenchmarkResult result;
+        settings.num_nodes = size;
+
+        auto start = clock::now();
+        StressSceneStats stats;
+        if (!write_stress_scene(path, settings, &stats))
+            break;
+
+        result.num_nodes = stats.num_nodes;
+        result.file_size = stats.file_size;
+        result.generate_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        uint64_t resident_before = get_resident_bytes();
+
+        auto* scene = new Scene(window);
+
+        start = clock::now();
+        scene->load(path.c_str());
+        ShaderTable::wait_all();
+        scene->init();
+        GL_CALL(glFinish());
+        result.load_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count();
+
+        // the first frame builds shadow maps and instance buffers so it isn't counted
+        scene->update(16.f);
+        GL_CALL(glFinish());
+
+        start = clock::now();
+        for (int i = 0; i < BENCHMARK_FRAMES; ++i)
+        {
+            scene->update(16.f);
+            GL_CALL(glFinish());
+        }
+        result.update_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count() / BENCHMARK_FRAMES;
+
+        uint64_t resident_after = get_resident_bytes();
+        result.bytes_per_node = (resident_after > resident_before) ? (double)(resident_after - resident_before) / result.num_nodes : 0.0;
+
+        delete scene;
+
+        info("{} nodes: generated in {} ms ({} bytes), loaded in {} ms, {} ms per frame, {} bytes per node\n",
+             result.num_nodes, result.generate_ms, result.file_size, result.load_ms, result.update_ms, result.bytes_per_node);
+
+        results.push_back(result);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    return results;
+}
+
+UniformBenchmarkResult run_uniform_benchmark(uint32_t num_draws)
+{
+    using clock = std::chrono::high_resolution_clock;
+
+    UniformBenchmarkResult result;
+    result.num_draws = num_draws;
+
+    // a program of its own so the scene's programs keep values that match their shadow copies
+    ShaderProgram program(
+            Shader("../resources/shaders/default/default_vertex.shader", ShaderType::Vertex),
+            Shader("../resources/shaders/default/default_fragment.shader", ShaderType::Fragment)
+    );
+    program.wait();
+
+    // stands in for what each draw sets, the models differ so they can't be skipped
+    std::vector<glm::mat4> models(num_draws);
+    for (uint32_t i = 0; i < num_draws; ++i)
+        models[i] = glm::mat4(1.f + (float)i);
+
+    const glm::vec4 colour(0.5f, 0.5f, 0.5f, 1.f);
+
+    auto time_draws = [&](auto&& set_draw)
+    {
+        GL_CALL(glFinish());
+        auto start = clock::now();
+
+        for (uint32_t i = 0; i < num_draws; ++i)
+            set_draw(i);
+
+        GL_CALL(glFinish());
+        return std::chrono::duration<float, std::milli>(clock::now() - start).count();
+    };
+
+    unsigned int program_id = program.get_id();
+
+    // the way the setters used to work
+    std::unordered_map<std::string, int> location_cache;
+    auto old_location = [&](const std::string& name)
+    {
+        auto it = location_cache.find(name);
+        if (it != location_cache.end())
+            return it->second;
+
+        GL_CALL(int location = glGetUniformLocation(program_id, name.c_str()));
+        location_cache[name] = location;
+        return location;
+    };
+
+    result.bind_and_lookup_ms = time_draws([&](uint32_t i)
+    {
+        GL_CALL(glUseProgram(program_id));
+        GL_CALL(glUniformMatrix4fv(old_location("u_model"), 1, GL_FALSE, &models[i][0][0]));
+        GL_CALL(glUseProgram(0));
+        GL_CALL(glUseProgram(program_id));
+        GL_CALL(glUniform1i(old_location("u_using_textures"), 0));
+        GL_CALL(glUseProgram(0));
+        GL_CALL(glUseProgram(program_id));
+        GL_CALL(glUniform4f(old_location("u_base_colour"), colour.x, colour.y, colour.z, colour.w));
+        GL_CALL(glUseProgram(0));
+        GL_CALL(glUseProgram(program_id));
+        GL_CALL(glUniform1f(old_location("u_metallic"), 0.f));
+        GL_CALL(glUseProgram(0));
+    });
+
+    // the raw calls above went around the state cache so it can't trust what it thinks is bound
+    GLState::invalidate();
+
+    // alternating values so the shadow copy never skips anything
+    result.by_name_ms = time_draws([&](uint32_t i)
+    {
+        program.set_uniform_mat4f("u_model", models[i]);
+        program.set_uniform_1i("u_using_textures", (int)(i & 1));
+        program.set_uniform_4f("u_base_colour", colour * (float)(i & 1));
+        program.set_uniform_1f("u_metallic", (float)(i & 1));
+    });
+
+    const Uniform<glm::mat4> u_model("u_model");
+    const Uniform<int> u_using_textures("u_using_textures");
+    const Uniform<glm::vec4> u_base_colour("u_base_colour");
+    const Uniform<float> u_metallic("u_metallic");
+
+    result.handle_ms = time_draws([&](uint32_t i)
+    {
+        program.set_uniform(u_model, models[i]);
+        program.set_uniform(u_using_textures, (int)(i & 1));
+        program.set_uniform(u_base_colour, colour * (float)(i & 1));
+        program.set_uniform(u_metallic, (float)(i & 1));
+    });
+
+    result.handle_unchanged_ms = time_draws([&](uint32_t)
+    {
+        program.set_uniform(u_model, models[0]);
+        program.set_uniform(u_using_textures, 0);
+        program.set_uniform(u_base_colour, colour);
+        program.set_uniform(u_metallic, 0.f);
+    });
+
+    info("Uniforms for {} draws: bind and lookup {} ms, by name {} ms, handles {} ms, unchanged handles {} ms\n",
+         num_draws, result.bind_and_lookup_ms, result.by_name_ms, result.handle_ms, result.handle_unchanged_ms);
+
+    return result;
+}
+
+UberShaderBenchmarkResult run_uber_shader_benchmark(Scene& scene)
+{
+    using clock = std::chrono::high_resolution_clock;
+
+    UberShaderBenchmarkResult result;
+    bool was_using_uber_shader = Renderer::is_using_uber_shader();
+
+    // both paths need every program linked or draws get skipped
+    ShaderTable::wait_all();
+
+    auto time_frames = [&](bool uber_shader, float& frame_ms, size_t& program_switches)
+    {
+        Renderer::set_uber_shader(uber_shader);
+
+        // the first frame fills the materials buffer so it isn't counted
+        scene.update(16.f);
+        GL_CALL(glFinish());
+
+        program_switches = 0;
+        auto start = clock::now();
+        for (int i = 0; i < BENCHMARK_FRAMES; ++i)
+        {
+            GLState::end_frame();
+            scene.update(16.f);
+            GL_CALL(glFinish());
+            GLState::end_frame();
+            program_switches += GLState::get_num_program_switches();
+        }
+
+        frame_ms = std::chrono::duration<float, std::milli>(clock::now() - start).count() / BENCHMARK_FRAMES;
+        program_switches /= BENCHMARK_FRAMES;
+    };
+
+    time_frames(false, result.specialised_ms, result.specialised_switches);
+    time_frames(true, result.uber_ms, result.uber_switches);
+
+    Renderer::set_uber_shader(was_using_uber_shader);
+
+    info("Specialised programs {} ms per frame with {} program switches, uber program {} ms per frame with {} program switches\n",
+         result.specialised_ms, result.specialised_switches, result.uber_ms, result.uber_switches);
+
+    return result;
+}
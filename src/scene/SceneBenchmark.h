@@ -0,0 +1,48 @@
+#pragma once
+
+#include "SceneGenerator.h"
+
+#include <cstdint>
+#include <vector>
+
+class Window;
+class Scene;
+
+struct ScaleBenchmarkResult
+{
+    uint32_t num_nodes = 0;
+    uint64_t file_size = 0;
+    float generate_ms = 0.f;
+    float load_ms = 0.f;     // parsing plus init, the way switching to the scene would
+    float update_ms = 0.f;   // average frame once the first one is out of the way, waits for the gpu
+    double bytes_per_node = 0.0; // growth in resident memory while the scene is loaded
+};
+
+// generates a stress scene of every size in turn, then loads and updates it like the editor would
+// scenes share the global asset tables, so whatever scene was open has to be deleted before this runs
+std::vector<ScaleBenchmarkResult> run_scale_benchmark(Window* window, const std::vector<uint32_t>& sizes, StressSceneSettings settings);
+
+struct UniformBenchmarkResult
+{
+    uint32_t num_draws = 0;
+    // milliseconds to set the per draw uniforms of every draw
+    float bind_and_lookup_ms = 0.f; // binding the program around each set and looking the location up by name
+    float by_name_ms = 0.f;
+    float handle_ms = 0.f;
+    float handle_unchanged_ms = 0.f; // same values every draw so the shadow copy skips them
+};
+
+// times the per draw uniform updates on their own, without the draws, against a copy of the default shader
+UniformBenchmarkResult run_uniform_benchmark(uint32_t num_draws);
+
+struct UberShaderBenchmarkResult
+{
+    // average frame with the gpu waited on, and program switches per frame, shadow passes included
+    float specialised_ms = 0.f;
+    float uber_ms = 0.f;
+    size_t specialised_switches = 0;
+    size_t uber_switches = 0;
+};
+
+// renders the scene with each material's own program and then with the uber program, leaving the setting as it was
+UberShaderBenchmarkResult run_uber_shader_benchmark(Scene& scene);
@@ -0,0 +1,146 @@
+#include "pch.h"
+#include "SceneJournal.h"
+#include "SceneData.h"
+#include "FileSystem.h"
+#include "ThreadPool.h"
+#include "Log.h"
+
+// adds the whole of source to the end of destination, starting on a new line
+static bool append_to_file(const std::string& source, const std::string& destination)
+{
+    std::string records;
+    std::string existing;
+    if (!FileSystem::read(source, records) || !FileSystem::read(destination, existing))
+        return false;
+
+    std::ofstream out(destination, std::ios::app | std::ios::binary);
+    if (!existing.empty() && existing.back() != '\n')
+        out.put('\n');
+
+    out.write(records.data(), (std::streamsize)records.size());
+    out.flush();
+    return out.good();
+}
+
+SceneJournal::~SceneJournal()
+{
+    wait_for_compaction();
+}
+
+void SceneJournal::set_scene_path(const std::string& scene_path)
+{
+    wait_for_compaction();
+
+    m_scene_path = scene_path;
+    m_enabled = !scene_path.empty() && std::filesystem::path(scene_path).extension() != ".tbscene";
+    m_removed.clear();
+    m_prefabs.clear();
+    m_settings.clear();
+
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(scene_journal_path(scene_path), ec);
+    m_journal_size = ec ? 0 : size;
+}
+
+void SceneJournal::discard()
+{
+    wait_for_compaction();
+
+    std::error_code ec;
+    std::filesystem::remove(scene_journal_path(m_scene_path), ec);
+    std::filesystem::remove(compacting_path(m_scene_path), ec);
+
+    m_removed.clear();
+    m_prefabs.clear();
+    m_journal_size = 0;
+}
+
+bool SceneJournal::settings_changed(const std::string& settings)
+{
+    if (settings == m_settings)
+        return false;
+
+    m_settings = settings;
+    return true;
+}
+
+bool SceneJournal::append(const std::string& records)
+{
+    if (!m_enabled)
+        return false;
+
+    if (records.empty())
+        return true;
+
+    std::string journal_path = scene_journal_path(m_scene_path);
+    {
+        std::ofstream out(journal_path, std::ios::app | std::ios::binary);
+        out.write(records.data(), (std::streamsize)records.size());
+        out.flush();
+
+        if (!out.good())
+        {
+            error("Could not write to {}\n", journal_path);
+            return false;
+        }
+    }
+
+    m_journal_size += records.size();
+
+    // the last compaction is still going, the journal just keeps growing until it's done
+    if (m_journal_size < COMPACT_SIZE || (m_compaction.valid() && m_compaction.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+        return true;
+
+    if (m_compaction.valid() && !m_compaction.get())
+        warn("Could not fold the journal into {}\n", m_scene_path);
+
+    // renamed out of the way so new records can keep going into a fresh journal while the worker folds this one
+    // a compaction that failed leaves its file behind, the journal goes on the end of it so none of those records are lost
+    std::string compacting = compacting_path(m_scene_path);
+    std::error_code ec;
+    if (std::filesystem::exists(compacting, ec))
+    {
+        if (!append_to_file(journal_path, compacting))
+        {
+            error("Could not move the journal into {}\n", compacting);
+            return true;
+        }
+
+        std::filesystem::remove(journal_path, ec);
+    }
+    else
+    {
+        std::filesystem::rename(journal_path, compacting, ec);
+        if (ec)
+            return true;
+    }
+
+    m_journal_size = 0;
+    ++m_num_compactions;
+
+    std::string scene_path = m_scene_path;
+    m_compaction = ThreadPool::get().submit([scene_path, compacting]()
+    {
+        return fold_scene_journal(scene_path, compacting);
+    });
+
+    return true;
+}
+
+void SceneJournal::fold_pending(const std::string& scene_path)
+{
+    // an interrupted compaction holds older records than the journal so it goes first
+    if (!fold_scene_journal(scene_path, compacting_path(scene_path)) || !fold_scene_journal(scene_path, scene_journal_path(scene_path)))
+        warn("Could not fold the journal into {}, the last autosaved changes are missing\n", scene_path);
+}
+
+void SceneJournal::wait_for_compaction()
+{
+    if (m_compaction.valid() && !m_compaction.get())
+        warn("Could not fold the journal into {}\n", m_scene_path);
+}
+
+std::string SceneJournal::compacting_path(const std::string& scene_path)
+{
+    return scene_journal_path(scene_path) + ".compacting";
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+// the editor side of incremental saves, records go to <scene>.journal and get folded back into the scene
+// on a worker once the journal is big enough, only json scenes are journaled
+class SceneJournal
+{
+public:
+    ~SceneJournal();
+
+    // waits for a running compaction so it never races a full save of the same file
+    void set_scene_path(const std::string& scene_path);
+    [[nodiscard]] const std::string& get_scene_path() const { return m_scene_path; }
+    [[nodiscard]] bool is_enabled() const { return m_enabled; }
+
+    // a full save was just written, anything still in the journal is stale
+    void discard();
+
+    void record_removal(uint32_t id) { m_removed.push_back(id); }
+    [[nodiscard]] std::vector<uint32_t> take_removals() { return std::move(m_removed); }
+
+    // prefabs made since the last save, their definitions go in before anything that places them
+    void record_prefab(const std::string& name) { m_prefabs.push_back(name); }
+    [[nodiscard]] std::vector<std::string> take_prefabs() { return std::move(m_prefabs); }
+
+    // true the first time the camera, background or skybox differ from what was last saved
+    bool settings_changed(const std::string& settings);
+
+    // appends the records, one per line, and starts a compaction once the journal has grown past the limit
+    bool append(const std::string& records);
+
+    void set_last_save_time(float ms) { m_last_save_ms = ms; }
+    [[nodiscard]] float get_last_save_time() const { return m_last_save_ms; }
+    [[nodiscard]] uint64_t get_journal_size() const { return m_journal_size; }
+    [[nodiscard]] size_t get_num_compactions() const { return m_num_compactions; }
+
+    // folds anything an earlier session left behind into the scene before it gets loaded
+    static void fold_pending(const std::string& scene_path);
+
+    // where a journal is moved while a worker folds it
+    [[nodiscard]] static std::string compacting_path(const std::string& scene_path);
+
+    static constexpr uint64_t COMPACT_SIZE = 1024 * 1024;
+
+private:
+    void wait_for_compaction();
+
+    std::string m_scene_path;
+    bool m_enabled = false;
+    std::vector<uint32_t> m_removed;
+    std::vector<std::string> m_prefabs;
+    std::string m_settings;
+    std::future<bool> m_compaction;
+
+    uint64_t m_journal_size = 0;
+    size_t m_num_compactions = 0;
+    float m_last_save_ms = 0.f;
+};
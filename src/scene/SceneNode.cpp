@@ -46,7 +46,7 @@ void SceneNode::move_child(const SceneNodePtr& s)
 
 void SceneNode::update_transform(const SceneNodePtr& s)
 {
-    auto& child_transform = s->m_entity->get_component<Transform>();
+    auto& child_transform = s->m_entity->edit_component<Transform>();
     Transform child_copy = child_transform; // needed to convert the nodes transform back to world space
 
     std::stack<Transform> transforms_to_apply;
@@ -77,13 +77,15 @@ void SceneNode::update_transform(const SceneNodePtr& s)
     Transform new_parent_transform = (m_entity) ? get_relative_transform(parent2) : Transform{};
 
     child_transform.resolve_parent_change(old_parent_transform, new_parent_transform);
+    s->m_entity->mark_dirty();
     
     std::function<void (SceneNodePtr&, Transform, Transform)> update_children = [&](SceneNodePtr& child, const Transform& _old_parent_transform, const Transform& _new_parent_transform)
     {
-        auto& _child_transform = child->m_entity->get_component<Transform>();
+        auto& _child_transform = child->m_entity->edit_component<Transform>();
         Transform _child_copy = _child_transform;
 
         _child_transform.resolve_parent_change(_old_parent_transform, _new_parent_transform);
+        child->m_entity->mark_dirty();
 
         for(auto& c : child->m_children)
         {
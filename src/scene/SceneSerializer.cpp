@@ -1,6 +1,7 @@
 #include "SceneSerializer.h"
 #include "ModelLoader.h"
 #include "FileOperations.h"
+#include "FileSystem.h"
 #include "Entity.h"
 #include "Camera.h"
 #include "Skybox.h"
@@ -11,19 +12,229 @@
 #include "components/Light.h"
 #include "components/MeshComponent.h"
 #include "renderer/Material.h"
+#include "renderer/AsyncLoader.h"
+#include "AssetCache.h"
+#include "Hash.h"
+#include "SceneData.h"
+#include "SceneJournal.h"
+#include "Prefab.h"
+#include "Log.h"
 
 #include <nlohmann/json.hpp>
+#include <spdlog/fmt/bundled/format.h>
 
 using namespace nlohmann;
 
+// builds the top level of a scene as usual but hands every entry of "models" over as soon as it is complete
+// so only one model is ever held as json instead of the whole file
+class SceneStreamParser : public json_sax<json>
+{
+public:
+    explicit SceneStreamParser(std::function<void(json&)>&& on_model) : m_on_model(std::move(on_model)) {}
+
+    [[nodiscard]] json& get_root() { return m_root; }
+    [[nodiscard]] const std::string& get_error() const { return m_error; }
+
+    bool null() override { return add_value(nullptr); }
+    bool boolean(bool val) override { return add_value(val); }
+    bool number_integer(number_integer_t val) override { return add_value(val); }
+    bool number_unsigned(number_unsigned_t val) override { return add_value(val); }
+    bool number_float(number_float_t val, const string_t&) override { return add_value(val); }
+    bool string(string_t& val) override { return add_value(std::move(val)); }
+    bool binary(binary_t& val) override { return add_value(json::binary(std::move(val))); }
+
+    bool key(string_t& val) override
+    {
+        m_key = std::move(val);
+        return true;
+    }
+
+    bool start_object(std::size_t) override
+    {
+        // a new model starts directly inside the models array
+        if (m_in_models && m_stack.size() == m_models_depth)
+        {
+            m_model = json::object();
+            m_stack.push_back(&m_model);
+            return true;
+        }
+
+        return push(json::object());
+    }
+
+    bool end_object() override
+    {
+        m_stack.pop_back();
+
+        if (m_in_models && m_stack.size() == m_models_depth)
+        {
+            m_on_model(m_model);
+            m_model = nullptr;
+        }
+
+        return true;
+    }
+
+    bool start_array(std::size_t) override
+    {
+        // the models array itself never gets built
+        if (!m_in_models && m_stack.size() == 1 && m_key == "models")
+        {
+            m_in_models = true;
+            m_models_depth = m_stack.size();
+            return true;
+        }
+
+        return push(json::array());
+    }
+
+    bool end_array() override
+    {
+        if (m_in_models && m_stack.size() == m_models_depth)
+        {
+            m_in_models = false;
+            return true;
+        }
+
+        m_stack.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&, const detail::exception& ex) override
+    {
+        m_error = ex.what();
+        return false;
+    }
+
+private:
+    json* insert(json&& value)
+    {
+        if (m_stack.empty())
+        {
+            m_root = std::move(value);
+            return &m_root;
+        }
+
+        json& parent = *m_stack.back();
+        if (parent.is_object())
+            return &(parent[m_key] = std::move(value));
+
+        parent.push_back(std::move(value));
+        return &parent.back();
+    }
+
+    bool add_value(json&& value)
+    {
+        // anything else sitting directly in the models array isn't a model
+        if (m_in_models && m_stack.size() == m_models_depth)
+            return true;
+
+        insert(std::move(value));
+        return true;
+    }
+
+    bool push(json&& value)
+    {
+        m_stack.push_back(insert(std::move(value)));
+        return true;
+    }
+
+    std::function<void(json&)> m_on_model;
+    json m_root;
+    json m_model;
+    std::vector<json*> m_stack;
+    std::string m_key;
+    std::string m_error;
+    bool m_in_models = false;
+    size_t m_models_depth = 0;
+};
+
+// the manifest keeps the hash of the json a scene was cooked from, write times mean nothing once either side is packed
+static bool is_cooked_scene_current(const std::string& scene_path)
+{
+    std::error_code ec;
+
+    // a journal that couldn't be folded still holds changes the cooked scene doesn't have
+    if (std::filesystem::exists(scene_journal_path(scene_path), ec) || std::filesystem::exists(SceneJournal::compacting_path(scene_path), ec))
+        return false;
+
+    uint64_t cooked_hash = AssetCache::find_hash(scene_path);
+    return cooked_hash != 0 && cooked_hash == hash_file(scene_path);
+}
+
 void SceneSerializer::open(const char* scene_name, Scene& scene, std::shared_ptr<Camera>& camera, std::unique_ptr<Skybox>& sky_box, SceneNodePtr root)
 {
 	if (!strcmp(scene_name, ""))
 		return;
 
-	std::string src = file_to_string(scene_name);
+    SceneView view;
+    if (is_binary_scene(scene_name) && view.open(scene_name))
+    {
+        load_binary(view, scene, camera, sky_box, root);
+
+        // there's no json source to fold a journal into, binary scenes are only kept by full saves
+        scene.m_journal.set_scene_path({});
+        return;
+    }
+
+    SceneJournal::fold_pending(scene_name);
+
+    // a cooked binary version skips json parsing altogether, prefab definitions don't survive cooking so those scenes still need the json
+    std::string cooked_path = AssetCache::find(scene_name);
+    if (!cooked_path.empty() && is_cooked_scene_current(scene_name) && view.open(cooked_path) && !(view.header().flags & SCENE_FLAG_PREFABS))
+    {
+        load_binary(view, scene, camera, sky_box, root);
+        scene.m_journal.set_scene_path(scene_name);
+        return;
+    }
+
+    // mapped so the parser reads straight out of the page cache
+    FileView scene_file = FileSystem::map(scene_name);
+    if (!scene_file)
+    {
+        error("Could not open scene {}\n", scene_name);
+        return;
+    }
+
+    // children come after their parent in the file so each node knows where it goes by the time it is parsed
+    std::unordered_map<int, SceneNodePtr> parents;
+    std::vector<std::pair<SceneNodePtr, json>> placed_prefabs;
+    int model_index = 0;
+
+    SceneStreamParser parser([&](json& model)
+    {
+        SceneNodePtr node = load_entity(model, model_index, scene);
+
+        auto parent = parents.extract(model_index);
+        (parent.empty() ? root : parent.mapped())->add_child(node);
+
+        int num_children = model.value("child_count", 0);
+        for (int i = 0; i < num_children; ++i)
+            parents[model["children"][i].get<int>()] = node;
+
+        if (model.contains("prefab"))
+            placed_prefabs.emplace_back(node, std::move(model));
+
+        ++model_index;
+    });
+
+    if (!json::sax_parse(scene_file.begin(), scene_file.end(), &parser))
+    {
+        error("Could not parse scene {}: {}\n", scene_name, parser.get_error());
+        return;
+    }
 
-	json w_json = json::parse(src);                                            
+	json& w_json = parser.get_root();
+
+	// prefab definitions come after the models, so placed ones are only filled in once the whole file has been read
+	if (w_json["prefabs"].is_object())
+	{
+		for (auto& [name, nodes] : w_json["prefabs"].items())
+			PrefabTable::add(name, std::move(nodes));
+	}
+
+	for (auto& [node, instance] : placed_prefabs)
+		instantiate_prefab(node, instance, scene);
 
 	json camera_accessor = w_json["camera"];
 	json camera_pos = camera_accessor["position"];
@@ -40,13 +251,72 @@ void SceneSerializer::open(const char* scene_name, Scene& scene, std::shared_ptr
     if(!w_json["skybox"].is_null())
         load_skybox(w_json["skybox"], sky_box);
 
-	json models = w_json["models"];
-	unsigned int model_count = w_json["model_count"];
-
-	load_models(models, model_count, root, scene);
+    scene.m_journal.set_scene_path(scene_name);
 }
 
 void SceneSerializer::save(const char* scene_name, const Scene& scene, const std::shared_ptr<Camera>& camera, const std::unique_ptr<Skybox>& sky_box, const SceneNodePtr& root)
+{
+	json res_json = serialize_settings(scene, camera, sky_box);
+
+	int node_index = -1; // keeps track of nodes (left to right and depth first)
+	for (const auto& scene_node : *root)
+	{
+		++node_index;
+		serialize_node(res_json["models"], node_index, scene_node);
+	}
+
+	res_json["model_count"] = node_index + 1;
+
+	for (const auto& [name, prefab] : PrefabTable::get_prefabs())
+		res_json["prefabs"][name] = prefab->nodes;
+
+    if (std::filesystem::path(scene_name).extension() == ".tbscene")
+    {
+        std::vector<unsigned char> bytes;
+        if (!scene_json_to_binary(res_json, bytes) || !write_binary_scene(scene_name, bytes))
+            error("Could not save binary scene {}\n", scene_name);
+
+        return;
+    }
+
+	overwrite_file(scene_name, res_json.dump());
+}
+
+bool SceneSerializer::save_incremental(Scene& scene)
+{
+    SceneJournal& journal = scene.m_journal;
+    if (!journal.is_enabled())
+        return false;
+
+    std::string records;
+
+    // definitions go in before anything that could place them
+    for (const std::string& name : journal.take_prefabs())
+    {
+        if (auto prefab = PrefabTable::get(name))
+            records += json{ { "op", "prefab" }, { "name", name }, { "nodes", prefab->nodes } }.dump() + "\n";
+    }
+
+    // removals go first, a node that moved under a removed one goes away with it either way
+    for (uint32_t id : journal.take_removals())
+        records += json{ { "op", "remove" }, { "id", id } }.dump() + "\n";
+
+    json settings = serialize_settings(scene, scene.m_camera, scene.m_skybox);
+    if (!settings.contains("skybox"))
+        settings["skybox"] = nullptr;
+
+    if (journal.settings_changed(settings.dump()))
+    {
+        settings["op"] = "scene";
+        records += settings.dump() + "\n";
+    }
+
+    append_dirty_nodes(records, scene.root, 0);
+
+    return journal.append(records);
+}
+
+json SceneSerializer::serialize_settings(const Scene& scene, const std::shared_ptr<Camera>& camera, const std::unique_ptr<Skybox>& sky_box)
 {
 	json res_json;
 
@@ -72,35 +342,48 @@ void SceneSerializer::save(const char* scene_name, const Scene& scene, const std
 	res_json["background_colour"][2] = bg_col.z;
 	res_json["background_colour"][3] = bg_col.w;
 
-	int node_index = -1; // keeps track of nodes (left to right and depth first)
-	for (const auto& scene_node : *root)
-	{
-		++node_index;
-		serialize_node(res_json["models"], node_index, scene_node);
-	}
-
-	res_json["model_count"] = node_index + 1;
-
-	overwrite_file(scene_name, res_json.dump());
+	return res_json;
 }
 
-void SceneSerializer::serialize_node(json& accessor, int& node_index, const SceneNodePtr& scene_node)
+void SceneSerializer::serialize_entity(json& accessor, const SceneNodePtr& scene_node)
 {
-	accessor[node_index]["name"] = scene_node->entity()->get_name();
+	accessor["name"] = scene_node->entity()->get_name();
+	accessor["id"] = scene_node->entity()->get_id();
 
 	if (scene_node->entity()->has_component<Material>())
 	{
 		auto& material = scene_node->entity()->get_component<Material>();
-		accessor[node_index]["shader"] = ShaderTable::find(material.get_shader());
+		accessor["shader"] = ShaderTable::find(material.get_shader());
 	}
 
 	const auto& components = scene_node->entity()->get_components();
 
 	for (const auto& c : components)
 	{
-		c->serialize(accessor[node_index]);
+		c->serialize(accessor);
 	}
 
+	// whatever was just written is what's on disk now
+	scene_node->entity()->clear_dirty();
+}
+
+void SceneSerializer::serialize_node(json& accessor, int& node_index, const SceneNodePtr& scene_node)
+{
+	// a placed prefab is saved as a reference plus whatever it overrides
+	if (scene_node->entity()->is_prefab() && scene_node->entity()->get_prefab_node() == 0)
+	{
+		std::vector<SceneNodePtr> instance_nodes;
+		if (collect_instance(scene_node, instance_nodes))
+		{
+			serialize_instance(accessor[node_index], instance_nodes);
+			return;
+		}
+
+		warn("{} no longer matches prefab {}, saving it in full\n", scene_node->entity()->get_name(), scene_node->entity()->get_prefab());
+	}
+
+	serialize_entity(accessor[node_index], scene_node);
+
 	if (scene_node->has_children())
 	{
 		int ch_ind = 0; // keeps track of index of child array
@@ -110,35 +393,78 @@ void SceneSerializer::serialize_node(json& accessor, int& node_index, const Scen
 			accessor[parent_index]["children"][ch_ind++] = ++node_index;
 			serialize_node(accessor, node_index, child);
 		}
-		accessor[parent_index]["child_count"] = scene_node->size();
+		accessor[parent_index]["child_count"] = ch_ind;
 	}
 }
 
-void SceneSerializer::load_skybox(const json& accessor, std::unique_ptr<Skybox>& sky_box)
+void SceneSerializer::append_dirty_nodes(std::string& records, const SceneNodePtr& parent, uint32_t parent_id)
 {
-    sky_box = std::make_unique<Skybox>(accessor["path"], accessor["image_format"]);
+	// parents are written before their children so they exist by the time the children are replayed
+	uint32_t index = 0;
+	for (const auto& child : *parent)
+	{
+		// the whole instance is one record, a change anywhere inside it rewrites its overrides
+		std::vector<SceneNodePtr> instance_nodes;
+		if (child->entity()->is_prefab() && child->entity()->get_prefab_node() == 0 && collect_instance(child, instance_nodes))
+		{
+			if (std::any_of(instance_nodes.begin(), instance_nodes.end(), [](const SceneNodePtr& node) { return node->entity()->is_dirty(); }))
+			{
+				json record;
+				record["op"] = "set";
+				record["id"] = child->entity()->get_id();
+				record["parent"] = parent_id;
+				record["index"] = index;
+				serialize_instance(record["node"], instance_nodes);
+
+				records += record.dump() + "\n";
+			}
+
+			++index;
+			continue;
+		}
+
+		if (child->entity()->is_dirty())
+		{
+			json record;
+			record["op"] = "set";
+			record["id"] = child->entity()->get_id();
+			record["parent"] = parent_id;
+			record["index"] = index;
+			serialize_entity(record["node"], child);
+
+			records += record.dump() + "\n";
+		}
+
+		append_dirty_nodes(records, child, child->entity()->get_id());
+		++index;
+	}
 }
 
-void SceneSerializer::load_models(const json& accessor, unsigned int model_count, SceneNodePtr& root, Scene& scene)
+void SceneSerializer::load_skybox(const json& accessor, std::unique_ptr<Skybox>& sky_box)
 {
-	int num_models_checked = 0;
-	while (num_models_checked < model_count)
-	{
-        root->add_child(load_model(accessor, num_models_checked, num_models_checked, scene));
-	}
+    sky_box = std::make_unique<Skybox>(accessor["path"], accessor["image_format"]);
 }
 
-// TODO: Make this look less ugly
-SceneNodePtr SceneSerializer::load_model(const json& accessor, int model_index, int& num_models_checked, Scene& scene)
+SceneNodePtr SceneSerializer::load_entity(json& model, size_t index, Scene& scene)
 {
 	Entity entity;
 
-	json model = accessor[model_index];
-
     entity.set_name(model.value("name", "no_name"));
+    entity.set_id(scene_node_id(model, index));
+    scene.m_next_entity_id = std::max(scene.m_next_entity_id, entity.get_id() + 1);
+
+    // placed prefabs are filled in once the prefab definitions have been read
+    if (!model.contains("prefab"))
+        load_components(entity, model, &scene, {});
+
+    entity.clear_dirty();
+	return std::make_shared<SceneNode>(std::make_unique<Entity>(std::move(entity)));
+}
 
+void SceneSerializer::load_components(Entity& entity, const json& model, Scene* scene, const std::string& material_name, uint32_t components)
+{
 	Transform transform{};
-	json info = model["transform"];
+	const json& info = model["transform"];
 
 	json translation = info["translate"];
     transform.translate(glm::vec3({ translation[0], translation[1], translation[2] }));
@@ -151,9 +477,12 @@ SceneNodePtr SceneSerializer::load_model(const json& accessor, int model_index,
     transform.recalculate_transform();
     glm::mat4 model_matrix = transform.get_transform();
     glm::vec3 position = transform.get_position();
-    entity.add_component(std::move(transform));
 
-	if (!model["light"].is_null())
+	// lights and instanced meshes still need the placement when the transform itself is shared
+	if (components & LOAD_TRANSFORM)
+		entity.add_component(std::move(transform));
+
+	if ((components & LOAD_LIGHT) && model.contains("light") && !model["light"].is_null())
 	{
 		std::string type = model["light"]["type"];
 
@@ -166,6 +495,10 @@ SceneNodePtr SceneSerializer::load_model(const json& accessor, int model_index,
 			pl.set_range(model["light"]["range"]);
 			pl.set_brightness(model["light"]["brightness"]);
 
+            // the shadow map is made the first time the light gets updated
+            if (model["light"].value("cast_shadow", false))
+                pl.cast_shadow();
+
             entity.add_component(std::move(pl));
 		}
 		else if (type == "directional_light")
@@ -183,115 +516,508 @@ SceneNodePtr SceneSerializer::load_model(const json& accessor, int model_index,
             if(model["light"]["cast_shadow"])
             {
                 dl.cast_shadow();
-                dl.shadow_init(position);
+
+                // prefab templates are never drawn so they don't get a shadow map
+                if (scene)
+                    dl.shadow_init(position);
             }
 
             entity.add_component(std::move(dl));
 		}
 	}
 
-    if(!model["mesh"].is_null())
+    if(model.contains("mesh") && !model["mesh"].is_null())
     {
-        MeshComponent mesh_component;
-
-        json mesh_accessor = model["mesh"];
+        const json& mesh_accessor = model["mesh"];
 
-        mesh_component.m_mesh_type = mesh_accessor["mesh_type"];
         std::string mesh_name = mesh_accessor["mesh_name"];
+        bool instanced = mesh_accessor["instanced"];
+
+        if (components & LOAD_MESH)
+        {
+            MeshComponent mesh_component;
+            mesh_component.m_mesh_type = mesh_accessor["mesh_type"];
+            mesh_component.m_use_scale_outline = mesh_accessor["use_scale_outline"];
+            mesh_component.m_outlining_factor = mesh_accessor["outlining_factor"];
 
-        if(!MeshTable::exists(mesh_name))
+            add_mesh(entity, std::move(mesh_component), mesh_name, instanced, model_matrix, scene);
+        }
+
+        if((components & LOAD_MATERIAL) && model.contains("material") && !model["material"].is_null())
         {
-            Mesh mesh;
+            const json& material_accessor = model["material"];
+            const json& properties = material_accessor["properties"];
+
+            std::string textures[] = {
+                    material_accessor["textures"]["base_colour"],
+                    material_accessor["textures"]["specular"],
+                    material_accessor["textures"]["normal_map"],
+                    material_accessor["textures"]["occlusion"]
+            };
+
+            MaterialInfo info;
+            info.texturing_mode = (TexturingMode)material_accessor["texturing_mode"];
+            info.colour = { properties["colour"][0], properties["colour"][1], properties["colour"][2], properties["colour"][3] };
+            info.metallic = properties["metallic_property"];
+            info.roughness = properties["roughness"];
+            info.shader = material_accessor["shader"];
+            info.textures = textures;
+
+            add_material(entity, info, mesh_name, instanced, material_name);
+        }
+    }
+}
 
-            if ((mesh_accessor["mesh_type"] == "primitive"))
+// materials of prefab nodes are shared by every instance that doesn't override them
+static std::string prefab_material_name(const std::string& prefab, uint32_t node)
+{
+    return fmt::format("{}/{}", prefab, node);
+}
+
+// hands the entity the template's own copy of every component the instance leaves alone
+// lights and instanced meshes carry per instance state so they are never shared
+static void share_template_components(Entity& entity, Entity& source, const json& delta, bool top, bool instanced)
+{
+    for (const auto& component : source.get_components())
+    {
+        size_t type = component->get_type();
+
+        bool shared = (type == typeid(Transform).hash_code() && !top && !delta.contains("transform")) ||
+                      (type == typeid(MeshComponent).hash_code() && !instanced && !delta.contains("mesh")) ||
+                      (type == typeid(MaterialComponent).hash_code() && !delta.contains("material"));
+
+        if (shared)
+            entity.replace_component(component);
+    }
+}
+
+void SceneSerializer::build_prefab_templates(const std::string& name, Prefab& prefab)
+{
+    for (uint32_t i = 0; i < prefab.nodes.size(); ++i)
+    {
+        json model = prefab.nodes[i];
+
+        Entity entity;
+        entity.set_name(model.value("name", "no_name"));
+        load_components(entity, model, nullptr, prefab_material_name(name, i));
+
+        prefab.templates.push_back(std::make_shared<Entity>(std::move(entity)));
+    }
+}
+
+void SceneSerializer::instantiate_prefab(const SceneNodePtr& top, const json& instance, Scene& scene)
+{
+    std::string name = instance.value("prefab", "");
+    std::shared_ptr<Prefab> prefab = PrefabTable::get(name);
+    if (!prefab)
+    {
+        warn("Scene places missing prefab {}\n", name);
+        return;
+    }
+
+    if (prefab->templates.empty())
+        build_prefab_templates(name, *prefab);
+
+    const json overrides = instance.value("overrides", json::object());
+    uint32_t instance_id = top->entity()->get_id();
+
+    std::vector<SceneNodePtr> nodes(prefab->nodes.size());
+    nodes[0] = top;
+
+    for (uint32_t i = 0; i < prefab->nodes.size(); ++i)
+    {
+        std::string key = std::to_string(i);
+        const json delta = overrides.contains(key) ? overrides[key] : json::object();
+
+        // untouched nodes are read straight out of the definition
+        bool patched = !delta.empty() || (i == 0 && instance.contains("transform"));
+        json patched_model;
+        if (patched)
+        {
+            patched_model = prefab->nodes[i];
+            patched_model.merge_patch(delta);
+
+            if (i == 0 && instance.contains("transform"))
+                patched_model["transform"] = instance["transform"];
+        }
+        const json& model = patched ? patched_model : prefab->nodes[i];
+
+        if (i != 0)
+        {
+            // parents always come first in a prefab
+            nodes[i] = std::make_shared<SceneNode>(std::make_shared<Entity>());
+            nodes[i]->entity()->set_name(model.value("name", "no_name"));
+            nodes[i]->entity()->set_id(scene.m_next_entity_id++);
+            nodes[prefab->parents[i]]->add_child(nodes[i]);
+        }
+
+        Entity& entity = *nodes[i]->entity();
+
+        // an overridden material gets one of its own, everything else resolves to the template's
+        std::string material_name = prefab_material_name(name, i);
+        if (delta.contains("material"))
+            material_name += fmt::format("#{}", instance_id);
+
+        bool instanced = model.contains("mesh") && model["mesh"].is_object() && model["mesh"].value("instanced", false);
+
+        // only what the instance overrides or owns gets built, the rest comes from the template
+        uint32_t components = LOAD_LIGHT;
+        if (i == 0 || delta.contains("transform"))
+            components |= LOAD_TRANSFORM;
+        if (instanced || delta.contains("mesh"))
+            components |= LOAD_MESH;
+        if (delta.contains("material"))
+            components |= LOAD_MATERIAL;
+
+        load_components(entity, model, &scene, material_name, components);
+        share_template_components(entity, *prefab->templates[i], delta, i == 0, instanced);
+
+        entity.set_prefab(name, i, instance_id, prefab->templates[i]);
+        entity.clear_dirty();
+    }
+}
+
+bool SceneSerializer::collect_instance(const SceneNodePtr& top, std::vector<SceneNodePtr>& nodes)
+{
+    std::shared_ptr<Prefab> prefab = PrefabTable::get(top->entity()->get_prefab());
+    if (!prefab)
+        return false;
+
+    uint32_t instance_id = top->entity()->get_id();
+
+    // every node has to still be the prefab node it started out as, in the same order
+    std::function<bool(const SceneNodePtr&)> collect = [&](const SceneNodePtr& node)
+    {
+        const Entity& entity = *node->entity();
+        if (!entity.is_prefab() || entity.get_prefab_instance() != instance_id || entity.get_prefab_node() != nodes.size())
+            return false;
+
+        nodes.push_back(node);
+
+        return std::all_of(node->begin(), node->end(), collect);
+    };
+
+    return collect(top) && nodes.size() == prefab->nodes.size();
+}
+
+void SceneSerializer::serialize_instance(json& accessor, const std::vector<SceneNodePtr>& nodes)
+{
+    const std::shared_ptr<Entity>& top = nodes[0]->entity();
+    std::shared_ptr<Prefab> prefab = PrefabTable::get(top->get_prefab());
+
+    accessor["name"] = top->get_name();
+    accessor["id"] = top->get_id();
+    accessor["prefab"] = top->get_prefab();
+
+    json overrides = json::object();
+
+    for (const auto& node : nodes)
+    {
+        uint32_t i = node->entity()->get_prefab_node();
+
+        json data;
+        serialize_entity(data, node);
+
+        // the top node's name and transform belong to the instance itself
+        json prefab_node = prefab->nodes[i];
+        if (i == 0)
+        {
+            accessor["transform"] = data["transform"];
+
+            for (const char* key : { "name", "transform" })
             {
-                ModelLoader model_loader(str_to_primitive_type(mesh_name.c_str()));
-                model_loader.load_mesh(mesh);
+                data.erase(key);
+                prefab_node.erase(key);
             }
-            else
+        }
+
+        json delta = prefab_node_delta(data, prefab_node);
+        if (!delta.empty())
+            overrides[std::to_string(i)] = std::move(delta);
+    }
+
+    if (!overrides.empty())
+        accessor["overrides"] = std::move(overrides);
+}
+
+bool SceneSerializer::make_prefab(const std::string& name, const SceneNodePtr& top, Scene& scene)
+{
+    if (PrefabTable::exists(name))
+        return false;
+
+    std::vector<SceneNodePtr> nodes;
+    std::function<void(const SceneNodePtr&)> collect = [&](const SceneNodePtr& node)
+    {
+        nodes.push_back(node);
+        for (const auto& child : *node)
+            collect(child);
+    };
+    collect(top);
+
+    if (std::any_of(nodes.begin(), nodes.end(), [](const SceneNodePtr& node) { return node->entity()->is_prefab(); }))
+    {
+        warn("Prefabs can't contain other prefabs\n");
+        return false;
+    }
+
+    // written out the same way a scene's models are, nodes come out in the order they were collected
+    json definition = json::array();
+    int node_index = 0;
+    serialize_node(definition, node_index, top);
+
+    for (json& node : definition)
+        node.erase("id");
+
+    PrefabTable::add(name, std::move(definition));
+    std::shared_ptr<Prefab> prefab = PrefabTable::get(name);
+    if (!prefab)
+        return false;
+
+    build_prefab_templates(name, *prefab);
+
+    // the subtree turns into the first instance
+    uint32_t instance_id = top->entity()->get_id();
+    for (uint32_t i = 0; i < nodes.size(); ++i)
+    {
+        Entity& entity = *nodes[i]->entity();
+
+        bool instanced = entity.has_component<MeshComponent>() && entity.get_component<MeshComponent>().get_mesh()->is_instanced();
+        share_template_components(entity, *prefab->templates[i], json::object(), i == 0, instanced);
+
+        entity.set_prefab(name, i, instance_id, prefab->templates[i]);
+        entity.mark_dirty();
+    }
+
+    scene.m_journal.record_prefab(name);
+    return true;
+}
+
+SceneNodePtr SceneSerializer::place_prefab(const std::string& prefab, const std::string& name, Scene& scene)
+{
+    if (!PrefabTable::exists(prefab))
+        return nullptr;
+
+    json instance;
+    instance["prefab"] = prefab;
+    Transform{}.serialize(instance);
+
+    auto top = std::make_shared<SceneNode>(std::make_shared<Entity>());
+    top->entity()->set_name(name);
+    top->entity()->set_id(scene.m_next_entity_id++);
+    scene.root->add_child(top);
+
+    instantiate_prefab(top, instance, scene);
+
+    // new, so it goes in the next incremental save
+    top->entity()->mark_dirty();
+    return top;
+}
+
+void SceneSerializer::load_binary(const SceneView& view, Scene& scene, std::shared_ptr<Camera>& camera, std::unique_ptr<Skybox>& sky_box, SceneNodePtr& root)
+{
+    const SceneHeader& header = view.header();
+
+    camera->set_pos(glm::vec3(header.camera_position[0], header.camera_position[1], header.camera_position[2]));
+    camera->set_forward(glm::vec3(header.camera_forward[0], header.camera_forward[1], header.camera_forward[2]));
+    scene.set_background_colour({ header.background_colour[0], header.background_colour[1], header.background_colour[2], header.background_colour[3] });
+
+    if (header.skybox_path != SCENE_NONE)
+        sky_box = std::make_unique<Skybox>(view.string(header.skybox_path), (ImageFormat)header.skybox_format);
+
+    // parents are stored before their children so every parent already exists when a node is attached
+    std::vector<SceneNodePtr> nodes(header.node_count);
+    for (uint32_t i = 0; i < header.node_count; ++i)
+    {
+        nodes[i] = load_binary_node(view, i, scene);
+
+        uint32_t parent = view.node(i).parent;
+        (parent == SCENE_NONE ? root : nodes[parent])->add_child(nodes[i]);
+    }
+}
+
+SceneNodePtr SceneSerializer::load_binary_node(const SceneView& view, uint32_t index, Scene& scene)
+{
+    const SceneNodeRecord& record = view.node(index);
+
+    Entity entity;
+    entity.set_name(view.string(record.name));
+    entity.set_id(record.id);
+    scene.m_next_entity_id = std::max(scene.m_next_entity_id, record.id + 1);
+
+    Transform transform{};
+    if (const auto* blob = view.blob<TransformBlob>(record.transform))
+    {
+        transform.translate({ blob->translate[0], blob->translate[1], blob->translate[2] });
+        transform.rotate(blob->rotation[0], { blob->rotation[1], blob->rotation[2], blob->rotation[3] });
+        transform.scale(blob->scale);
+    }
+
+    transform.recalculate_transform();
+    glm::mat4 model_matrix = transform.get_transform();
+    glm::vec3 position = transform.get_position();
+    entity.add_component(std::move(transform));
+
+    if (const auto* blob = view.blob<LightBlob>(record.light))
+    {
+        glm::vec4 colour(blob->colour[0], blob->colour[1], blob->colour[2], blob->colour[3]);
+
+        if (blob->type == SceneLightType::Point)
+        {
+            PointLight pl;
+            pl.set_colour(colour);
+            pl.set_range(blob->range);
+            pl.set_brightness(blob->brightness);
+
+            if (blob->cast_shadow)
+                pl.cast_shadow();
+
+            entity.add_component(std::move(pl));
+        }
+        else
+        {
+            DirectionalLight dl;
+            dl.set_colour(colour);
+            dl.set_direction({ blob->direction[0], blob->direction[1], blob->direction[2] });
+            dl.set_brightness(blob->brightness);
+
+            if (blob->cast_shadow)
             {
-                ModelLoader model_loader(mesh_name.c_str());
-                model_loader.load_mesh(mesh);
+                dl.cast_shadow();
+                dl.shadow_init(position);
             }
 
-            MeshTable::add(mesh_name, std::move(mesh));
+            entity.add_component(std::move(dl));
         }
+    }
 
-        mesh_component.m_use_scale_outline = mesh_accessor["use_scale_outline"];
-        mesh_component.m_outlining_factor = mesh_accessor["outlining_factor"];
+    if (const auto* blob = view.blob<MeshBlob>(record.mesh))
+    {
+        MeshComponent mesh_component;
+        mesh_component.m_mesh_type = view.string(view.asset(blob->asset).type);
+        mesh_component.m_use_scale_outline = blob->use_scale_outline != 0;
+        mesh_component.m_outlining_factor = blob->outlining_factor;
 
-        mesh_component.set_mesh(MeshTable::get(mesh_name));
-        mesh_component.set_mesh_name(mesh_name);
+        std::string mesh_name = view.asset_path(blob->asset);
+        add_mesh(entity, std::move(mesh_component), mesh_name, blob->instanced != 0, model_matrix, &scene);
 
-        if(mesh_accessor["instanced"])
+        if (const auto* material = view.blob<MaterialBlob>(record.material))
         {
-            scene.instanced_meshes[mesh_name].push_back(model_matrix);
-            mesh_component.m_instance_id = (int)scene.instanced_meshes[mesh_name].size() - 1;
+            std::string textures[4];
+            for (int i = 0; i < 4; ++i)
+                textures[i] = view.asset_path(material->textures[i]);
+
+            MaterialInfo info;
+            info.texturing_mode = (TexturingMode)material->texturing_mode;
+            info.colour = { material->colour[0], material->colour[1], material->colour[2], material->colour[3] };
+            info.metallic = material->metallic;
+            info.roughness = material->roughness;
+            info.shader = view.string(material->shader);
+            info.textures = textures;
+
+            add_material(entity, info, mesh_name, blob->instanced != 0);
         }
+    }
 
-        entity.add_component(std::move(mesh_component));
+    entity.clear_dirty();
+    return std::make_shared<SceneNode>(std::make_unique<Entity>(std::move(entity)));
+}
 
-        if(!model["material"].is_null())
+void SceneSerializer::add_mesh(Entity& entity, MeshComponent&& mesh_component, const std::string& mesh_name, bool instanced, const glm::mat4& model_matrix, Scene* scene)
+{
+    if(!MeshTable::exists(mesh_name))
+    {
+        Mesh mesh;
+        bool stream_mesh = false;
+
+        if (mesh_component.m_mesh_type == "primitive")
+        {
+            ModelLoader model_loader(str_to_primitive_type(mesh_name.c_str()));
+            model_loader.load_mesh(mesh);
+        }
+        else if (AsyncLoader::is_enabled())
+        {
+            // stand in with a cube until the worker has the real thing
+            mesh.load_primitive(PrimitiveTypes::Cube);
+            stream_mesh = true;
+        }
+        else
         {
-            json material_accessor = model["material"];
-            auto texturing_mode = (TexturingMode)material_accessor["texturing_mode"];
+            ModelLoader model_loader(mesh_name.c_str());
+            model_loader.load_mesh(mesh);
+        }
 
-            // if the mesh is being instanced then make one material that can be shared by all those instances
-            std::string mat_name = (mesh_accessor["instanced"]) ? mesh_name : entity.get_name();
+        MeshTable::add(mesh_name, std::move(mesh));
 
-            if(!MaterialTable::exists(mat_name))
-            {
-                Material material;
-
-                material.set_colour({ material_accessor["properties"]["colour"][0], material_accessor["properties"]["colour"][1], material_accessor["properties"]["colour"][2], material_accessor["properties"]["colour"][3]});
-                material.set_metallic_property(material_accessor["properties"]["metallic_property"]);
-                material.set_roughness(material_accessor["properties"]["roughness"]);
-
-                if(texturing_mode == TexturingMode::MODEL_DEFAULT)
-                {
-                    ModelLoader model_loader(mesh_name.c_str());
-                    model_loader.load_material(material);
-                }
-                else
-                {
-                    std::string base_colour_location = (material_accessor["textures"]["base_colour"].empty()) ? "../resources/textures/white_on_white.jpeg" : material_accessor["textures"]["base_colour"];
-
-                    std::string textures[] = {
-                            base_colour_location,
-                            material_accessor["textures"]["specular"],
-                            material_accessor["textures"]["normal_map"],
-                            material_accessor["textures"]["occlusion"]
-                    };
-
-                    material.load(textures);
-                }
-
-                // FIXME
-                if(mesh_accessor["instanced"])
-                    material.set_shader(ShaderTable::get("inst_default"));
-                else
-                    material.set_shader(ShaderTable::get(material_accessor["shader"]));
-
-                MaterialTable::add(mat_name, std::move(material));
-            }
+        if (stream_mesh)
+            AsyncLoader::request_mesh(mesh_name, MeshTable::get(mesh_name));
+    }
 
-            MaterialComponent material_component(MaterialTable::get(mat_name));
-            material_component.set_texturing_mode(texturing_mode);
+    mesh_component.set_mesh(MeshTable::get(mesh_name));
+    mesh_component.set_mesh_name(mesh_name);
 
-            entity.add_component(std::move(material_component));
-        }
+    // prefab templates don't take up an instance slot
+    if(instanced && scene)
+    {
+        scene->instanced_meshes[mesh_name].push_back(model_matrix);
+        mesh_component.m_instance_id = (int)scene->instanced_meshes[mesh_name].size() - 1;
     }
 
-	SceneNodePtr current_node = std::make_shared<SceneNode>(std::make_unique<Entity>(std::move(entity)));
+    entity.add_component(std::move(mesh_component));
+}
 
-	int num_children = accessor[model_index].value("child_count", 0);
+void SceneSerializer::add_material(Entity& entity, const MaterialInfo& info, const std::string& mesh_name, bool instanced, const std::string& material_name)
+{
+    // if the mesh is being instanced then make one material that can be shared by all those instances
+    std::string mat_name = instanced ? mesh_name : material_name.empty() ? entity.get_name() : material_name;
 
-	for (int i = 0; i < num_children; ++i)
-	{
-		int child_index = accessor[model_index]["children"][i];
-        current_node->add_child(load_model(accessor, child_index, num_models_checked, scene));
-	}
+    if(!MaterialTable::exists(mat_name))
+    {
+        Material material;
+
+        material.set_colour(info.colour);
+        material.set_metallic_property(info.metallic);
+        material.set_roughness(info.roughness);
+
+        bool stream_textures = false;
+
+        if(info.texturing_mode == TexturingMode::MODEL_DEFAULT)
+        {
+            if (AsyncLoader::is_enabled())
+            {
+                stream_textures = true;
+            }
+            else
+            {
+                ModelLoader model_loader(mesh_name.c_str());
+                model_loader.load_material(material);
+            }
+        }
+        else
+        {
+            std::string textures[] = {
+                    info.textures[0].empty() ? "../resources/textures/white_on_white.jpeg" : info.textures[0],
+                    info.textures[1],
+                    info.textures[2],
+                    info.textures[3]
+            };
+
+            material.load(textures);
+        }
+
+        // FIXME
+        if(instanced)
+            material.set_shader(ShaderTable::get("default", { "INSTANCED" }));
+        else
+            material.set_shader(ShaderTable::get(info.shader));
 
-	++num_models_checked;
-	return current_node;
-}
\ No newline at end of file
+        MaterialTable::add(mat_name, std::move(material));
+
+        if (stream_textures)
+            AsyncLoader::request_model_textures(mesh_name, MaterialTable::get(mat_name));
+    }
+
+    MaterialComponent material_component(MaterialTable::get(mat_name));
+    material_component.set_texturing_mode(info.texturing_mode);
+
+    entity.add_component(std::move(material_component));
+}
@@ -1,17 +1,21 @@
 #pragma once
 
 #include "components/Fwd.h"
+#include "components/MaterialComponent.h"
 #include "Material.h"
 #include "SceneNode.h"
 
 #include <memory>
 #include <vector>
+#include <glm/mat4x4.hpp>
 #include <nlohmann/json_fwd.hpp>
 
 class Camera;
 class Skybox;
 class Scene;
-
+class SceneView;
+class Entity;
+struct Prefab;
 
 class SceneSerializer
 {
@@ -19,10 +23,58 @@ public:
 	static void open(const char* scene_name, Scene& scene, std::shared_ptr<Camera>& camera, std::unique_ptr<Skybox>& sky_box, SceneNodePtr entities);
 	static void save(const char* scene_name, const Scene& scene, const std::shared_ptr<Camera>& camera, const std::unique_ptr<Skybox>& sky_box, const SceneNodePtr& root);
 
+	// appends only what changed since the last save to the scene's journal, false for binary scenes
+	static bool save_incremental(Scene& scene);
+
+	// turns a subtree into the first instance of a new prefab, false if the name is taken or the subtree already holds one
+	static bool make_prefab(const std::string& name, const SceneNodePtr& top, Scene& scene);
+
+	// adds an instance of the prefab under the scene root
+	static SceneNodePtr place_prefab(const std::string& prefab, const std::string& name, Scene& scene);
+
 private:
+	static constexpr uint32_t LOAD_TRANSFORM = 1;
+	static constexpr uint32_t LOAD_LIGHT = 2;
+	static constexpr uint32_t LOAD_MESH = 4;
+	static constexpr uint32_t LOAD_MATERIAL = 8;
+	static constexpr uint32_t LOAD_ALL = LOAD_TRANSFORM | LOAD_LIGHT | LOAD_MESH | LOAD_MATERIAL;
+
 	static void load_skybox(const nlohmann::json& accessor, std::unique_ptr<Skybox>& sky_box);
-	static void load_models(const nlohmann::json& accessor, unsigned int model_count, SceneNodePtr& root, Scene& scene);
-	static SceneNodePtr load_model(const nlohmann::json& accessor, int model_index, int& num_models_checked, Scene& scene);
+	static SceneNodePtr load_entity(nlohmann::json& model, size_t index, Scene& scene);
+
+	// prefab templates are loaded without a scene, they never get drawn
+	// prefab instances only load what they can't share with the template
+	static void load_components(Entity& entity, const nlohmann::json& model, Scene* scene, const std::string& material_name, uint32_t components = LOAD_ALL);
+	static nlohmann::json serialize_settings(const Scene& scene, const std::shared_ptr<Camera>& camera, const std::unique_ptr<Skybox>& sky_box);
+	static void serialize_entity(nlohmann::json& accessor, const SceneNodePtr& scene_node);
 	static void serialize_node(nlohmann::json& accessor, int& node_index, const SceneNodePtr& scene_node);
+	static void append_dirty_nodes(std::string& records, const SceneNodePtr& parent, uint32_t parent_id);
+
+	static void build_prefab_templates(const std::string& name, Prefab& prefab);
+	static void instantiate_prefab(const SceneNodePtr& top, const nlohmann::json& instance, Scene& scene);
+
+	// the instance's nodes in prefab order, false if its structure no longer matches the prefab
+	static bool collect_instance(const SceneNodePtr& top, std::vector<SceneNodePtr>& nodes);
+	static void serialize_instance(nlohmann::json& accessor, const std::vector<SceneNodePtr>& nodes);
+
+    // binary scenes are read straight out of the mapped file
+    static void load_binary(const SceneView& view, Scene& scene, std::shared_ptr<Camera>& camera, std::unique_ptr<Skybox>& sky_box, SceneNodePtr& root);
+    static SceneNodePtr load_binary_node(const SceneView& view, uint32_t index, Scene& scene);
+
+    // shared by both formats
+    struct MaterialInfo
+    {
+        TexturingMode texturing_mode;
+        glm::vec4 colour;
+        float metallic;
+        float roughness;
+        std::string shader;
+        const std::string* textures; // base colour, specular, normal map, occlusion
+    };
+
+    static void add_mesh(Entity& entity, MeshComponent&& mesh_component, const std::string& mesh_name, bool instanced, const glm::mat4& model_matrix, Scene* scene);
+
+    // the material is shared under material_name, the entity's name if it's empty
+    static void add_material(Entity& entity, const MaterialInfo& info, const std::string& mesh_name, bool instanced, const std::string& material_name = {});
 };
 
@@ -13,6 +13,7 @@ public:
     void bind() const;
     void unbind() const;
     [[nodiscard]] unsigned get_indices() const { return m_indices_count; }
+    [[nodiscard]] bool is_ready() const { return m_skybox_shader && m_skybox_shader->is_ready(); }
 	[[nodiscard]] const std::string& get_resource_path() const { return m_path; }
     [[nodiscard]] const ImageFormat& get_image_format() const { return m_img_fmt; }
 